@@ -0,0 +1,90 @@
+#!/usr/bin/python3
+#
+# This is a script that measures how long synfig takes to load big documents.
+# A synthetic document with many animated layers is written as .sif and then
+# converted by synfig to the compressed (.sifz) and binary (.sifb) formats.  Each file is loaded several times
+# by `synfig <file> --canvas-info w`, which loads the document and exits
+# without rendering, so the difference between the formats is the load time.
+# To properly run this:
+#
+# 1. This script needs to be placed in the root of the build directory, and run
+#    from that directory (like `test_render_all_perf.py`)
+# 2. Optionally pass the count of layers and waypoints, e.g.
+#    `./test_load_perf.py --layers 20000 --waypoints 8`
+# 3. Don't have any applications running at the same time.  It can mess with the
+#    performance measurements.
+
+
+
+import argparse
+import os
+import subprocess
+import tempfile
+import time
+
+SIF_EXE = 'output/bin/synfig'
+NUM_PASSES = 5
+FORMATS = ['.sif', '.sifz', '.sifb']
+
+
+def write_document(filename, layers, waypoints):
+    with open(filename, 'w') as f:
+        f.write('<?xml version="1.0" encoding="UTF-8"?>\n'
+                '<canvas version="1.2" width="480" height="270" xres="2834.645669" yres="2834.645669"'
+                ' gamma-r="1.0" gamma-g="1.0" gamma-b="1.0" view-box="-4 2.25 4 -2.25" antialias="1"'
+                ' fps="24" begin-time="0f" end-time="5s" bgcolor="0.5 0.5 0.5 1">\n'
+                '  <name>Load benchmark</name>\n')
+        for i in range(0, layers):
+            f.write('  <layer type="solid_color" active="true" exclude_from_rendering="false" version="0.1" desc="Layer %i">\n'
+                    '    <param name="z_depth"><real value="0.0000000000"/></param>\n'
+                    '    <param name="amount"><real value="1.0000000000"/></param>\n'
+                    '    <param name="blend_method"><integer value="0"/></param>\n'
+                    '    <param name="color">\n'
+                    '      <animated type="color">\n' % i)
+            for j in range(0, waypoints):
+                c = ((i + j) % 100)/100.0
+                f.write('        <waypoint time="%if" before="clamped" after="clamped">'
+                        '<color><r>%f</r><g>%f</g><b>0.5</b><a>1.0</a></color></waypoint>\n' % (2*j, c, 1.0 - c))
+            f.write('      </animated>\n'
+                    '    </param>\n'
+                    '  </layer>\n')
+        f.write('</canvas>\n')
+
+
+def load_time(filename):
+    st = time.time()
+    subprocess.run([SIF_EXE, filename, '--canvas-info', 'w', '--quiet'],
+                   stdout=subprocess.DEVNULL, check=True)
+    return time.time() - st
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compare load times of synfig document formats')
+    parser.add_argument('--layers', type=int, default=2000, help='count of layers (Default: 2000)')
+    parser.add_argument('--waypoints', type=int, default=8, help='count of waypoints per layer (Default: 8)')
+    args = parser.parse_args()
+
+    directory = tempfile.mkdtemp()
+    source = os.path.join(directory, 'load_perf.sif')
+    write_document(source, args.layers, args.waypoints)
+
+    files = []
+    for extension in FORMATS:
+        filename = os.path.join(directory, 'load_perf' + extension)
+        if filename != source:
+            subprocess.run([SIF_EXE, source, '-t', 'sif', '-o', filename, '--quiet'], check=True)
+        files.append(filename)
+
+    print('%i layers, %i waypoints' % (args.layers, args.waypoints))
+    for filename in files:
+        times = [load_time(filename) for _ in range(0, NUM_PASSES)]
+        print('%-6s  size %10i bytes  ::  best %.4f sec  average %.4f sec' % (
+            os.path.splitext(filename)[1], os.path.getsize(filename), min(times), sum(times)/len(times)))
+
+    for filename in files:
+        os.remove(filename)
+    os.rmdir(directory)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,146 @@
+#!/usr/bin/python3
+#
+# This is a script that sends render jobs to synfig running in the server mode
+# (`synfig --serve <path>`), and compares the time of each job with the time of
+# a separate `synfig` process per file.  The server keeps the modules and the
+# loaded documents in memory, so repeated jobs skip the startup and loading.
+# To properly run this:
+#
+# 1. This script needs to be placed in the root of the build directory, and run
+#    from that directory (like `test_render_all_perf.py`)
+# 2. Pass the .sif files to render as the arguments, e.g.
+#    `./test_render_server.py synfig-tests/export/lottie/*.sif`
+#
+# The server is started by the script on a Unix socket, or on the standard input
+# and output with `--stdio` (e.g. on Windows).  Replies of the server are printed
+# as they come, with `--verbose`.
+
+
+
+import argparse
+import json
+import os
+import socket
+import subprocess
+import tempfile
+import time
+
+SIF_EXE = 'output/bin/synfig'
+NUM_PASSES = 3
+
+
+class SocketConnection:
+    def __init__(self, path):
+        self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        self.sock.connect(path)
+        self.file = self.sock.makefile('rw', encoding='utf-8', newline='\n')
+
+    def send(self, request):
+        self.file.write(json.dumps(request) + '\n')
+        self.file.flush()
+
+    def receive(self):
+        return self.file.readline()
+
+    def close(self):
+        self.file.close()
+        self.sock.close()
+
+
+class StdioConnection:
+    def __init__(self, process):
+        self.process = process
+
+    def send(self, request):
+        self.process.stdin.write(json.dumps(request) + '\n')
+        self.process.stdin.flush()
+
+    def receive(self):
+        return self.process.stdout.readline()
+
+    def close(self):
+        pass
+
+
+def start_server(args):
+    if args.stdio:
+        process = subprocess.Popen(
+            [SIF_EXE, '--serve', '-', '--quiet'],
+            stdin=subprocess.PIPE, stdout=subprocess.PIPE,
+            universal_newlines=True
+        )
+        return process, lambda: StdioConnection(process)
+
+    path = os.path.join(tempfile.mkdtemp(), 'synfig.sock')
+    process = subprocess.Popen([SIF_EXE, '--serve', path, '--quiet'])
+
+    # Wait for the server to load the modules
+    for _ in range(0, 300):
+        if os.path.exists(path):
+            break
+        time.sleep(0.1)
+    return process, lambda: SocketConnection(path)
+
+
+def render(connection, request, verbose):
+    st = time.time()
+    connection.send(request)
+    while True:
+        line = connection.receive()
+        if not line:
+            raise RuntimeError('server closed the connection')
+        if verbose:
+            print('  ' + line.rstrip())
+        reply = json.loads(line)
+        if reply.get('status') == 'done':
+            return time.time() - st
+        if reply.get('status') == 'error':
+            raise RuntimeError(reply.get('message'))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compare render times of synfig in the server mode')
+    parser.add_argument('files', nargs='+', help='.sif files to render')
+    parser.add_argument('--target', default='null', help='target of the jobs (Default: null)')
+    parser.add_argument('--stdio', action='store_true', help='talk to the server by standard input and output')
+    parser.add_argument('--verbose', action='store_true', help='print replies of the server')
+    args = parser.parse_args()
+
+    process, connect = start_server(args)
+    connection = connect()
+
+    total_server_time = 0.0
+    total_process_time = 0.0
+    try:
+        for sif in args.files:
+            for i in range(0, NUM_PASSES):
+                request = {
+                    'id': '%s-%i' % (os.path.basename(sif), i + 1),
+                    'input-file': os.path.abspath(sif),
+                    'target': args.target,
+                }
+                if args.target == 'null':
+                    request['output-file'] = os.devnull
+                server_time = render(connection, request, args.verbose)
+                total_server_time += server_time
+
+                # The same job by a separate process
+                st = time.time()
+                subprocess.run([SIF_EXE, sif, '-t', args.target, '--quiet'], cwd=os.getcwd())
+                process_time = time.time() - st
+                total_process_time += process_time
+
+                print('%s [%02i]  ::  server %.4f  process %.4f' % (sif, i + 1, server_time, process_time))
+
+        connection.send({'command': 'quit'})
+        connection.receive()
+    finally:
+        connection.close()
+        process.wait(timeout=60)
+
+    print('Total Server Time: %.4f sec' % total_server_time)
+    print('Total Process Time: %.4f sec' % total_process_time)
+
+
+if __name__ == '__main__':
+    main()
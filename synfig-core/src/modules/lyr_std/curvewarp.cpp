@@ -74,108 +74,193 @@ struct CurveWarp::Internal
 
 	static constexpr double FAKE_TANGENT_STEP = 0.000001;
 	static constexpr double TOO_THIN = 0.01;
+	//! allowed error of the source position in fast mode, in pixels
+	static constexpr double FAST_TOLERANCE = 0.1;
 
 	Point transform(const Point& point) const;
 	void sync();
 
 private:
+	//! Piece of the bline between two vertices
+	struct Segment
+	{
+		hermite<Vector> curve;
+		float start_length; //!< length of the bline before the segment
+		Rect bounds;        //!< bounds of control points, the curve lies inside them
+	};
+
+	//! Node of the bounding volume hierarchy over consecutive segments
+	struct Node
+	{
+		Rect bounds;
+		int begin, end;
+		int children[2];
+	};
+
 	Vector perp_;
 	Real curve_length_;
+	std::vector<Segment> segments_;
+	std::vector<Node> nodes_;
 
-	float calculate_distance() const;
+	int build_node(int begin, int end);
+	float find_closest_on_segment(const Segment& segment, const Point& p, float& pos) const;
 	std::vector<BLinePoint>::const_iterator find_closest_to_bline(const Point& p, float& t, float& len, bool& extreme) const;
 };
 
-float
-CurveWarp::Internal::calculate_distance() const
+int
+CurveWarp::Internal::build_node(int begin, int end)
 {
-	std::vector<BLinePoint>::const_iterator iter, next;
-	std::vector<BLinePoint>::const_iterator end(bline.end());
+	int index = (int)nodes_.size();
+	nodes_.push_back(Node());
+
+	Node node;
+	node.begin = begin;
+	node.end = end;
+	if (end - begin == 1) {
+		node.bounds = segments_[begin].bounds;
+		node.children[0] = node.children[1] = -1;
+	} else {
+		int middle = (begin + end)/2;
+		node.children[0] = build_node(begin, middle);
+		node.children[1] = build_node(middle, end);
+		// union by corners, operator|= skips rects with zero area
+		const Rect &bounds0 = nodes_[node.children[0]].bounds;
+		const Rect &bounds1 = nodes_[node.children[1]].bounds;
+		node.bounds = Rect(bounds0.get_min(), bounds0.get_max());
+		node.bounds.expand(bounds1.get_min());
+		node.bounds.expand(bounds1.get_max());
+	}
 
-	float dist(0);
+	nodes_[index] = node;
+	return index;
+}
 
-	if (bline.empty()) return dist;
+static inline Real
+distance_squared(const Rect& rect, const Point& p)
+{
+	Real dx = std::max(Real(0), std::max(rect.minx - p[0], p[0] - rect.maxx));
+	Real dy = std::max(Real(0), std::max(rect.miny - p[1], p[1] - rect.maxy));
+	return dx*dx + dy*dy;
+}
 
-	next=bline.begin();
-	iter=next++;
+float
+CurveWarp::Internal::find_closest_on_segment(const Segment& segment, const Point& p, float& pos) const
+{
+	const hermite<Vector> &curve = segment.curve;
+	float dist(100000000000.0);
 
-	for(;next!=end;iter=next++)
+	if (fast)
 	{
-		// Setup the curve
-		hermite<Vector> curve(iter->get_vertex(), next->get_vertex(), iter->get_tangent2(), next->get_tangent1());
-		dist+=curve.length();
+		static const float samples[] = { 0.0001, 1.0/6, 2.0/6, 3.0/6, 4.0/6, 5.0/6, 0.9999 };
+		for(float x : samples) {
+			float thisdist = (curve(x) - p).mag_squared();
+			if (thisdist < dist) { dist = thisdist; pos = x; }
+		}
+	}
+	else
+	{
+		pos = curve.find_closest(fast, p);
+		dist = (curve(pos) - p).mag_squared();
 	}
-
 	return dist;
 }
 
 std::vector<BLinePoint>::const_iterator
 CurveWarp::Internal::find_closest_to_bline(const Point& p,float& t, float& len, bool& extreme) const
 {
-	std::vector<BLinePoint>::const_iterator iter,next,ret;
-	std::vector<BLinePoint>::const_iterator end(bline.end());
-
-	ret=bline.end();
-	float dist(100000000000.0);
-	next=bline.begin();
-	float best_pos(0), best_len(0);
-	hermite<Vector> best_curve;
-	iter=next++;
-	Point bp;
-	float total_len(0);
-	bool first = true, last = false;
 	extreme = false;
+	if (nodes_.empty()) {
+		t = 0;
+		len = 0;
+		return bline.end();
+	}
 
-	for(;next!=end;iter=next++)
-	{
-		// Setup the curve
-		hermite<Vector> curve(iter->get_vertex(), next->get_vertex(), iter->get_tangent2(), next->get_tangent1());
-		float thisdist(0);
-		last = false;
-
-		if (fast)
-		{
-#define POINT_CHECK(x) bp=curve(x);	thisdist=(bp-p).mag_squared(); if(thisdist<dist) { extreme = (first&&x<0.01); ret=iter; best_len = total_len; dist=thisdist; best_curve=curve; last=true; best_pos=x;}
-			POINT_CHECK(0.0001);  POINT_CHECK((1.0/6)); POINT_CHECK((2.0/6)); POINT_CHECK((3.0/6));
-			POINT_CHECK((4.0/6)); POINT_CHECK((5.0/6)); POINT_CHECK(0.9999);
+	// Only segments whose bounds are not farther than some curve point
+	// may contain the closest point. Take the nearest leaf to get such bound.
+	int leaf = 0;
+	while(nodes_[leaf].children[0] >= 0) {
+		const Node &node = nodes_[leaf];
+		leaf = distance_squared(nodes_[node.children[0]].bounds, p)
+		    <= distance_squared(nodes_[node.children[1]].bounds, p)
+		     ? node.children[0] : node.children[1];
+	}
+	float leaf_pos(0);
+	const int leaf_segment = nodes_[leaf].begin;
+	const float leaf_dist = find_closest_on_segment(segments_[leaf_segment], p, leaf_pos);
+	const Real bound = leaf_dist*(1 + 1e-5) + 1e-12;
+
+	// Visit remaining candidates in bline order, so ties are resolved
+	// in the same way as checking of all segments does.
+	int ret(-1);
+	float dist(100000000000.0);
+	float best_pos(0);
+	int stack[64];
+	int stack_size = 0;
+	stack[stack_size++] = 0;
+	while(stack_size) {
+		const Node &node = nodes_[stack[--stack_size]];
+		if (distance_squared(node.bounds, p) > bound)
+			continue;
+		if (node.children[0] >= 0) {
+			stack[stack_size++] = node.children[1];
+			stack[stack_size++] = node.children[0];
+			continue;
 		}
-		else
-		{
-			float pos = curve.find_closest(fast, p);
-			thisdist=(curve(pos)-p).mag_squared();
-			if(thisdist<dist)
-			{
-				extreme = (first && pos == 0);
-				ret=iter;
-				dist=thisdist;
-				best_pos = pos;
-				best_curve = curve;
-				best_len = total_len;
-				last = true;
-			}
+
+		float pos(leaf_pos);
+		float thisdist(leaf_dist);
+		if (node.begin != leaf_segment)
+			thisdist = find_closest_on_segment(segments_[node.begin], p, pos);
+		if (thisdist < dist) {
+			ret = node.begin;
+			dist = thisdist;
+			best_pos = pos;
 		}
-		total_len += curve.length();
-		first = false;
 	}
 
+	const Segment &best = segments_[ret];
+	const bool first = ret == 0;
+	const bool last = ret + 1 == (int)segments_.size();
+
 	t = best_pos;
 	if (fast)
 	{
-		len = best_len + best_curve.find_distance(0,best_curve.find_closest(fast, p));
+		extreme = first && best_pos < 0.01;
+		len = best.start_length + best.curve.find_distance(0,best.curve.find_closest(fast, p));
 		if (last && t > .99) extreme = true;
 	}
 	else
 	{
-		len = best_len + best_curve.find_distance(0,best_pos);
+		extreme = first && best_pos == 0;
+		len = best.start_length + best.curve.find_distance(0,best_pos);
 		if (last && t == 1) extreme = true;
 	}
-	return ret;
+	return bline.begin() + ret;
 }
 
 void
 CurveWarp::Internal::sync()
 {
-	curve_length_ = calculate_distance();
+	// flatten the bline once, every transformed point looks it up
+	segments_.clear();
+	nodes_.clear();
+
+	float total_len(0);
+	for(size_t i = 1; i < bline.size(); ++i)
+	{
+		Segment segment;
+		segment.curve = hermite<Vector>(bline[i-1].get_vertex(), bline[i].get_vertex(), bline[i-1].get_tangent2(), bline[i].get_tangent1());
+		segment.start_length = total_len;
+		segment.bounds = Rect(segment.curve[0]);
+		for(int j = 1; j < 4; ++j)
+			segment.bounds.expand(segment.curve[j]);
+		segments_.push_back(segment);
+		total_len += segment.curve.length();
+	}
+	if (!segments_.empty())
+		build_node(0, (int)segments_.size());
+
+	curve_length_ = total_len;
 	perp_ = (end_point - start_point).perp().norm();
 }
 
@@ -555,6 +640,8 @@ CurveWarp::build_rendering_task_vfunc(Context context) const
 
 	TaskCurveWarp::Handle task_curvewarp(new TaskCurveWarp());
 	task_curvewarp->internal = *internal;
+	if (internal->fast)
+		task_curvewarp->tolerance = Internal::FAST_TOLERANCE;
 
 	task_curvewarp->sub_task() = task;
 
@@ -50,6 +50,7 @@
 #include <synfig/canvas.h>
 #include <synfig/canvasfilenaming.h>
 #include <synfig/filesystem.h>
+#include <synfig/importer.h>
 
 #include <synfig/rendering/software/surfacesw.h>
 
@@ -75,7 +76,10 @@ SYNFIG_LAYER_SET_VERSION(Import,"0.1");
 
 Import::Import():
 	param_filename(ValueBase(String())),
-	param_time_offset(ValueBase(Time(0)))
+	param_time_offset(ValueBase(Time(0))),
+	proxy_level(),
+	full_width(),
+	full_height()
 {
 	SET_INTERPOLATION_DEFAULTS();
 	SET_STATIC_DEFAULTS();
@@ -170,6 +174,9 @@ Import::set_param(const String & param, const ValueBase &value)
 			return false;
 		rendering_surface = new rendering::SurfaceResource(surface);
 		importer=newimporter;
+		proxy_level = 0;
+		full_width = surface->get_width();
+		full_height = surface->get_height();
 		param_filename.set(filename);
 
 		return true;
@@ -186,6 +193,10 @@ Import::get_param(const String & param)const
 	EXPORT_VALUE(param_time_offset);
 	EXPORT_VALUE(param_filename);
 
+	// the size of the imported file, not of its proxy
+	if (proxy_level && !trimmed && (param == "_width" || param == "_height"))
+		return ValueBase(param == "_width" ? full_width : full_height);
+
 	EXPORT_NAME();
 	EXPORT_VERSION();
 
@@ -220,18 +231,38 @@ Import::set_time_vfunc(IndependentContext context, Time time)const
 	context.set_time(time);
 }
 
+int
+Import::get_proxy_level()const
+{
+	// painted surface must stay as is
+	if (is_surface_modified())
+		return proxy_level;
+
+	if (!Importer::ProxyScope::is_active() || full_width <= 0)
+		return 0;
+
+	// count of pixels across the layer in the view, with transformations of parent groups
+	Matrix matrix = Importer::ProxyScope::get_transformation();
+	Point tl = param_tl.get(Point());
+	Point br = param_br.get(Point());
+	Real view_width = (matrix.get_transformed(Point(br[0], tl[1])) - matrix.get_transformed(tl)).mag();
+	return Importer::get_proxy_level(full_width, view_width);
+}
+
 void
 Import::load_resources_vfunc(IndependentContext context, Time time)const
 {
 	Time time_offset=param_time_offset.get(Time());
-	if(get_amount() && importer && importer->is_animated()) {
-		rendering::Surface::Handle surface = importer->get_frame(get_canvas()->rend_desc(), time+time_offset);
+	int level = get_proxy_level();
+	if(get_amount() && importer && (importer->is_animated() || level != proxy_level)) {
+		rendering::Surface::Handle surface = importer->get_frame(get_canvas()->rend_desc(), time+time_offset, level);
 		if (!surface) {
 			synfig::error(_("Couldn't load resources: couldn't get frame at %s"), (time + time_offset).get_string().c_str());
 			rendering_surface = nullptr;
 			return;
 		}
 		rendering_surface = new rendering::SurfaceResource(surface);
+		proxy_level = level;
 	}
 	context.load_resources(time);
 }
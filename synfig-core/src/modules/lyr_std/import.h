@@ -62,6 +62,14 @@ private:
 	String independent_filename;
 	Importer::Handle importer;
 
+	//! proxy level of the loaded surface, and the size of the full frame
+	mutable int proxy_level;
+	mutable int full_width;
+	mutable int full_height;
+
+	//! chooses the proxy level for the size of the layer in the view of Importer::ProxyScope
+	int get_proxy_level()const;
+
 protected:
 	Import();
 
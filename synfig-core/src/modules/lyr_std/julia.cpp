@@ -35,6 +35,8 @@
 
 #include "julia.h"
 
+#include <algorithm>
+
 #include <synfig/localization.h>
 
 #include <synfig/string.h>
@@ -44,6 +46,8 @@
 #include <synfig/renddesc.h>
 #include <synfig/value.h>
 
+#include <synfig/rendering/software/task/taskpaintpixelsw.h>
+
 #endif
 
 using namespace synfig;
@@ -96,6 +100,169 @@ color_neg_flip(Color &color)
 	}
 }
 
+namespace {
+
+class TaskJulia: public rendering::Task
+{
+public:
+	typedef etl::handle<TaskJulia> Handle;
+	static Token token;
+	virtual Token::Handle get_token() const { return token.handle(); }
+
+	Color icolor;
+	Color ocolor;
+	Angle color_shift;
+	int iterations;
+	Point seed;
+	bool shade_inside;
+	bool solid_inside;
+	bool invert_inside;
+	bool color_inside;
+	bool shade_outside;
+	bool solid_outside;
+	bool invert_outside;
+	bool color_outside;
+	bool color_cycle;
+	bool smooth_outside;
+	bool broken;
+
+	TaskJulia():
+		iterations(),
+		shade_inside(), solid_inside(), invert_inside(), color_inside(),
+		shade_outside(), solid_outside(), invert_outside(), color_outside(),
+		color_cycle(), smooth_outside(), broken() { }
+};
+
+
+//! Iterates several points at once. Each lane keeps its own state and
+//! freezes it when the point escapes, so the result of every lane is
+//! exactly the same as for the scalar iteration in Julia::get_color().
+//! The loops over lanes have no dependencies and are left to the
+//! compiler's auto-vectorizer.
+class TaskJuliaSW: public TaskJulia, public rendering::TaskPaintPixelSW
+{
+public:
+	typedef etl::handle<TaskJuliaSW> Handle;
+	static Token token;
+	virtual Token::Handle get_token() const override { return token.handle(); }
+
+	enum { LANES = 8 };
+
+	// Layers below are not rendered by this task (see Julia::build_rendering_task_vfunc()),
+	// so all colors which are taken from context are transparent
+	Color get_outside_color(int i, Real zr, Real zi, ColorReal mag) const
+	{
+		ColorReal depth;
+		if(smooth_outside)
+		{
+			depth= (ColorReal)i - log(log(sqrt(mag))) / LOG_OF_2;
+			if(depth<0) depth=0;
+		}
+		else
+			depth=static_cast<ColorReal>(i);
+
+		Color ret = solid_outside ? ocolor : Color::alpha();
+
+		if(invert_outside)
+			ret=~ret;
+
+		if(color_outside)
+			ret=ret.set_uv(zr,zi).clamped_negative();
+
+		if(color_cycle)
+			ret=ret.rotate_uv(color_shift.operator*(depth)).clamped_negative();
+
+		if(shade_outside)
+		{
+			ColorReal alpha=depth/static_cast<ColorReal>(iterations);
+			ret=(ocolor-ret)*alpha+ret;
+		}
+		return ret;
+	}
+
+	Color get_inside_color(Real zr, Real zi, ColorReal mag) const
+	{
+		Color ret = solid_inside ? icolor : Color::alpha();
+
+		if(invert_inside)
+			ret=~ret;
+
+		if(color_inside)
+			ret=ret.set_uv(zr,zi).clamped_negative();
+
+		if(shade_inside)
+			ret=(icolor-ret)*mag+ret;
+
+		return ret;
+	}
+
+	void get_colors_lanes(const Vector* p, Color* colors, int count) const
+	{
+		Real zr[LANES], zi[LANES];
+		ColorReal mag[LANES];
+		int escaped[LANES];
+
+		// unused lanes repeat the last point
+		for(int k = 0; k < LANES; ++k) {
+			const Vector &pos = p[std::min(k, count - 1)];
+			zr[k] = pos[0];
+			zi[k] = pos[1];
+			mag[k] = 0;
+			escaped[k] = -1;
+		}
+
+		const Real cr = seed[0];
+		const Real ci = seed[1];
+		int active = LANES;
+		for(int i = 0; i < iterations && active; ++i) {
+			for(int k = 0; k < LANES; ++k) {
+				Real nzr = zr[k]*zr[k] - zi[k]*zi[k] + cr;
+				Real nzi = zr[k]*zi[k]*2 + ci;
+				if (broken) nzr += nzi;
+				ColorReal nmag = nzr*nzr + nzi*nzi;
+
+				bool run = escaped[k] < 0;
+				zr[k] = run ? nzr : zr[k];
+				zi[k] = run ? nzi : zi[k];
+				mag[k] = run ? nmag : mag[k];
+
+				bool escape = run && nmag > 4;
+				escaped[k] = escape ? i : escaped[k];
+				active -= escape;
+			}
+		}
+
+		for(int k = 0; k < count; ++k)
+			colors[k] = escaped[k] < 0
+			          ? get_inside_color(zr[k], zi[k], mag[k])
+			          : get_outside_color(escaped[k], zr[k], zi[k], mag[k]);
+	}
+
+	void get_colors(const Vector* p, Color* colors, int count) const override
+	{
+		for(int i = 0; i < count; i += LANES)
+			get_colors_lanes(p + i, colors + i, std::min((int)LANES, count - i));
+	}
+
+	Color get_color(const Vector& p) const override
+	{
+		Color color;
+		get_colors_lanes(&p, &color, 1);
+		return color;
+	}
+
+	bool run(RunParams&) const override {
+		return run_task();
+	}
+};
+
+rendering::Task::Token TaskJulia::token(
+	DescAbstract<TaskJulia>("Julia") );
+rendering::Task::Token TaskJuliaSW::token(
+	DescReal<TaskJuliaSW, TaskJulia>("JuliaSW") );
+
+} // namespace
+
 /* === M E T H O D S ======================================================= */
 
 Julia::Julia():
@@ -340,6 +507,38 @@ Julia::get_color(Context context, const Point &pos)const
 	return ret;
 }
 
+rendering::Task::Handle
+Julia::build_rendering_task_vfunc(Context context) const
+{
+	bool solid_inside=param_solid_inside.get(bool());
+	bool solid_outside=param_solid_outside.get(bool());
+
+	// Colors of the set may be taken from the layers below,
+	// native task can be used only when there is nothing to take
+	if (!solid_inside || !solid_outside)
+		if (context.build_rendering_task())
+			return Layer::build_rendering_task_vfunc(context);
+
+	TaskJulia::Handle task(new TaskJulia());
+	task->icolor = param_icolor.get(Color());
+	task->ocolor = param_ocolor.get(Color());
+	task->color_shift = param_color_shift.get(Angle());
+	task->iterations = param_iterations.get(int());
+	task->seed = param_seed.get(Point());
+	task->shade_inside = param_shade_inside.get(bool());
+	task->solid_inside = solid_inside;
+	task->invert_inside = param_invert_inside.get(bool());
+	task->color_inside = param_color_inside.get(bool());
+	task->shade_outside = param_shade_outside.get(bool());
+	task->solid_outside = solid_outside;
+	task->invert_outside = param_invert_outside.get(bool());
+	task->color_outside = param_color_outside.get(bool());
+	task->color_cycle = param_color_cycle.get(bool());
+	task->smooth_outside = param_smooth_outside.get(bool());
+	task->broken = param_broken.get(bool());
+	return task;
+}
+
 Layer::Vocab
 Julia::get_param_vocab()const
 {
@@ -35,6 +35,8 @@
 
 #include "mandelbrot.h"
 
+#include <algorithm>
+
 #include <synfig/localization.h>
 
 #include <synfig/string.h>
@@ -43,6 +45,8 @@
 #include <synfig/renddesc.h>
 #include <synfig/value.h>
 
+#include <synfig/rendering/software/task/taskpaintpixelsw.h>
+
 #endif
 
 using namespace synfig;
@@ -95,6 +99,165 @@ color_neg_flip(Color &color)
 	}
 }
 
+namespace {
+
+class TaskMandelbrot: public rendering::Task
+{
+public:
+	typedef etl::handle<TaskMandelbrot> Handle;
+	static Token token;
+	virtual Token::Handle get_token() const { return token.handle(); }
+
+	int iterations;
+	Real bailout;
+	Real lp;
+	bool broken;
+
+	bool shade_inside;
+	bool solid_inside;
+	bool invert_inside;
+	Gradient gradient_inside;
+	Real gradient_offset_inside;
+	bool gradient_loop_inside;
+
+	bool shade_outside;
+	bool solid_outside;
+	bool invert_outside;
+	Gradient gradient_outside;
+	bool smooth_outside;
+	Real gradient_offset_outside;
+	Real gradient_scale_outside;
+
+	TaskMandelbrot():
+		iterations(), bailout(), lp(), broken(),
+		shade_inside(), solid_inside(), invert_inside(),
+		gradient_offset_inside(), gradient_loop_inside(),
+		shade_outside(), solid_outside(), invert_outside(),
+		smooth_outside(), gradient_offset_outside(), gradient_scale_outside() { }
+};
+
+
+//! Iterates several points at once, see TaskJuliaSW for details
+class TaskMandelbrotSW: public TaskMandelbrot, public rendering::TaskPaintPixelSW
+{
+public:
+	typedef etl::handle<TaskMandelbrotSW> Handle;
+	static Token token;
+	virtual Token::Handle get_token() const override { return token.handle(); }
+
+	enum { LANES = 8 };
+
+	// Layers below are not rendered by this task (see Mandelbrot::build_rendering_task_vfunc()),
+	// so all colors which are taken from context are transparent
+	Color get_outside_color(int i, ColorReal mag) const
+	{
+		ColorReal depth;
+		if(smooth_outside)
+		{
+			depth= (ColorReal)i + LOG_OF_2*lp - log(log(sqrt(mag))) / LOG_OF_2;
+			if(depth<0) depth=0;
+		}
+		else
+			depth=static_cast<ColorReal>(i);
+
+		ColorReal amount(depth/static_cast<ColorReal>(iterations));
+		amount=amount*gradient_scale_outside+gradient_offset_outside;
+		amount-=floor(amount);
+
+		if(solid_outside)
+			return gradient_outside(amount);
+
+		Color ret = Color::alpha();
+		if(invert_outside)
+			ret=~ret;
+		if(shade_outside)
+			ret=Color::blend(gradient_outside(amount), ret, 1.0);
+		return ret;
+	}
+
+	Color get_inside_color(ColorReal mag) const
+	{
+		ColorReal amount(std::fabs(mag+gradient_offset_inside));
+		if(gradient_loop_inside)
+			amount-=floor(amount);
+
+		if(solid_inside)
+			return gradient_inside(amount);
+
+		Color ret = Color::alpha();
+		if(invert_inside)
+			ret=~ret;
+		if(shade_inside)
+			ret=Color::blend(gradient_inside(amount), ret, 1.0);
+		return ret;
+	}
+
+	void get_colors_lanes(const Vector* p, Color* colors, int count) const
+	{
+		Real zr[LANES], zi[LANES], cr[LANES], ci[LANES];
+		ColorReal mag[LANES];
+		int escaped[LANES];
+
+		// unused lanes repeat the last point
+		for(int k = 0; k < LANES; ++k) {
+			const Vector &pos = p[std::min(k, count - 1)];
+			zr[k] = zi[k] = 0;
+			cr[k] = pos[0];
+			ci[k] = pos[1];
+			mag[k] = 0;
+			escaped[k] = -1;
+		}
+
+		int active = LANES;
+		for(int i = 0; i < iterations && active; ++i) {
+			for(int k = 0; k < LANES; ++k) {
+				Real nzr = zr[k]*zr[k] - zi[k]*zi[k] + cr[k];
+				if (broken) nzr += zi[k];
+				Real nzi = zr[k]*zi[k]*2 + ci[k];
+				ColorReal nmag = nzr*nzr + nzi*nzi;
+
+				bool run = escaped[k] < 0;
+				zr[k] = run ? nzr : zr[k];
+				zi[k] = run ? nzi : zi[k];
+				mag[k] = run ? nmag : mag[k];
+
+				bool escape = run && nmag > bailout;
+				escaped[k] = escape ? i : escaped[k];
+				active -= escape;
+			}
+		}
+
+		for(int k = 0; k < count; ++k)
+			colors[k] = escaped[k] < 0
+			          ? get_inside_color(mag[k])
+			          : get_outside_color(escaped[k], mag[k]);
+	}
+
+	void get_colors(const Vector* p, Color* colors, int count) const override
+	{
+		for(int i = 0; i < count; i += LANES)
+			get_colors_lanes(p + i, colors + i, std::min((int)LANES, count - i));
+	}
+
+	Color get_color(const Vector& p) const override
+	{
+		Color color;
+		get_colors_lanes(&p, &color, 1);
+		return color;
+	}
+
+	bool run(RunParams&) const override {
+		return run_task();
+	}
+};
+
+rendering::Task::Token TaskMandelbrot::token(
+	DescAbstract<TaskMandelbrot>("Mandelbrot") );
+rendering::Task::Token TaskMandelbrotSW::token(
+	DescReal<TaskMandelbrotSW, TaskMandelbrot>("MandelbrotSW") );
+
+} // namespace
+
 /* === M E T H O D S ======================================================= */
 
 Mandelbrot::Mandelbrot():
@@ -297,6 +460,41 @@ Mandelbrot::get_param_vocab()const
 	return ret;
 }
 
+rendering::Task::Handle
+Mandelbrot::build_rendering_task_vfunc(Context context) const
+{
+	bool solid_inside=param_solid_inside.get(bool());
+	bool solid_outside=param_solid_outside.get(bool());
+
+	// Colors of the set may be taken from the layers below,
+	// native task can be used only when there is nothing to take
+	if (!solid_inside || !solid_outside)
+		if (context.build_rendering_task())
+			return Layer::build_rendering_task_vfunc(context);
+
+	TaskMandelbrot::Handle task(new TaskMandelbrot());
+	task->iterations = param_iterations.get(int());
+	task->bailout = param_bailout.get(Real());
+	task->lp = lp;
+	task->broken = param_broken.get(bool());
+
+	task->shade_inside = param_shade_inside.get(bool());
+	task->solid_inside = solid_inside;
+	task->invert_inside = param_invert_inside.get(bool());
+	task->gradient_inside = param_gradient_inside.get(Gradient());
+	task->gradient_offset_inside = param_gradient_offset_inside.get(Real());
+	task->gradient_loop_inside = param_gradient_loop_inside.get(bool());
+
+	task->shade_outside = param_shade_outside.get(bool());
+	task->solid_outside = solid_outside;
+	task->invert_outside = param_invert_outside.get(bool());
+	task->gradient_outside = param_gradient_outside.get(Gradient());
+	task->smooth_outside = param_smooth_outside.get(bool());
+	task->gradient_offset_outside = param_gradient_offset_outside.get(Real());
+	task->gradient_scale_outside = param_gradient_scale_outside.get(Real());
+	return task;
+}
+
 RendDesc
 Mandelbrot::get_sub_renddesc_vfunc(const RendDesc &renddesc) const
 {
@@ -37,6 +37,7 @@
 #include "plant.h"
 
 #include <cmath> // std::ceil()
+#include <memory>
 
 #include <synfig/localization.h>
 #include <synfig/general.h>
@@ -46,6 +47,7 @@
 #include <synfig/context.h>
 #include <synfig/paramdesc.h>
 #include <synfig/renddesc.h>
+#include <synfig/rendering/software/task/tasksw.h>
 #include <synfig/string.h>
 #include <synfig/surface.h>
 #include <synfig/value.h>
@@ -78,6 +80,444 @@ SYNFIG_LAYER_SET_VERSION(Plant,"0.2");
 
 /* === P R O C E D U R E S ================================================= */
 
+namespace {
+
+//! Builds the particles of the plant
+class Generator
+{
+public:
+	const Plant::GeometryKey &key;
+	const Gradient &gradient;
+	Random random;
+	Plant::ParticleList &particle_list;
+	Rect &bounding_rect;
+
+	Generator(const Plant::GeometryKey &key, const Gradient &gradient, Plant::ParticleList &particle_list, Rect &bounding_rect):
+		key(key), gradient(gradient), particle_list(particle_list), bounding_rect(bounding_rect)
+	{
+		random.set_seed(key.seed);
+	}
+
+	void add(const Point &position, float gradient_pos)
+	{
+		particle_list.push_back(Plant::Particle(position, gradient_pos, gradient(gradient_pos)));
+		if (particle_list.size() % 1000000 == 0)
+			synfig::info("constructed %d million particles...", particle_list.size()/1000000);
+
+		bounding_rect.expand(position);
+	}
+
+	void branch(int n,int depth,float t, float stunt_growth, synfig::Point position,synfig::Vector vel)
+	{
+		const int splits=key.splits;
+		const Real step=key.step;
+		const Vector &gravity=key.gravity;
+		const Real drag=key.drag;
+		const Real random_factor=key.random_factor;
+
+		float next_split((1.0-t)/(splits-depth)+t/*+random_factor*random(40+depth,t*splits,0,0)/splits*/);
+		for(;t<next_split;t+=step)
+		{
+			vel[0]+=gravity[0]*step;
+			vel[1]+=gravity[1]*step;
+			vel*=(1.0-(drag)*step);
+			position[0]+=vel[0]*step;
+			position[1]+=vel[1]*step;
+
+			add(position, t);
+		}
+
+		if(t>=1.0-stunt_growth)return;
+
+		synfig::Real sin_v=synfig::Angle::cos(key.split_angle).get();
+		synfig::Real cos_v=synfig::Angle::sin(key.split_angle).get();
+
+		synfig::Vector velocity1(vel[0]*sin_v - vel[1]*cos_v + random_factor*random(Random::SMOOTH_COSINE, 30+n+depth, t*splits, 0.0f, 0.0f),
+								 vel[0]*cos_v + vel[1]*sin_v + random_factor*random(Random::SMOOTH_COSINE, 32+n+depth, t*splits, 0.0f, 0.0f));
+		synfig::Vector velocity2(vel[0]*sin_v + vel[1]*cos_v + random_factor*random(Random::SMOOTH_COSINE, 31+n+depth, t*splits, 0.0f, 0.0f),
+								-vel[0]*cos_v + vel[1]*sin_v + random_factor*random(Random::SMOOTH_COSINE, 33+n+depth, t*splits, 0.0f, 0.0f));
+
+		branch(n,depth+1,t,stunt_growth,position,velocity1);
+		branch(n,depth+1,t,stunt_growth,position,velocity2);
+	}
+
+	void build()
+	{
+		const std::vector<BLinePoint> &bline=key.bline;
+		const Real random_factor=key.random_factor;
+		const int sprouts=key.sprouts;
+		const Real velocity=key.velocity;
+		const Real perp_velocity=key.perp_velocity;
+		const int splits=key.splits;
+		const bool use_width=key.use_width;
+
+		// Bline must have at least 2 points in it
+		if(bline.size()<2)
+			return;
+
+		std::vector<synfig::BLinePoint>::const_iterator iter,next;
+
+		hermite<Vector> curve;
+
+		Real step(std::fabs(key.step));
+
+		int seg(0);
+
+		next=bline.begin();
+
+		if(key.bline_loop)	iter=--bline.end(); // iter is the last  bline in the list; next is the first  bline in the list
+		else				iter=next++;		// iter is the first bline in the list; next is the second bline in the list
+
+		// loop through the bline; seg counts the blines as we do so; stop before iter is the last bline in the list
+		for(;next!=bline.end();iter=next++,seg++)
+		{
+			float iterw=iter->get_width();	// the width value of the iter vertex
+			float nextw=next->get_width();	// the width value of the next vertex
+			float width;					// the width at an intermediate position
+			curve.p1()=iter->get_vertex();
+			curve.t1()=iter->get_tangent2();
+			curve.p2()=next->get_vertex();
+			curve.t2()=next->get_tangent1();
+			curve.sync();
+
+			Real f;
+
+			int i=0, branch_count = 0, steps = round_to_int(1.0/step);
+			if (steps < 1) steps = 1;
+			for(f=0.0;f<1.0;f+=step,i++)
+			{
+				Point point(curve(f));
+
+				add(point, 0);
+
+				Real stunt_growth(random_factor * (random(Random::SMOOTH_COSINE,i,f+seg,0.0f,0.0f)/2.0+0.5));
+				stunt_growth*=stunt_growth;
+
+				if((((i+1)*sprouts + steps/2) / steps) > branch_count) {
+					Vector branch_velocity(curve.derivative(f).norm()*velocity + curve.derivative(f).perp().norm()*perp_velocity);
+
+					if (std::isnan(branch_velocity[0]) || std::isnan(branch_velocity[1]))
+						continue;
+
+					branch_velocity[0] += random_factor * random(Random::SMOOTH_COSINE, 1, f*splits, 0.0f, 0.0f);
+					branch_velocity[1] += random_factor * random(Random::SMOOTH_COSINE, 2, f*splits, 0.0f, 0.0f);
+
+					if (use_width)
+					{
+						width = iterw+(nextw-iterw)*f; // calculate the width based on the current position
+
+						branch_velocity[0] *= width; // scale the velocity accordingly to the current width
+						branch_velocity[1] *= width;
+					}
+
+					branch_count++;
+					branch(i, 0, 0,		 // time
+						   stunt_growth, // stunt growth
+						   point, branch_velocity);
+				}
+			}
+		}
+	}
+};
+
+} // end of anonymous namespace
+
+//! Draws the particles as antialiased boxes, clipped by \a rect
+//! \param tl position of the pixel (0, 0) relatively to the origin of the particles
+//! \param pw width of the pixel
+//! \param ph height of the pixel
+static void
+draw_particles(
+	synfig::Surface &dest_surface,
+	const RectInt &rect,
+	const Plant::ParticleList &particle_list,
+	const Point &tl,
+	Real pw,
+	Real ph,
+	Real size,
+	bool reverse,
+	bool size_as_alpha )
+{
+	if (std::isinf(pw) || std::isinf(ph))
+		return;
+	
+	if (particle_list.begin() != particle_list.end())
+	{
+		Plant::ParticleList::const_iterator iter;
+		const Plant::Particle *particle;
+		
+		float radius(size*sqrt(1.0f/(std::fabs(pw)*std::fabs(ph))));
+		
+		int x1,y1,x2,y2;
+		
+		if (reverse)	iter = particle_list.end();
+		else			iter = particle_list.begin();
+		
+		while (true)
+		{
+			if (reverse)	particle = &(*(iter-1));
+			else			particle = &(*iter);
+			
+			float scaled_radius(radius);
+			Color color(particle->color);
+			if(size_as_alpha)
+			{
+				scaled_radius*=color.get_a();
+				color.set_a(1);
+			}
+			
+			// previously, radius was multiplied by sqrt(step)*12 only if
+			// the radius came out at less than 1 (pixel):
+			//   if (radius<=1.0f) radius*=sqrt(step)*12.0f;
+			// seems a little arbitrary - does it help?
+			
+			// calculate the box that this particle will be drawn as
+			float x1f=(particle->point[0]-tl[0])/pw-(scaled_radius*0.5);
+			float x2f=(particle->point[0]-tl[0])/pw+(scaled_radius*0.5);
+			float y1f=(particle->point[1]-tl[1])/ph-(scaled_radius*0.5);
+			float y2f=(particle->point[1]-tl[1])/ph+(scaled_radius*0.5);
+			const auto ceil_to_int = [](float num) -> int {
+				return static_cast<int>(std::ceil(num));
+			};
+			x1=ceil_to_int(x1f);
+			x2=ceil_to_int(x2f)-1;
+			y1=ceil_to_int(y1f);
+			y2=ceil_to_int(y2f)-1;
+			
+			// if the box isn't entirely off the rect, draw it
+			if(x1<=rect.maxx && y1<=rect.maxy && x2>=rect.minx && y2>=rect.miny)
+			{
+				float x1e=x1-x1f, x2e=x2f-x2, y1e=y1-y1f, y2e=y2f-y2;
+				// printf("x1e %.4f x2e %.4f y1e %.4f y2e %.4f\n", x1e, x2e, y1e, y2e);
+				
+				// adjust the box so it's entirely inside the rect
+				if(x1<=rect.minx) { x1=rect.minx; x1e=0; }
+				if(y1<=rect.miny) { y1=rect.miny; y1e=0; }
+				if(x2>=rect.maxx) { x2=rect.maxx; x2e=0; }
+				if(y2>=rect.maxy) { y2=rect.maxy; y2e=0; }
+				
+				int w(x2-x1), h(y2-y1);
+				
+				Surface::alpha_pen surface_pen(dest_surface.get_pen(x1,y1),1.0f);
+				if(w>0 && h>0)
+					dest_surface.fill(color,surface_pen,w,h);
+				
+				/* the rectangle doesn't cross any vertical pixel boundaries so we don't
+				 * need to draw any top or bottom edges
+				 */
+				if(x2<x1)
+				{
+					// case 1 - a single pixel
+					if(y2<y1)
+					{
+						surface_pen.move_to(x2,y2);
+						surface_pen.set_alpha((x2f-x1f)*(y2f-y1f));
+						surface_pen.put_value(color);
+					}
+					// case 2 - a single vertical column of pixels
+					else
+					{
+						surface_pen.move_to(x2,y1-1);
+						if (y1e!=0)	// maybe draw top pixel
+						{
+							surface_pen.set_alpha(y1e*(x2f-x1f));
+							surface_pen.put_value(color);
+						}
+						surface_pen.inc_y();
+						surface_pen.set_alpha(x2f-x1f);
+						for(int i=y1; i<y2; i++) // maybe draw pixels between
+						{
+							surface_pen.put_value(color);
+							surface_pen.inc_y();
+						}
+						if (y2e!=0)	// maybe draw bottom pixel
+						{
+							surface_pen.set_alpha(y2e*(x2f-x1f));
+							surface_pen.put_value(color);
+						}
+					}
+				}
+				else
+				{
+					// case 3 - a single horizontal row of pixels
+					if(y2<y1)
+					{
+						surface_pen.move_to(x1-1,y2);
+						if (x1e!=0)	// maybe draw left pixel
+						{
+							surface_pen.set_alpha(x1e*(y2f-y1f));
+							surface_pen.put_value(color);
+						}
+						surface_pen.inc_x();
+						surface_pen.set_alpha(y2f-y1f);
+						for(int i=x1; i<x2; i++) // maybe draw pixels between
+						{
+							surface_pen.put_value(color);
+							surface_pen.inc_x();
+						}
+						if (x2e!=0)	// maybe draw right pixel
+						{
+							surface_pen.set_alpha(x2e*(y2f-y1f));
+							surface_pen.put_value(color);
+						}
+					}
+					// case 4 - a proper block of pixels
+					else
+					{
+						if (x1e!=0)	// maybe draw left edge
+						{
+							surface_pen.move_to(x1-1,y1-1);
+							if (y1e!=0)	// maybe draw top left pixel
+							{
+								surface_pen.set_alpha(x1e*y1e);
+								surface_pen.put_value(color);
+							}
+							surface_pen.inc_y();
+							surface_pen.set_alpha(x1e);
+							for(int i=y1; i<y2; i++) // maybe draw pixels along the left edge
+							{
+								surface_pen.put_value(color);
+								surface_pen.inc_y();
+							}
+							if (y2e!=0)	// maybe draw bottom left pixel
+							{
+								surface_pen.set_alpha(x1e*y2e);
+								surface_pen.put_value(color);
+							}
+							surface_pen.inc_x();
+						}
+						else
+							surface_pen.move_to(x1,y2);
+						
+						if (y2e!=0)	// maybe draw bottom edge
+						{
+							surface_pen.set_alpha(y2e);
+							for(int i=x1; i<x2; i++) // maybe draw pixels along the bottom edge
+							{
+								surface_pen.put_value(color);
+								surface_pen.inc_x();
+							}
+							if (x2e!=0)	// maybe draw bottom right pixel
+							{
+								surface_pen.set_alpha(x2e*y2e);
+								surface_pen.put_value(color);
+							}
+							surface_pen.dec_y();
+						}
+						else
+							surface_pen.move_to(x2,y2-1);
+						
+						if (x2e!=0)	// maybe draw right edge
+						{
+							surface_pen.set_alpha(x2e);
+							for(int i=y1; i<y2; i++) // maybe draw pixels along the right edge
+							{
+								surface_pen.put_value(color);
+								surface_pen.dec_y();
+							}
+							if (y1e!=0)	// maybe draw top right pixel
+							{
+								surface_pen.set_alpha(x2e*y1e);
+								surface_pen.put_value(color);
+							}
+							surface_pen.dec_x();
+						}
+						else
+							surface_pen.move_to(x2-1,y1-1);
+						
+						if (y1e!=0)	// maybe draw top edge
+						{
+							surface_pen.set_alpha(y1e);
+							for(int i=x1; i<x2; i++) // maybe draw pixels along the top edge
+							{
+								surface_pen.put_value(color);
+								surface_pen.dec_x();
+							}
+						}
+					}
+				}
+			}
+			
+			if (reverse)
+			{
+				if (--iter == particle_list.begin())
+					break;
+			}
+			else
+			{
+				if (++iter == particle_list.end())
+					break;
+			}
+		}
+	}
+}
+
+class TaskPlant: public rendering::Task
+{
+public:
+	typedef etl::handle<TaskPlant> Handle;
+	static Token token;
+	Token::Handle get_token() const override { return token.handle(); }
+
+	std::shared_ptr<const Plant::ParticleList> particle_list;
+	Rect particles_bounds;
+	Point origin;
+	Real size;
+	bool reverse;
+	bool size_as_alpha;
+
+	TaskPlant(): size(), reverse(), size_as_alpha() { }
+
+	Rect calc_bounds() const override
+	{
+		if (!particle_list || particle_list->empty())
+			return Rect::zero();
+		return (particles_bounds + origin).expand(size);
+	}
+};
+
+//! Draws all of the particles at once, tile by tile
+class TaskPlantSW: public TaskPlant, public rendering::TaskSW,
+	public rendering::TaskInterfaceSplit
+{
+public:
+	typedef etl::handle<TaskPlantSW> Handle;
+	static Token token;
+	Token::Handle get_token() const override { return token.handle(); }
+
+	bool run(RunParams&) const override
+	{
+		if (!is_valid())
+			return true;
+
+		LockWrite la(this);
+		if (!la)
+			return false;
+
+		synfig::Surface &surface = la->get_surface();
+		synfig::Surface::pen pen(surface.get_pen(target_rect.minx, target_rect.miny));
+		surface.fill(Color(), pen, target_rect.get_width(), target_rect.get_height());
+
+		if (!particle_list || particle_list->empty())
+			return true;
+
+		const Vector ppu = get_pixels_per_unit();
+		const Real pw = 1.0/ppu[0];
+		const Real ph = 1.0/ppu[1];
+		const Point tl(
+			source_rect.minx - target_rect.minx*pw - origin[0],
+			source_rect.miny - target_rect.miny*ph - origin[1] );
+
+		draw_particles(surface, target_rect, *particle_list, tl, pw, ph, size, reverse, size_as_alpha);
+		return true;
+	}
+};
+
+rendering::Task::Token TaskPlant::token(
+	DescAbstract<TaskPlant>("Plant") );
+rendering::Task::Token TaskPlantSW::token(
+	DescReal<TaskPlantSW, TaskPlant>("PlantSW") );
+
 /* === M E T H O D S ======================================================= */
 
 
@@ -102,6 +542,7 @@ Plant::Plant():
 	bounding_rect(Rect::zero()),
 	mass(0.5),
 	needs_sync_(true),
+	needs_recolor_(false),
 	version(get_register_version())
 {
 	Random random;
@@ -129,47 +570,63 @@ Plant::Plant():
 	SET_STATIC_DEFAULTS();
 }
 
-void
-Plant::branch(int n,int depth,float t, float stunt_growth, synfig::Point position,synfig::Vector vel)const
-{
-	int splits=param_splits.get(int());
-	Real step=param_step.get(Real());
-	Vector gravity=param_gravity.get(Vector());
-	Real drag=param_drag.get(Real());
-	Gradient gradient=param_gradient.get(Gradient());
-	Angle split_angle=param_split_angle.get(Angle());
-	Real random_factor=param_random_factor.get(Real());
-	Random random;
-	random.set_seed(param_random.get(int()));
-	
-	float next_split((1.0-t)/(splits-depth)+t/*+random_factor*random(40+depth,t*splits,0,0)/splits*/);
-	for(;t<next_split;t+=step)
-	{
-		vel[0]+=gravity[0]*step;
-		vel[1]+=gravity[1]*step;
-		vel*=(1.0-(drag)*step);
-		position[0]+=vel[0]*step;
-		position[1]+=vel[1]*step;
 
-		particle_list.push_back(Particle(position, gradient(t)));
-		if (particle_list.size() % 1000000 == 0)
-			synfig::info("constructed %d million particles...", particle_list.size()/1000000);
-
-		bounding_rect.expand(position);
-	}
-
-	if(t>=1.0-stunt_growth)return;
+Plant::GeometryKey::GeometryKey():
+	bline_loop(),
+	seed(),
+	velocity(),
+	perp_velocity(),
+	step(),
+	splits(),
+	sprouts(),
+	random_factor(),
+	drag(),
+	use_width()
+{ }
 
-	synfig::Real sin_v=synfig::Angle::cos(split_angle).get();
-	synfig::Real cos_v=synfig::Angle::sin(split_angle).get();
-
-	synfig::Vector velocity1(vel[0]*sin_v - vel[1]*cos_v + random_factor*random(Random::SMOOTH_COSINE, 30+n+depth, t*splits, 0.0f, 0.0f),
-							 vel[0]*cos_v + vel[1]*sin_v + random_factor*random(Random::SMOOTH_COSINE, 32+n+depth, t*splits, 0.0f, 0.0f));
-	synfig::Vector velocity2(vel[0]*sin_v + vel[1]*cos_v + random_factor*random(Random::SMOOTH_COSINE, 31+n+depth, t*splits, 0.0f, 0.0f),
-							-vel[0]*cos_v + vel[1]*sin_v + random_factor*random(Random::SMOOTH_COSINE, 33+n+depth, t*splits, 0.0f, 0.0f));
+bool
+Plant::GeometryKey::operator==(const GeometryKey &other) const
+{
+	if (bline.size() != other.bline.size())
+		return false;
+	for(size_t i = 0; i < bline.size(); ++i)
+		if ( bline[i].get_vertex()   != other.bline[i].get_vertex()
+		  || bline[i].get_tangent1() != other.bline[i].get_tangent1()
+		  || bline[i].get_tangent2() != other.bline[i].get_tangent2()
+		  || bline[i].get_width()    != other.bline[i].get_width() )
+			return false;
+	return bline_loop    == other.bline_loop
+		&& seed          == other.seed
+		&& split_angle   == other.split_angle
+		&& gravity       == other.gravity
+		&& velocity      == other.velocity
+		&& perp_velocity == other.perp_velocity
+		&& step          == other.step
+		&& splits        == other.splits
+		&& sprouts       == other.sprouts
+		&& random_factor == other.random_factor
+		&& drag          == other.drag
+		&& use_width     == other.use_width;
+}
 
-	Plant::branch(n,depth+1,t,stunt_growth,position,velocity1);
-	Plant::branch(n,depth+1,t,stunt_growth,position,velocity2);
+Plant::GeometryKey
+Plant::get_geometry_key()const
+{
+	GeometryKey key;
+	key.bline=param_bline.get_list_of(BLinePoint());
+	key.bline_loop=bline_loop;
+	key.seed=param_random.get(int());
+	key.split_angle=param_split_angle.get(Angle());
+	key.gravity=param_gravity.get(Vector());
+	key.velocity=param_velocity.get(Real());
+	key.perp_velocity=param_perp_velocity.get(Real());
+	key.step=param_step.get(Real());
+	key.splits=param_splits.get(int());
+	key.sprouts=param_sprouts.get(int());
+	key.random_factor=param_random_factor.get(Real());
+	key.drag=param_drag.get(Real());
+	key.use_width=param_use_width.get(bool());
+	return key;
 }
 
 void
@@ -212,104 +669,41 @@ Plant::calc_bounding_rect()const
 void
 Plant::sync()const
 {
-	std::vector<BLinePoint> bline(param_bline.get_list_of(BLinePoint()));
-	Real step_=param_step.get(Real());
+	GeometryKey key=get_geometry_key();
 	Gradient gradient=param_gradient.get(Gradient());
-	Real random_factor=param_random_factor.get(Real());
-	Random random;
-	random.set_seed(param_random.get(int()));
-	int sprouts=param_sprouts.get(int());
-	Real velocity=param_velocity.get(Real());
-	Real perp_velocity=param_perp_velocity.get(Real());
-	int splits=param_splits.get(int());
-	bool use_width=param_use_width.get(bool());
-	
-	std::lock_guard<std::mutex> lock(mutex);
-	if (!needs_sync_) return;
-	time_t start_time; time(&start_time);
-	particle_list.clear();
 
-	bounding_rect=Rect::zero();
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!needs_sync_ && !needs_recolor_) return;
 
-	// Bline must have at least 2 points in it
-	if(bline.size()<2)
+	if (particle_list && key == geometry_key)
 	{
+		// the same parameters were set again, or only colors are changed
+		if (needs_recolor_)
+		{
+			std::shared_ptr<ParticleList> recolored(new ParticleList(*particle_list));
+			for(ParticleList::iterator i = recolored->begin(); i != recolored->end(); ++i)
+				i->color = gradient(i->gradient_pos);
+			particle_list = recolored;
+		}
 		needs_sync_=false;
+		needs_recolor_=false;
 		return;
 	}
 
-	std::vector<synfig::BLinePoint>::const_iterator iter,next;
-
-	hermite<Vector> curve;
-
-	Real step(std::fabs(step_));
-
-	int seg(0);
-
-	next=bline.begin();
-
-	if(bline_loop)	iter=--bline.end(); // iter is the last  bline in the list; next is the first  bline in the list
-	else			iter=next++;		// iter is the first bline in the list; next is the second bline in the list
-
-	// loop through the bline; seg counts the blines as we do so; stop before iter is the last bline in the list
-	for(;next!=bline.end();iter=next++,seg++)
-	{
-		float iterw=iter->get_width();	// the width value of the iter vertex
-		float nextw=next->get_width();	// the width value of the next vertex
-		float width;					// the width at an intermediate position
-		curve.p1()=iter->get_vertex();
-		curve.t1()=iter->get_tangent2();
-		curve.p2()=next->get_vertex();
-		curve.t2()=next->get_tangent1();
-		curve.sync();
-
-		Real f;
-
-		int i=0, branch_count = 0, steps = round_to_int(1.0/step);
-		if (steps < 1) steps = 1;
-		for(f=0.0;f<1.0;f+=step,i++)
-		{
-			Point point(curve(f));
-
-			particle_list.push_back(Particle(point, gradient(0)));
-			if (particle_list.size() % 1000000 == 0)
-				synfig::info("constructed %d million particles...", particle_list.size()/1000000);
-
-			bounding_rect.expand(point);
-
-			Real stunt_growth(random_factor * (random(Random::SMOOTH_COSINE,i,f+seg,0.0f,0.0f)/2.0+0.5));
-			stunt_growth*=stunt_growth;
-
-			if((((i+1)*sprouts + steps/2) / steps) > branch_count) {
-				Vector branch_velocity(curve.derivative(f).norm()*velocity + curve.derivative(f).perp().norm()*perp_velocity);
-
-				if (std::isnan(branch_velocity[0]) || std::isnan(branch_velocity[1]))
-					continue;
-
-				branch_velocity[0] += random_factor * random(Random::SMOOTH_COSINE, 1, f*splits, 0.0f, 0.0f);
-				branch_velocity[1] += random_factor * random(Random::SMOOTH_COSINE, 2, f*splits, 0.0f, 0.0f);
-
-				if (use_width)
-				{
-					width = iterw+(nextw-iterw)*f; // calculate the width based on the current position
-
-					branch_velocity[0] *= width; // scale the velocity accordingly to the current width
-					branch_velocity[1] *= width;
-				}
+	time_t start_time; time(&start_time);
 
-				branch_count++;
-				branch(i, 0, 0,		 // time
-					   stunt_growth, // stunt growth
-					   point, branch_velocity);
-			}
-		}
-	}
+	std::shared_ptr<ParticleList> particles(new ParticleList());
+	bounding_rect=Rect::zero();
+	Generator(key, gradient, *particles, bounding_rect).build();
+	particle_list = particles;
+	geometry_key = key;
 
 	time_t end_time; time(&end_time);
 	if (end_time-start_time > 4)
 		synfig::info("Plant::sync() constructed %d particles in %d seconds\n",
-					 particle_list.size(), int(end_time-start_time));
+					 particle_list->size(), int(end_time-start_time));
 	needs_sync_=false;
+	needs_recolor_=false;
 }
 
 bool
@@ -325,7 +719,7 @@ Plant::set_param(const String & param, const ValueBase &value)
 	IMPORT_VALUE(param_origin);
 	IMPORT_VALUE_PLUS(param_split_angle,needs_sync_=true);
 	IMPORT_VALUE_PLUS(param_gravity,needs_sync_=true);
-	IMPORT_VALUE_PLUS(param_gradient,needs_sync_=true);
+	IMPORT_VALUE_PLUS(param_gradient,needs_recolor_=true);
 	IMPORT_VALUE_PLUS(param_velocity,needs_sync_=true);
 	IMPORT_VALUE_PLUS(param_perp_velocity,needs_sync_=true);
 	IMPORT_VALUE_PLUS(param_step,{
@@ -512,15 +906,39 @@ Plant::accelerated_render(Context context,Surface *surface,int quality, const Re
 	if(is_disabled() || !ret)
 		return ret;
 
-	if(needs_sync_==true)
+	if(needs_sync_ || needs_recolor_)
 		sync();
 
+	std::shared_ptr<const ParticleList> particles;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		particles = particle_list;
+	}
+
 	Surface dest_surface;
 	dest_surface.set_wh(surface->get_w(),surface->get_h());
 	dest_surface.clear();
 
-	// Here is where drawing occurs 
-	draw_particles(&dest_surface, renddesc);
+	// Here is where drawing occurs
+	if (particles)
+	{
+		Point origin=param_origin.get(Vector());
+		const Point	tl(renddesc.get_tl()-origin);
+		const Point br(renddesc.get_br()-origin);
+
+		// Width and Height of a pixel
+		const Real pw = (br[0] - tl[0]) / renddesc.get_w();
+		const Real ph = (br[1] - tl[1]) / renddesc.get_h();
+
+		draw_particles(
+			dest_surface,
+			RectInt(0, 0, dest_surface.get_w(), dest_surface.get_h()),
+			*particles,
+			tl, pw, ph,
+			param_size.get(Real()),
+			param_reverse.get(bool()),
+			param_size_as_alpha.get(bool()) );
+	}
 
 	Surface::alpha_pen pen(surface->get_pen(0,0),get_amount(),get_blend_method());
 	dest_surface.blit_to(pen);
@@ -528,242 +946,23 @@ Plant::accelerated_render(Context context,Surface *surface,int quality, const Re
 	return true;
 }
 
-
-
-
-void
-Plant::draw_particles(Surface *dest_surface, const RendDesc &renddesc)const
+rendering::Task::Handle
+Plant::build_composite_task_vfunc(ContextParams /*context_params*/)const
 {
-	Point origin=param_origin.get(Vector());
-	Real size=param_size.get(Real());
-	bool reverse=param_reverse.get(bool());
-	bool size_as_alpha=param_size_as_alpha.get(bool());
-	
-	const Point	tl(renddesc.get_tl()-origin);
-	const Point br(renddesc.get_br()-origin);
-	
-	const int	w(renddesc.get_w());
-	const int	h(renddesc.get_h());
-	
-	const int	surface_width(dest_surface->get_w());
-	const int	surface_height(dest_surface->get_h());
-	
-	// Width and Height of a pixel
-	const Real pw = (br[0] - tl[0]) / w;
-	const Real ph = (br[1] - tl[1]) / h;
-	
-	if (std::isinf(pw) || std::isinf(ph))
-		return;
-	
-	if (particle_list.begin() != particle_list.end())
+	if(needs_sync_ || needs_recolor_)
+		sync();
+
+	TaskPlant::Handle task(new TaskPlant());
 	{
-		std::vector<Particle>::iterator iter;
-		Particle *particle;
-		
-		float radius(size*sqrt(1.0f/(std::fabs(pw)*std::fabs(ph))));
-		
-		int x1,y1,x2,y2;
-		
-		if (reverse)	iter = particle_list.end();
-		else			iter = particle_list.begin();
-		
-		while (true)
-		{
-			if (reverse)	particle = &(*(iter-1));
-			else			particle = &(*iter);
-			
-			float scaled_radius(radius);
-			Color color(particle->color);
-			if(size_as_alpha)
-			{
-				scaled_radius*=color.get_a();
-				color.set_a(1);
-			}
-			
-			// previously, radius was multiplied by sqrt(step)*12 only if
-			// the radius came out at less than 1 (pixel):
-			//   if (radius<=1.0f) radius*=sqrt(step)*12.0f;
-			// seems a little arbitrary - does it help?
-			
-			// calculate the box that this particle will be drawn as
-			float x1f=(particle->point[0]-tl[0])/pw-(scaled_radius*0.5);
-			float x2f=(particle->point[0]-tl[0])/pw+(scaled_radius*0.5);
-			float y1f=(particle->point[1]-tl[1])/ph-(scaled_radius*0.5);
-			float y2f=(particle->point[1]-tl[1])/ph+(scaled_radius*0.5);
-			const auto ceil_to_int = [](float num) -> int {
-				return static_cast<int>(std::ceil(num));
-			};
-			x1=ceil_to_int(x1f);
-			x2=ceil_to_int(x2f)-1;
-			y1=ceil_to_int(y1f);
-			y2=ceil_to_int(y2f)-1;
-			
-			// if the box isn't entirely off the canvas, draw it
-			if(x1<=surface_width && y1<=surface_height && x2>=0 && y2>=0)
-			{
-				float x1e=x1-x1f, x2e=x2f-x2, y1e=y1-y1f, y2e=y2f-y2;
-				// printf("x1e %.4f x2e %.4f y1e %.4f y2e %.4f\n", x1e, x2e, y1e, y2e);
-				
-				// adjust the box so it's entirely on the canvas
-				if(x1<=0) { x1=0; x1e=0; }
-				if(y1<=0) { y1=0; y1e=0; }
-				if(x2>=surface_width)  { x2=surface_width;  x2e=0; }
-				if(y2>=surface_height) { y2=surface_height; y2e=0; }
-				
-				int w(x2-x1), h(y2-y1);
-				
-				Surface::alpha_pen surface_pen(dest_surface->get_pen(x1,y1),1.0f);
-				if(w>0 && h>0)
-					dest_surface->fill(color,surface_pen,w,h);
-				
-				/* the rectangle doesn't cross any vertical pixel boundaries so we don't
-				 * need to draw any top or bottom edges
-				 */
-				if(x2<x1)
-				{
-					// case 1 - a single pixel
-					if(y2<y1)
-					{
-						surface_pen.move_to(x2,y2);
-						surface_pen.set_alpha((x2f-x1f)*(y2f-y1f));
-						surface_pen.put_value(color);
-					}
-					// case 2 - a single vertical column of pixels
-					else
-					{
-						surface_pen.move_to(x2,y1-1);
-						if (y1e!=0)	// maybe draw top pixel
-						{
-							surface_pen.set_alpha(y1e*(x2f-x1f));
-							surface_pen.put_value(color);
-						}
-						surface_pen.inc_y();
-						surface_pen.set_alpha(x2f-x1f);
-						for(int i=y1; i<y2; i++) // maybe draw pixels between
-						{
-							surface_pen.put_value(color);
-							surface_pen.inc_y();
-						}
-						if (y2e!=0)	// maybe draw bottom pixel
-						{
-							surface_pen.set_alpha(y2e*(x2f-x1f));
-							surface_pen.put_value(color);
-						}
-					}
-				}
-				else
-				{
-					// case 3 - a single horizontal row of pixels
-					if(y2<y1)
-					{
-						surface_pen.move_to(x1-1,y2);
-						if (x1e!=0)	// maybe draw left pixel
-						{
-							surface_pen.set_alpha(x1e*(y2f-y1f));
-							surface_pen.put_value(color);
-						}
-						surface_pen.inc_x();
-						surface_pen.set_alpha(y2f-y1f);
-						for(int i=x1; i<x2; i++) // maybe draw pixels between
-						{
-							surface_pen.put_value(color);
-							surface_pen.inc_x();
-						}
-						if (x2e!=0)	// maybe draw right pixel
-						{
-							surface_pen.set_alpha(x2e*(y2f-y1f));
-							surface_pen.put_value(color);
-						}
-					}
-					// case 4 - a proper block of pixels
-					else
-					{
-						if (x1e!=0)	// maybe draw left edge
-						{
-							surface_pen.move_to(x1-1,y1-1);
-							if (y1e!=0)	// maybe draw top left pixel
-							{
-								surface_pen.set_alpha(x1e*y1e);
-								surface_pen.put_value(color);
-							}
-							surface_pen.inc_y();
-							surface_pen.set_alpha(x1e);
-							for(int i=y1; i<y2; i++) // maybe draw pixels along the left edge
-							{
-								surface_pen.put_value(color);
-								surface_pen.inc_y();
-							}
-							if (y2e!=0)	// maybe draw bottom left pixel
-							{
-								surface_pen.set_alpha(x1e*y2e);
-								surface_pen.put_value(color);
-							}
-							surface_pen.inc_x();
-						}
-						else
-							surface_pen.move_to(x1,y2);
-						
-						if (y2e!=0)	// maybe draw bottom edge
-						{
-							surface_pen.set_alpha(y2e);
-							for(int i=x1; i<x2; i++) // maybe draw pixels along the bottom edge
-							{
-								surface_pen.put_value(color);
-								surface_pen.inc_x();
-							}
-							if (x2e!=0)	// maybe draw bottom right pixel
-							{
-								surface_pen.set_alpha(x2e*y2e);
-								surface_pen.put_value(color);
-							}
-							surface_pen.dec_y();
-						}
-						else
-							surface_pen.move_to(x2,y2-1);
-						
-						if (x2e!=0)	// maybe draw right edge
-						{
-							surface_pen.set_alpha(x2e);
-							for(int i=y1; i<y2; i++) // maybe draw pixels along the right edge
-							{
-								surface_pen.put_value(color);
-								surface_pen.dec_y();
-							}
-							if (y1e!=0)	// maybe draw top right pixel
-							{
-								surface_pen.set_alpha(x2e*y1e);
-								surface_pen.put_value(color);
-							}
-							surface_pen.dec_x();
-						}
-						else
-							surface_pen.move_to(x2-1,y1-1);
-						
-						if (y1e!=0)	// maybe draw top edge
-						{
-							surface_pen.set_alpha(y1e);
-							for(int i=x1; i<x2; i++) // maybe draw pixels along the top edge
-							{
-								surface_pen.put_value(color);
-								surface_pen.dec_x();
-							}
-						}
-					}
-				}
-			}
-			
-			if (reverse)
-			{
-				if (--iter == particle_list.begin())
-					break;
-			}
-			else
-			{
-				if (++iter == particle_list.end())
-					break;
-			}
-		}
+		std::lock_guard<std::mutex> lock(mutex);
+		task->particle_list = particle_list;
+		task->particles_bounds = bounding_rect;
 	}
+	task->origin = param_origin.get(Vector());
+	task->size = param_size.get(Real());
+	task->reverse = param_reverse.get(bool());
+	task->size_as_alpha = param_size_as_alpha.get(bool());
+	return task;
 }
 
 
@@ -771,7 +970,7 @@ Plant::draw_particles(Surface *dest_surface, const RendDesc &renddesc)const
 Rect
 Plant::get_bounding_rect(Context context)const
 {
-	if(needs_sync_==true)
+	if(needs_sync_ || needs_recolor_)
 		sync();
 
 	if(is_disabled())
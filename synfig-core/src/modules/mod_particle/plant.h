@@ -32,6 +32,7 @@
 /* === H E A D E R S ======================================================= */
 
 #include <list>
+#include <memory>
 #include <vector>
 #include <synfig/layers/layer_composite.h>
 #include <synfig/blinepoint.h>
@@ -51,6 +52,41 @@ using namespace synfig;
 class Plant : public Layer_Composite, public Layer_NoDeform
 {
 	SYNFIG_LAYER_MODULE_EXT
+public:
+	struct Particle
+	{
+		Point point;
+		Color color;
+		float gradient_pos; //!< the color is taken from this position of the gradient
+
+		Particle(const Point &point, float gradient_pos, const Color& color):
+			point(point),color(color),gradient_pos(gradient_pos) { }
+	};
+
+	typedef std::vector<Particle> ParticleList;
+
+	//! Parameters which define positions of the particles
+	struct GeometryKey
+	{
+		std::vector<BLinePoint> bline;
+		bool bline_loop;
+		int seed;
+		Angle split_angle;
+		Vector gravity;
+		Real velocity;
+		Real perp_velocity;
+		Real step;
+		int splits;
+		int sprouts;
+		Real random_factor;
+		Real drag;
+		bool use_width;
+
+		GeometryKey();
+		bool operator==(const GeometryKey &other) const;
+		bool operator!=(const GeometryKey &other) const { return !(*this == other); }
+	};
+
 private:
 	//! Parameter: (std::vector<BLinePoint>)
 	ValueBase param_bline;
@@ -89,26 +125,19 @@ private:
 
 	bool bline_loop;
 
-	struct Particle
-	{
-		Point point;
-		Color color;
-
-		Particle(const Point &point,const Color& color):
-			point(point),color(color) { }
-	};
-
-	mutable std::vector<Particle> particle_list;
+	//! Particles are shared with rendering tasks, so they are replaced, never modified
+	mutable std::shared_ptr<const ParticleList> particle_list;
+	mutable GeometryKey geometry_key;
 	mutable Rect	bounding_rect;
 	Real mass;
 
 	mutable bool needs_sync_;
+	mutable bool needs_recolor_;
 	mutable std::mutex mutex;
 
-	void branch(int n, int depth,float t, float stunt_growth, Point position,Vector velocity)const;
+	GeometryKey get_geometry_key()const;
 	void sync()const;
 	String version;
-	void draw_particles(Surface *surface, const RendDesc &renddesc)const;
 
 public:
 
@@ -127,6 +156,9 @@ public:
 	virtual bool accelerated_render(Context context,Surface *surface,int quality, const RendDesc &renddesc, ProgressCallback *cb)const;
 	using Layer::get_bounding_rect;
 	virtual Rect get_bounding_rect(Context context)const;
+
+protected:
+	virtual rendering::Task::Handle build_composite_task_vfunc(ContextParams context_params)const;
 };
 
 /* === E N D =============================================================== */
@@ -0,0 +1,509 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file canvasbinary.cpp
+**	\brief Binary form of canvas documents (.sifb)
+**
+**	\legal
+**	Copyright (c) 2022 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include "canvasbinary.h"
+
+#include <cstring>
+#include <iomanip>
+#include <locale>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <libxml++/libxml++.h>
+
+#include "general.h"
+#include <synfig/localization.h>
+
+#endif
+
+using namespace synfig;
+
+/* === M A C R O S ========================================================= */
+
+/* === G L O B A L S ======================================================= */
+
+const char CanvasBinary::magic[4] = { 'S', 'I', 'F', 'B' };
+const std::uint32_t CanvasBinary::version = 1;
+
+namespace {
+
+enum SectionType: std::uint32_t {
+	SECTION_END     = 0,
+	SECTION_STRINGS = 1,
+	SECTION_ROOT    = 2,
+	SECTION_ELEMENT = 3
+};
+
+enum NodeType: std::uint8_t {
+	NODE_ELEMENT = 0,
+	NODE_TEXT    = 1,
+	//! element where all children are numeric leaves like <x>0.5</x>
+	NODE_NUMBERS = 2
+};
+
+enum ValueType: std::uint8_t {
+	VALUE_STRING = 0,
+	//! number printed with "%0.10f"
+	VALUE_REAL   = 1,
+	//! number printed with "%f"
+	VALUE_FLOAT  = 2
+};
+
+int
+value_precision(std::uint8_t type)
+{
+	return type == VALUE_REAL ? 10 : 6;
+}
+
+void
+format_number(std::ostringstream &stream, double value, int precision)
+{
+	stream.str(String());
+	stream << std::setprecision(precision) << value;
+}
+
+//! Elements whose numeric leaves are read by CanvasParser from CanvasBinary::Numbers
+bool
+is_numeric_array(const String &name)
+	{ return name == "vector" || name == "color"; }
+
+//! Elements whose "value" attribute is read by CanvasParser from CanvasBinary::Numbers
+bool
+is_numeric_value(const String &name)
+	{ return name == "real" || name == "angle"; }
+
+/* === P R O C E D U R E S ================================================= */
+
+/* === M E T H O D S ======================================================= */
+
+class Writer
+{
+private:
+	std::unordered_map<String, std::uint32_t> string_ids;
+	std::vector<const String*> strings;
+	std::istringstream parse_stream;
+	std::ostringstream number_stream;
+
+	static void put_u8(String &out, std::uint8_t x)
+		{ out.push_back((char)x); }
+
+	static void put_u32(String &out, std::uint32_t x)
+	{
+		char b[4] = { (char)(x & 0xff), (char)((x >> 8) & 0xff), (char)((x >> 16) & 0xff), (char)((x >> 24) & 0xff) };
+		out.append(b, 4);
+	}
+
+	static void put_f64(String &out, double x)
+	{
+		std::uint64_t u;
+		memcpy(&u, &x, sizeof(u));
+		char b[8];
+		for(int i = 0; i < 8; ++i)
+			b[i] = (char)((u >> (8*i)) & 0xff);
+		out.append(b, 8);
+	}
+
+	void put_string(String &out, const String &x)
+	{
+		auto i = string_ids.find(x);
+		if (i == string_ids.end()) {
+			i = string_ids.emplace(x, (std::uint32_t)strings.size()).first;
+			strings.push_back(&i->first);
+		}
+		put_u32(out, i->second);
+	}
+
+	//! Detects numbers which will be printed back exactly as they are written now
+	std::uint8_t parse_value(const String &text, double &number)
+	{
+		if (text.empty() || text.size() > 64)
+			return VALUE_STRING;
+		parse_stream.clear();
+		parse_stream.str(text);
+		if (!(parse_stream >> number) || parse_stream.peek() != std::char_traits<char>::eof())
+			return VALUE_STRING;
+		format_number(number_stream, number, value_precision(VALUE_REAL));
+		if (number_stream.str() == text)
+			return VALUE_REAL;
+		format_number(number_stream, number, value_precision(VALUE_FLOAT));
+		if (number_stream.str() == text)
+			return VALUE_FLOAT;
+		return VALUE_STRING;
+	}
+
+	void put_value(String &out, const String &text)
+	{
+		double number;
+		std::uint8_t type = parse_value(text, number);
+		put_u8(out, type);
+		if (type == VALUE_STRING)
+			put_string(out, text);
+		else
+			put_f64(out, number);
+	}
+
+	void put_attributes(String &out, xmlpp::Element &element)
+	{
+		xmlpp::Element::AttributeList attributes = element.get_attributes();
+		put_u32(out, (std::uint32_t)attributes.size());
+		for(xmlpp::Element::AttributeList::const_iterator i = attributes.begin(); i != attributes.end(); ++i) {
+			put_string(out, (*i)->get_name());
+			put_value(out, (*i)->get_value());
+		}
+	}
+
+	//! Returns type of the number, if element is like <x>0.5</x>
+	std::uint8_t numeric_leaf(xmlpp::Node *node, double &number)
+	{
+		xmlpp::Element *element = dynamic_cast<xmlpp::Element*>(node);
+		if (!element || !element->get_attributes().empty())
+			return VALUE_STRING;
+		xmlpp::Node::NodeList children = element->get_children();
+		if (children.size() != 1)
+			return VALUE_STRING;
+		xmlpp::TextNode *text = dynamic_cast<xmlpp::TextNode*>(children.front());
+		return text ? parse_value(text->get_content(), number) : VALUE_STRING;
+	}
+
+	bool put_numbers(String &out, xmlpp::Element &element, xmlpp::Node::NodeList &children)
+	{
+		if (children.empty())
+			return false;
+
+		std::vector<double> numbers;
+		numbers.reserve(children.size());
+		std::uint8_t type = VALUE_STRING;
+		for(xmlpp::Node::NodeList::const_iterator i = children.begin(); i != children.end(); ++i) {
+			double number;
+			std::uint8_t t = numeric_leaf(*i, number);
+			if (t == VALUE_STRING || (type != VALUE_STRING && t != type))
+				return false;
+			type = t;
+			numbers.push_back(number);
+		}
+
+		put_u8(out, NODE_NUMBERS);
+		put_string(out, element.get_name());
+		put_attributes(out, element);
+		put_u8(out, type);
+		put_u32(out, (std::uint32_t)children.size());
+		for(xmlpp::Node::NodeList::const_iterator i = children.begin(); i != children.end(); ++i)
+			put_string(out, (*i)->get_name());
+		for(std::vector<double>::const_iterator i = numbers.begin(); i != numbers.end(); ++i)
+			put_f64(out, *i);
+		return true;
+	}
+
+	void put_element(String &out, xmlpp::Element &element)
+	{
+		xmlpp::Node::NodeList children = element.get_children();
+		if (put_numbers(out, element, children))
+			return;
+
+		put_u8(out, NODE_ELEMENT);
+		put_string(out, element.get_name());
+		put_attributes(out, element);
+
+		std::uint32_t count = 0;
+		for(xmlpp::Node::NodeList::const_iterator i = children.begin(); i != children.end(); ++i)
+			if (dynamic_cast<xmlpp::Element*>(*i) || dynamic_cast<xmlpp::TextNode*>(*i))
+				++count;
+		put_u32(out, count);
+
+		for(xmlpp::Node::NodeList::const_iterator i = children.begin(); i != children.end(); ++i) {
+			if (xmlpp::Element *child = dynamic_cast<xmlpp::Element*>(*i)) {
+				put_element(out, *child);
+			} else
+			if (xmlpp::TextNode *text = dynamic_cast<xmlpp::TextNode*>(*i)) {
+				put_u8(out, NODE_TEXT);
+				put_value(out, text->get_content());
+			}
+		}
+	}
+
+	static void write_section(std::ostream &stream, std::uint32_t type, const String &data)
+	{
+		if (data.size() > 0xffffffffu)
+			throw std::runtime_error("section is too big");
+		String header;
+		put_u32(header, type);
+		put_u32(header, (std::uint32_t)data.size());
+		stream.write(header.data(), header.size());
+		stream.write(data.data(), data.size());
+	}
+
+public:
+	Writer()
+	{
+		parse_stream.imbue(std::locale::classic());
+		number_stream.imbue(std::locale::classic());
+		number_stream << std::fixed;
+	}
+
+	void write(std::ostream &stream, xmlpp::Element &root)
+	{
+		std::vector<String> sections;
+
+		// root element without children
+		sections.push_back(String());
+		put_string(sections.back(), root.get_name());
+		put_attributes(sections.back(), root);
+
+		xmlpp::Node::NodeList children = root.get_children();
+		for(xmlpp::Node::NodeList::const_iterator i = children.begin(); i != children.end(); ++i)
+			if (xmlpp::Element *child = dynamic_cast<xmlpp::Element*>(*i)) {
+				sections.push_back(String());
+				put_element(sections.back(), *child);
+			}
+
+		String string_table;
+		put_u32(string_table, (std::uint32_t)strings.size());
+		for(std::vector<const String*>::const_iterator i = strings.begin(); i != strings.end(); ++i) {
+			put_u32(string_table, (std::uint32_t)(*i)->size());
+			string_table.append(**i);
+		}
+
+		String header(CanvasBinary::magic, sizeof(CanvasBinary::magic));
+		put_u32(header, CanvasBinary::version);
+		stream.write(header.data(), header.size());
+
+		write_section(stream, SECTION_STRINGS, string_table);
+		for(std::vector<String>::const_iterator i = sections.begin(); i != sections.end(); ++i)
+			write_section(stream, i == sections.begin() ? SECTION_ROOT : SECTION_ELEMENT, *i);
+		write_section(stream, SECTION_END, String());
+	}
+};
+
+void
+check_size(const char *pos, const char *end, size_t size)
+{
+	if ((size_t)(end - pos) < size)
+		throw std::runtime_error(_("Binary canvas file is damaged"));
+}
+
+std::uint8_t
+get_u8(const char *&pos, const char *end)
+{
+	check_size(pos, end, 1);
+	return (std::uint8_t)*pos++;
+}
+
+std::uint32_t
+get_u32(const char *&pos, const char *end)
+{
+	check_size(pos, end, 4);
+	const unsigned char *b = (const unsigned char*)pos;
+	pos += 4;
+	return (std::uint32_t)b[0] | ((std::uint32_t)b[1] << 8) | ((std::uint32_t)b[2] << 16) | ((std::uint32_t)b[3] << 24);
+}
+
+double
+get_f64(const char *&pos, const char *end)
+{
+	check_size(pos, end, 8);
+	const unsigned char *b = (const unsigned char*)pos;
+	pos += 8;
+	std::uint64_t u = 0;
+	for(int i = 7; i >= 0; --i)
+		u = (u << 8) | b[i];
+	double x;
+	memcpy(&x, &u, sizeof(x));
+	return x;
+}
+
+} // END of anonymous namespace
+
+bool
+CanvasBinary::write(std::ostream &stream, xmlpp::Document &document)
+{
+	xmlpp::Element *root = document.get_root_node();
+	if (!root)
+		return false;
+
+	try
+	{
+		Writer().write(stream, *root);
+	}
+	catch(const std::exception &ex) { synfig::error("CanvasBinary::write(): %s", ex.what()); return false; }
+	catch(...) { synfig::error("CanvasBinary::write(): Caught unknown exception"); return false; }
+
+	return !stream.fail();
+}
+
+CanvasBinary::Reader::Reader(std::istream &stream):
+	stream(stream)
+{
+	number_stream.imbue(std::locale::classic());
+	number_stream << std::fixed;
+
+	char header[sizeof(magic) + 4];
+	if (!stream.read(header, sizeof(header)) || memcmp(header, magic, sizeof(magic)))
+		throw std::runtime_error(_("Not a binary canvas file"));
+	const char *pos = header + sizeof(magic);
+	if (get_u32(pos, header + sizeof(header)) > version)
+		throw std::runtime_error(_("Binary canvas file was made by a newer version of Synfig"));
+
+	if (read_section() != SECTION_STRINGS)
+		throw std::runtime_error(_("Binary canvas file is damaged"));
+	pos = section.data();
+	const char *end = pos + section.size();
+	std::uint32_t count = get_u32(pos, end);
+	strings.reserve(std::min<size_t>(count, section.size()/4));
+	for(std::uint32_t i = 0; i < count; ++i) {
+		std::uint32_t size = get_u32(pos, end);
+		check_size(pos, end, size);
+		strings.push_back(String(pos, size));
+		pos += size;
+	}
+}
+
+std::uint32_t
+CanvasBinary::Reader::read_section()
+{
+	char header[8];
+	if (!stream.read(header, sizeof(header)))
+		throw std::runtime_error(_("Binary canvas file is damaged"));
+	const char *pos = header;
+	std::uint32_t type = get_u32(pos, header + sizeof(header));
+	std::uint32_t size = get_u32(pos, header + sizeof(header));
+	section.resize(size);
+	if (size && !stream.read(section.data(), size))
+		throw std::runtime_error(_("Binary canvas file is damaged"));
+	return type;
+}
+
+const String&
+CanvasBinary::Reader::read_string(const char *&pos, const char *end)
+{
+	std::uint32_t index = get_u32(pos, end);
+	if (index >= strings.size())
+		throw std::runtime_error(_("Binary canvas file is damaged"));
+	return strings[index];
+}
+
+String
+CanvasBinary::Reader::read_value(const char *&pos, const char *end)
+{
+	std::uint8_t type = get_u8(pos, end);
+	if (type == VALUE_STRING)
+		return read_string(pos, end);
+	if (type != VALUE_REAL && type != VALUE_FLOAT)
+		throw std::runtime_error(_("Binary canvas file is damaged"));
+	format_number(number_stream, get_f64(pos, end), value_precision(type));
+	return number_stream.str();
+}
+
+void
+CanvasBinary::Reader::read_attributes(const char *&pos, const char *end, const String &name, xmlpp::Element *element)
+{
+	for(std::uint32_t count = get_u32(pos, end); count; --count) {
+		const String &attribute = read_string(pos, end);
+		if (attribute == "value" && is_numeric_value(name) && pos < end && (*pos == VALUE_REAL || *pos == VALUE_FLOAT)) {
+			++pos;
+			numbers[element] = get_f64(pos, end);
+			continue;
+		}
+		element->set_attribute(attribute, read_value(pos, end));
+	}
+}
+
+void
+CanvasBinary::Reader::read_element(std::uint8_t type, const char *&pos, const char *end, const String &name, xmlpp::Element *element)
+{
+	read_attributes(pos, end, name, element);
+
+	if (type == NODE_NUMBERS) {
+		std::uint8_t value_type = get_u8(pos, end);
+		if (value_type != VALUE_REAL && value_type != VALUE_FLOAT)
+			throw std::runtime_error(_("Binary canvas file is damaged"));
+		bool decoded = is_numeric_array(name);
+		std::uint32_t count = get_u32(pos, end);
+		check_size(pos, end, (size_t)count*12);
+		const char *values = pos + (size_t)count*4;
+		for(std::uint32_t i = 0; i < count; ++i) {
+			xmlpp::Element *leaf = element->add_child(read_string(pos, end));
+			double value = get_f64(values, end);
+			if (decoded) {
+				numbers[leaf] = value;
+			} else {
+				format_number(number_stream, value, value_precision(value_type));
+				leaf->add_child_text(number_stream.str());
+			}
+		}
+		pos = values;
+		return;
+	}
+
+	if (type != NODE_ELEMENT)
+		throw std::runtime_error(_("Binary canvas file is damaged"));
+
+	for(std::uint32_t count = get_u32(pos, end); count; --count) {
+		std::uint8_t child_type = get_u8(pos, end);
+		if (child_type == NODE_TEXT) {
+			element->add_child_text(read_value(pos, end));
+		} else {
+			const String &child_name = read_string(pos, end);
+			read_element(child_type, pos, end, child_name, element->add_child(child_name));
+		}
+	}
+}
+
+void
+CanvasBinary::Reader::read_root(xmlpp::Document &document)
+{
+	if (read_section() != SECTION_ROOT)
+		throw std::runtime_error(_("Binary canvas file is damaged"));
+	const char *pos = section.data();
+	const char *end = pos + section.size();
+	const String &name = read_string(pos, end);
+	read_attributes(pos, end, name, document.create_root_node(name));
+}
+
+bool
+CanvasBinary::Reader::read_child(xmlpp::Document &document)
+{
+	std::uint32_t type = read_section();
+	if (type == SECTION_END)
+		return false;
+	if (type != SECTION_ELEMENT)
+		throw std::runtime_error(_("Binary canvas file is damaged"));
+
+	numbers.clear();
+	const char *pos = section.data();
+	const char *end = pos + section.size();
+	std::uint8_t node_type = get_u8(pos, end);
+	const String &name = read_string(pos, end);
+	read_element(node_type, pos, end, name, document.create_root_node(name));
+	return true;
+}
@@ -0,0 +1,134 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file canvasbinary.h
+**	\brief Binary form of canvas documents (.sifb)
+**
+**	\legal
+**	Copyright (c) 2022 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === S T A R T =========================================================== */
+
+#ifndef __SYNFIG_CANVASBINARY_H
+#define __SYNFIG_CANVASBINARY_H
+
+/* === H E A D E R S ======================================================= */
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+#include "string.h"
+
+/* === M A C R O S ========================================================= */
+
+/* === T Y P E D E F S ===================================================== */
+
+/* === C L A S S E S & S T R U C T S ======================================= */
+
+namespace xmlpp { class Document; class Element; };
+
+namespace synfig {
+
+/*!	\class CanvasBinary
+**	\brief Compact binary encoding of the canvas document tree (.sifb)
+**
+**	The file holds the same element tree as a .sif file, so any document
+**	round-trips losslessly between both formats and is loaded by the same
+**	CanvasParser code. It starts with the "SIFB" magic and a version number,
+**	followed by length-prefixed sections:
+**	 - the string table: every element name, attribute name and textual
+**	   value (layer types, param names, GUIDs, ids...) is stored only once;
+**	 - the root element with its attributes;
+**	 - one section per top-level child, so the loader never holds more than
+**	   one of them at a time;
+**	 - the end marker.
+**
+**	Numbers written by savecanvas are stored as raw little-endian doubles.
+**	Elements consisting only of numeric children of one type (vectors,
+**	colors) are stored as one array of doubles. Waypoints, bline vertices
+**	and other composite values keep their element structure.
+**
+**	The components of vectors and colors and the values of reals and angles
+**	are not printed back to the element tree: Reader keeps them decoded in
+**	Numbers, which CanvasParser reads instead of the text.
+**
+**	Reader still builds the element tree of each top-level child for
+**	CanvasParser, so the format is a compact lossless container rather than
+**	a faster loader. Load time against .sif and .sifz is measured by
+**	perf/scripts/test_load_perf.py.
+*/
+class CanvasBinary
+{
+public:
+	static const char magic[4];
+	static const std::uint32_t version;
+
+	//! Writes \a document to \a stream
+	/*!	\return \c true on success, \c false on error. */
+	static bool write(std::ostream &stream, xmlpp::Document &document);
+
+	//! Decoded numbers by the element which holds them: the <x>, <y>, <r>...
+	//! leaf of a vector or a color, or the <real> and <angle> element itself
+	typedef std::unordered_map<const xmlpp::Element*, double> Numbers;
+
+	/*!	\class Reader
+	**	\brief Reads a .sifb file section by section
+	**	Throws std::runtime_error if the file is damaged.
+	*/
+	class Reader
+	{
+	private:
+		std::istream &stream;
+		std::vector<String> strings;
+		std::vector<char> section;
+		std::ostringstream number_stream;
+		Numbers numbers;
+
+		std::uint32_t read_section();
+		void read_attributes(const char *&pos, const char *end, const String &name, xmlpp::Element *element);
+		void read_element(std::uint8_t type, const char *&pos, const char *end, const String &name, xmlpp::Element *element);
+		const String& read_string(const char *&pos, const char *end);
+		String read_value(const char *&pos, const char *end);
+
+	public:
+		//! Reads the header and the string table
+		explicit Reader(std::istream &stream);
+
+		//! Reads the root element, it is created in \a document without children
+		void read_root(xmlpp::Document &document);
+
+		//! Reads the next top-level child as the root of \a document
+		/*!	Numbers of the previous child are forgotten.
+		**	\return \c false when there are no more children */
+		bool read_child(xmlpp::Document &document);
+
+		//! Numbers of the last read child, valid while its document exists
+		const Numbers& get_numbers() const { return numbers; }
+	};
+};
+
+}; // END of namespace synfig
+
+/* === E N D =============================================================== */
+
+#endif
@@ -34,14 +34,23 @@
 
 #include "filecontainerzip.h"
 
+#include <algorithm>
 #include <cstring>
 #include <stdint.h>
 #include <cstddef>
 
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#endif
+
 #include <libxml++/libxml++.h>
 #include <glib/gstdio.h>
 
 #include "smartfile.h"
+#include "string_helper.h"
 #include "zstreambuf.h"
 
 #endif
@@ -216,6 +225,103 @@ namespace synfig
 
 using namespace synfig::FileContainerZip_InternalStructs;
 
+class FileContainerZip::Mapping
+{
+private:
+	void *view_;
+#ifdef _WIN32
+	HANDLE handle_;
+#endif
+	std::vector<char> buffer_;
+
+	Mapping(const Mapping&) = delete;
+	Mapping& operator=(const Mapping&) = delete;
+
+public:
+	const char *data;
+	file_size_t size;
+
+	Mapping(FILE *f, file_size_t size):
+		view_(nullptr),
+#ifdef _WIN32
+		handle_(nullptr),
+#endif
+		data(nullptr),
+		size(size > 0 ? size : 0)
+	{
+		if (!this->size) return;
+		fflush(f);
+
+#ifdef _WIN32
+		handle_ = CreateFileMapping((HANDLE)_get_osfhandle(_fileno(f)), nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (handle_)
+			view_ = MapViewOfFile(handle_, FILE_MAP_READ, 0, 0, (SIZE_T)this->size);
+#else
+		view_ = mmap(nullptr, (size_t)this->size, PROT_READ, MAP_SHARED, fileno(f), 0);
+		if (view_ == MAP_FAILED)
+			view_ = nullptr;
+#endif
+		if (view_)
+			{ data = (const char*)view_; return; }
+
+		// mapping is not available, so just read the file
+		buffer_.resize((size_t)this->size);
+		long int position = ftell(f);
+		fseek(f, 0, SEEK_SET);
+		this->size = (file_size_t)fread(buffer_.data(), 1, buffer_.size(), f);
+		fseek(f, position, SEEK_SET);
+		data = buffer_.data();
+	}
+
+	~Mapping()
+	{
+#ifdef _WIN32
+		if (view_) UnmapViewOfFile(view_);
+		if (handle_) CloseHandle(handle_);
+#else
+		if (view_) munmap(view_, (size_t)size);
+#endif
+	}
+};
+
+class FileContainerZip::MappedReadStream: public FileSystem::ReadStream
+{
+private:
+	std::shared_ptr<Mapping> mapping_;
+
+protected:
+	virtual size_t internal_read(void * /* buffer */, size_t /* size */)
+		{ return 0; }
+
+public:
+	MappedReadStream(FileSystem::Handle file_system, const std::shared_ptr<Mapping> &mapping, file_size_t begin, file_size_t end):
+		FileSystem::ReadStream(file_system),
+		mapping_(mapping)
+	{
+		set_read_buffer(mapping_->data + begin, mapping_->data + end);
+	}
+};
+
+class FileContainerZip::Deflater
+{
+public:
+	z_stream stream;
+	bool initialized;
+
+	Deflater(): stream(), initialized(false)
+	{
+		initialized = Z_OK == deflateInit2(&stream,
+			zstreambuf::option_compression_level,
+			zstreambuf::option_method,
+			-MAX_WBITS,
+			zstreambuf::option_mem_level,
+			zstreambuf::option_strategy );
+	}
+
+	~Deflater()
+		{ if (initialized) deflateEnd(&stream); }
+};
+
 void FileContainerZip::FileInfo::split_name()
 {
 	size_t pos = name.rfind('/');
@@ -405,29 +511,25 @@ bool FileContainerZip::open_from_history(const String &container_filename, file_
 
 	if (!f) return false;
 
-	// check size of file
+	// map the whole file, entries are read from the mapping
 	fseek(f, 0, SEEK_END);
-	long int filesize = ftell(f);
-	long int actual_filesize = filesize;
-	if (filesize < (long int)sizeof(EndOfCentralDirectory))
+	std::shared_ptr<Mapping> mapping = std::make_shared<Mapping>(f, (file_size_t)ftell(f));
+	file_size_t filesize = mapping->size;
+	file_size_t actual_filesize = filesize;
+	if (filesize < (file_size_t)sizeof(EndOfCentralDirectory))
 		{ fclose(f); return false; }
 
 	if (truncate_storage_size > 0 && truncate_storage_size < filesize)
-		filesize = (long int)truncate_storage_size;
-
-	char buffer[(1 << 16) + sizeof(EndOfCentralDirectory)];
+		filesize = truncate_storage_size;
 
 	// search "end of central directory" record
 	EndOfCentralDirectory ecd;
-	size_t read_size = filesize > (long int)sizeof(buffer)
-					 ? sizeof(buffer) : (size_t)filesize;
-	fseek(f, filesize - (long int)read_size, SEEK_SET);
-	read_size = fread(&buffer, 1, read_size, f);
+	file_size_t search_size = std::min(filesize, (file_size_t)((1 << 16) + sizeof(EndOfCentralDirectory)));
 	bool found = false;
-	for (int i = read_size - sizeof(EndOfCentralDirectory); i >= 0; i--) {
-		EndOfCentralDirectory *e = (EndOfCentralDirectory*)&buffer[i];
+	for (file_size_t i = filesize - (file_size_t)sizeof(EndOfCentralDirectory); i >= filesize - search_size; i--) {
+		const EndOfCentralDirectory *e = (const EndOfCentralDirectory*)(mapping->data + i);
 		if (e->signature == EndOfCentralDirectory::valid_signature__
-		 && e->comment_length == (uint16_t)(read_size - sizeof(EndOfCentralDirectory) - i))
+		 && e->comment_length == (uint16_t)(filesize - sizeof(EndOfCentralDirectory) - i))
 		{
 			ecd = *e;
 			found = true;
@@ -437,37 +539,40 @@ bool FileContainerZip::open_from_history(const String &container_filename, file_
 	if (!found)
 		{ fclose(f); return false; }
 
-	// read "central directory"
+	// index "central directory"
 	FileMap files;
-	fseek(f, ecd.offset, SEEK_SET);
+	file_size_t offset = ecd.offset;
 	for (int i = 0; i < ecd.current_records; i++) {
-		CentralDirectoryFileHeader cdfh;
-		if (sizeof(cdfh) != fread(&cdfh, 1, sizeof(cdfh), f))
+		if (offset + (file_size_t)sizeof(CentralDirectoryFileHeader) > filesize)
 			{ fclose(f); return false; }
-
-		// read name, comment and extrafield
-		size_t extra_size = cdfh.filename_length
-		                  + cdfh.filecomment_length
-		                  + cdfh.extrafield_length;
-		if (extra_size != fread(buffer, 1, extra_size, f))
+		const CentralDirectoryFileHeader &cdfh = *(const CentralDirectoryFileHeader*)(mapping->data + offset);
+		offset += sizeof(cdfh);
+
+		// name, comment and extrafield
+		const char *name = mapping->data + offset;
+		offset += cdfh.filename_length
+		        + cdfh.filecomment_length
+		        + cdfh.extrafield_length;
+		if (offset > filesize)
 			{ fclose(f); return false; }
 
 		if (cdfh.filename_length > 0
 		 && (cdfh.flags & 0x0071) == 0 )
 		{
 			FileInfo info;
-			if (buffer[cdfh.filename_length - 1] == '/')
+			if (name[cdfh.filename_length - 1] == '/')
 			{
-				info.name = String(buffer, buffer + cdfh.filename_length - 1);
+				info.name = String(name, name + cdfh.filename_length - 1);
 				info.is_directory = true;
 			}
 			else
 			{
-				info.name = String(buffer, buffer + cdfh.filename_length);
+				info.name = String(name, name + cdfh.filename_length);
 			}
 
 			info.directory_saved = info.is_directory;
 			info.size = cdfh.compressed_size;
+			info.uncompressed_size = cdfh.uncompressed_size;
 			info.header_offset = cdfh.offset;
 			info.compression = cdfh.compression;
 			info.crc32 = cdfh.crc32;
@@ -496,6 +601,7 @@ bool FileContainerZip::open_from_history(const String &container_filename, file_
 	// loaded
 	fseek(f, 0, SEEK_END);
 	storage_file_ = f;
+	mapping_ = mapping;
 	files_.swap( files );
 	prev_storage_size_ = actual_filesize;
 	file_reading_ = false;
@@ -547,7 +653,9 @@ bool FileContainerZip::save()
 		CentralDirectoryFileHeader cdfh;
 		cdfh.min_version = 20;
 		cdfh.offset = info.header_offset;
-		cdfh.compressed_size = cdfh.uncompressed_size = info.size;
+		cdfh.compression = (uint16_t)info.compression;
+		cdfh.compressed_size = (uint32_t)info.size;
+		cdfh.uncompressed_size = (uint32_t)info.uncompressed_size;
 		cdfh.crc32 = info.crc32;
 		cdfh.filename_length = (uint16_t)info.name.size();
 		if (info.is_directory)
@@ -602,7 +710,9 @@ void FileContainerZip::close()
 
 	save();
 
-	// close storage file and clead variables
+	// close storage file and clead variables, opened streams keep the mapping
+	mapping_.reset();
+	deflater_.reset();
 	fclose(storage_file_);
 	storage_file_ = nullptr;
 	files_.clear();
@@ -693,6 +803,58 @@ bool FileContainerZip::file_check_name(const String &filename)
 	return filename.size() <= (1 << 16) - 1 - sizeof(CentralDirectoryFileHeader);
 }
 
+bool FileContainerZip::file_is_compressed(const String &filename)
+{
+	static const char *extensions[] = {
+		".png", ".jpg", ".jpeg", ".gif", ".webp",
+		".sifz", ".sfg", ".gz", ".zip",
+		".mp3", ".ogg", ".oga", ".opus", ".flac", ".m4a",
+		".mp4", ".m4v", ".webm", ".mkv", ".avi", ".mov",
+		nullptr };
+	String extension = filesystem::Path::filename_extension(filename);
+	strtolower(extension);
+	for(const char **i = extensions; *i; ++i)
+		if (extension == *i)
+			return true;
+	return false;
+}
+
+bool FileContainerZip::map_storage(file_size_t size)
+{
+	if (!is_opened()) return false;
+	if (mapping_ && mapping_->size >= size) return true;
+
+	// entries were added after the last mapping
+	long int position = ftell(storage_file_);
+	fseek(storage_file_, 0, SEEK_END);
+	file_size_t file_size = ftell(storage_file_);
+	fseek(storage_file_, position, SEEK_SET);
+	if (file_size < size) return false;
+
+	mapping_ = std::make_shared<Mapping>(storage_file_, file_size);
+	return mapping_->size >= size;
+}
+
+bool FileContainerZip::write_deflated(const void *buffer, size_t size, bool finish)
+{
+	z_stream &stream = deflater_->stream;
+	char out_buf[zstreambuf::option_bufsize];
+	stream.next_in = (Bytef*)const_cast<void*>(buffer);
+	stream.avail_in = (uInt)size;
+	do
+	{
+		stream.avail_out = sizeof(out_buf);
+		stream.next_out = (Bytef*)out_buf;
+		if (Z_STREAM_ERROR == ::deflate(&stream, finish ? Z_FINISH : Z_NO_FLUSH))
+			return false;
+		size_t s = sizeof(out_buf) - stream.avail_out;
+		if (s != fwrite(out_buf, 1, s, storage_file_))
+			return false;
+		file_->second.size += s;
+	} while (stream.avail_out == 0);
+	return true;
+}
+
 bool FileContainerZip::file_open_read_whole_container()
 {
 	if (!is_opened() || file_is_opened()) return false;
@@ -746,10 +908,20 @@ bool FileContainerZip::file_open_write(const String &filename)
 
 	FileInfo &info = file_ == files_.end() ? new_info : file_->second;
 
+	// already compressed media is stored, other files are deflated
+	const bool compress = !file_is_compressed(info.name);
+	deflater_.reset();
+	if (compress) {
+		deflater_.reset(new Deflater());
+		if (!deflater_->initialized)
+			{ deflater_.reset(); return false; }
+	}
+
 	// write header
 	LocalFileHeader lfh;
 	time_t t = time(nullptr);
 	lfh.version = 20;
+	lfh.compression = compress ? 8 : 0;
 	lfh.filename_length = info.name.size();
 	DOSTimestamp dos_timestamp(t);
 	lfh.modification_time = dos_timestamp.dos_time;
@@ -766,7 +938,8 @@ bool FileContainerZip::file_open_write(const String &filename)
 	// update file info
 	info.header_offset = offset;
 	info.size = 0;
-	info.compression = 0;
+	info.uncompressed_size = 0;
+	info.compression = lfh.compression;
 	info.crc32 = 0;
 	info.time = t;
 	if (file_ == files_.end())
@@ -783,9 +956,16 @@ void FileContainerZip::file_close()
 {
 	if (file_is_opened_for_write())
 	{
+		if (deflater_)
+		{
+			write_deflated(nullptr, 0, true);
+			deflater_.reset();
+		}
+
 		LocalFileHeaderOverwrite lfho;
 		lfho.crc32 = file_->second.crc32;
-		lfho.compressed_size = lfho.uncompressed_size = file_->second.size;
+		lfho.compressed_size = (uint32_t)file_->second.size;
+		lfho.uncompressed_size = (uint32_t)file_->second.uncompressed_size;
 		fseek(storage_file_, file_->second.header_offset + LocalFileHeaderOverwrite::offset_from_header(), SEEK_SET);
 		fwrite(&lfho, 1, sizeof(lfho), storage_file_);
 		file_writing_ = false;
@@ -825,20 +1005,48 @@ size_t FileContainerZip::file_read(void *buffer, size_t size)
 size_t FileContainerZip::file_write(const void *buffer, size_t size)
 {
 	if (!file_is_opened_for_write()) return 0;
-	size_t s = fwrite(buffer, 1, size, storage_file_);
+	FileInfo &info = file_->second;
+	size_t s = size;
+	if (deflater_)
+	{
+		if (!write_deflated(buffer, size, false)) return 0;
+	}
+	else
+	{
+		s = fwrite(buffer, 1, size, storage_file_);
+		info.size += s;
+	}
 	file_processed_size_ += s;
-	file_->second.size = file_processed_size_;
-	file_->second.crc32 = crc32(file_->second.crc32, buffer, s);
+	info.uncompressed_size = file_processed_size_;
+	info.crc32 = crc32(info.crc32, buffer, s);
 	return s;
 }
 
 FileSystem::ReadStream::Handle FileContainerZip::get_read_stream(const String &filename)
 {
-	FileSystem::ReadStream::Handle stream = FileContainer::get_read_stream(filename);
-	if (stream
-	 && file_is_opened_for_read()
-	 && !file_reading_whole_container_
-	 && file_->second.compression > 0)
+	if (!is_opened()) return FileSystem::ReadStream::Handle();
+	FileMap::iterator i = files_.find(fix_slashes(filename));
+	if (i == files_.end() || i->second.is_directory)
+		return FileSystem::ReadStream::Handle();
+	// file is not written completely yet
+	if (file_is_opened_for_write() && file_ == i)
+		return FileSystem::ReadStream::Handle();
+	const FileInfo &info = i->second;
+
+	// locate data of the entry
+	if (!map_storage(info.header_offset + (file_size_t)sizeof(LocalFileHeader)))
+		return FileSystem::ReadStream::Handle();
+	const LocalFileHeader &lfh = *(const LocalFileHeader*)(mapping_->data + info.header_offset);
+	if (lfh.signature != LocalFileHeader::valid_signature__)
+		return FileSystem::ReadStream::Handle();
+	file_size_t begin = info.header_offset + sizeof(lfh) + lfh.filename_length + lfh.extrafield_length;
+	file_size_t end = begin + info.size;
+	if (!map_storage(end))
+		return FileSystem::ReadStream::Handle();
+
+	// stored data is read straight from the mapping, deflated data is inflated on the fly
+	FileSystem::ReadStream::Handle stream(new MappedReadStream(this, mapping_, begin, end));
+	if (info.compression > 0)
 		return new ZReadStream(stream, zstreambuf::compression::deflate);
 	return stream;
 }
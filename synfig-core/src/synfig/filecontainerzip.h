@@ -31,6 +31,7 @@
 /* === H E A D E R S ======================================================= */
 
 #include <map>
+#include <memory>
 #include <ctime>
 #include "filecontainer.h"
 
@@ -70,12 +71,20 @@ namespace synfig
 		};
 
 	private:
+		//! Read-only memory mapping of the storage file, it is shared with the opened streams
+		class Mapping;
+		//! Zero-copy stream of an entry stored in the mapping
+		class MappedReadStream;
+		//! Deflate state of the file being written
+		class Deflater;
+
 		struct FileInfo
 		{
 			String name;
 			bool is_directory;
 			bool directory_saved;
 			file_size_t size;
+			file_size_t uncompressed_size;
 			file_size_t header_offset;
 			unsigned int compression;
 			unsigned int crc32;
@@ -88,7 +97,7 @@ namespace synfig
 
 			inline FileInfo():
 				is_directory(false), directory_saved(false),
-				size(0), header_offset(0), compression(0), crc32(0), time(0) { }
+				size(0), uncompressed_size(0), header_offset(0), compression(0), crc32(0), time(0) { }
 		};
 
 		typedef std::map< String, FileInfo > FileMap;
@@ -102,12 +111,18 @@ namespace synfig
 		FileMap::iterator file_;
 		file_size_t file_processed_size_;
 		bool changed_;
+		std::shared_ptr<Mapping> mapping_;
+		std::unique_ptr<Deflater> deflater_;
 
 		static unsigned int crc32(unsigned int previous_crc, const void *buffer, size_t size);
 		static String encode_history(const HistoryRecord &history_record);
 		static HistoryRecord decode_history(const String &comment);
 		static void read_history(std::list<HistoryRecord> &list, FILE *f, file_size_t size);
 
+		//! Maps the storage file, if the current mapping is shorter than \a size
+		bool map_storage(file_size_t size);
+		bool write_deflated(const void *buffer, size_t size, bool finish);
+
 	public:
 		FileContainerZip();
 		virtual ~FileContainerZip();
@@ -131,6 +146,9 @@ namespace synfig
 		virtual bool file_remove(const String &filename);
 
 		bool file_check_name(const String &filename);
+		//! Files of already compressed formats (images, video, audio, archives) are written as is,
+		//! the other ones are deflated
+		static bool file_is_compressed(const String &filename);
 		virtual bool file_open_read_whole_container();
 		virtual bool file_open_read(const String &filename);
 		virtual bool file_open_write(const String &filename);
@@ -142,6 +160,8 @@ namespace synfig
 		virtual size_t file_read(void *buffer, size_t size);
 		virtual size_t file_write(const void *buffer, size_t size);
 
+		//! Opens an entry straight from the memory-mapped container,
+		//! any count of these streams may be opened at once
 		virtual FileSystem::ReadStream::Handle get_read_stream(const String &filename);
 	};
 
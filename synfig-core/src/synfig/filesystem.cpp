@@ -32,6 +32,9 @@
 #	include <config.h>
 #endif
 
+#include <algorithm>
+#include <cstring>
+
 #include <glibmm.h>
 
 #include "filesystem.h"
@@ -81,6 +84,20 @@ int FileSystem::ReadStream::underflow()
 	return std::streambuf::traits_type::to_int_type(*gptr());
 }
 
+std::streamsize
+FileSystem::ReadStream::xsgetn(char *s, std::streamsize n)
+{
+	// take buffered data first, then read the rest at once
+	std::streamsize size = std::max(std::streamsize(0), std::min(n, (std::streamsize)(egptr() - gptr())));
+	if (size > 0) {
+		memcpy(s, gptr(), (size_t)size);
+		setg(eback(), gptr() + size, egptr());
+	}
+	if (size < n)
+		size += (std::streamsize)internal_read(s + size, (size_t)(n - size));
+	return size;
+}
+
 // WriteStream
 
 FileSystem::WriteStream::WriteStream(FileSystem::Handle file_system):
@@ -96,6 +113,13 @@ FileSystem::WriteStream::overflow(int character)
 	return character != eof && sizeof(c) == internal_write(&c, sizeof(c)) ? character : eof;
 }
 
+std::streamsize
+FileSystem::WriteStream::xsputn(const char *s, std::streamsize n)
+{
+	// blocks are passed to the file system at once, not char by char through overflow()
+	return n > 0 ? (std::streamsize)internal_write(s, (size_t)n) : 0;
+}
+
 // Identifier
 
 FileSystem::ReadStream::Handle FileSystem::Identifier::get_read_stream() const
@@ -81,8 +81,14 @@ namespace synfig
 
 			ReadStream(FileSystem::Handle file_system);
 			int underflow() override;
+			std::streamsize xsgetn(char *s, std::streamsize n) override;
 			virtual size_t internal_read(void *buffer, size_t size) = 0;
 
+			//! Makes the stream read directly from memory, which should live as long as the stream,
+			//! internal_read() is called when it is over
+			void set_read_buffer(const char *begin, const char *end)
+				{ setg(const_cast<char*>(begin), const_cast<char*>(begin), const_cast<char*>(end)); }
+
 		public:
 			size_t read_block(void *buffer, size_t size)
 				{ return read((char*)buffer, size).gcount(); }
@@ -103,18 +109,14 @@ namespace synfig
 		protected:
 			WriteStream(FileSystem::Handle file_system);
 			int overflow(int ch) override;
+			std::streamsize xsputn(const char *s, std::streamsize n) override;
 			virtual size_t internal_write(const void *buffer, size_t size) = 0;
 
 		public:
 			bool write_block(const void *buffer, size_t size)
-			{
-				for(size_t i = 0; i < size; i++)
-					if (!put(((const char*)buffer)[i]).good())
-						return i;
-				return size;
-			}
+				{ return write((const char*)buffer, size).good(); }
 			bool write_whole_block(const void *buffer, size_t size)
-				{ return size == write_block(buffer, size); }
+				{ return write_block(buffer, size); }
 			bool write_whole_stream(std::streambuf &streambuf)
 				{ return (*this << &streambuf).good(); }
 			bool write_whole_stream(std::istream &stream)
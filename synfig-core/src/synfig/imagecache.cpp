@@ -0,0 +1,335 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file imagecache.cpp
+**	\brief Process-wide cache of decoded frames of imported files
+**
+**	\legal
+**	Copyright (c) 2022 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+
+#include <glibmm.h>
+#include <glib/gstdio.h>
+#include <sigc++/bind.h>
+
+#include "imagecache.h"
+
+#include "general.h"
+#include "importer.h"
+#include "threadpool.h"
+
+#include <synfig/rendering/software/surfacesw.h>
+#include <synfig/rendering/software/surfaceswpacked.h>
+#include <synfig/rendering/software/function/resample.h>
+
+#endif
+
+/* === U S I N G =========================================================== */
+
+using namespace synfig;
+
+/* === M A C R O S ========================================================= */
+
+#define IMAGE_CACHE_DEFAULT_SIZE_MB 512
+
+/* === G L O B A L S ======================================================= */
+
+ImageCache *ImageCache::instance_ = nullptr;
+
+/* === P R O C E D U R E S ================================================= */
+
+/* === M E T H O D S ======================================================= */
+
+ImageCache::ImageCache():
+	budget((size_t)IMAGE_CACHE_DEFAULT_SIZE_MB*1024*1024),
+	memory(0)
+{
+	if (const char *s = getenv("SYNFIG_IMAGE_CACHE_SIZE"))
+		budget = (size_t)std::max(0, atoi(s))*1024*1024;
+}
+
+ImageCache::Key
+ImageCache::make_key(const FileSystem::Identifier &identifier, const Time &time)
+{
+	Key key;
+	if (!identifier.file_system)
+		return key;
+
+	String uri = identifier.file_system->get_real_uri(identifier.filename.u8string());
+	if (uri.empty())
+		return key;
+	try {
+		key.filename = Glib::filename_from_uri(uri);
+	} catch(...) {
+		return Key();
+	}
+
+	GStatBuf buf;
+	if (g_stat(key.filename.c_str(), &buf) == 0)
+		key.mtime = (long long)buf.st_mtime;
+	key.time = time;
+	return key;
+}
+
+size_t
+ImageCache::get_surface_size(const rendering::Surface &surface)
+{
+	if (const rendering::SurfaceSWPacked *packed = dynamic_cast<const rendering::SurfaceSWPacked*>(&surface))
+		return sizeof(*packed) + packed->get_surface().get_data_size() + packed->get_surface().get_mipmap_size();
+	return sizeof(surface) + surface.get_buffer_size();
+}
+
+rendering::Surface::Handle
+ImageCache::make_proxy(const rendering::Surface &surface, int level)
+{
+	if (!surface.is_exists())
+		return nullptr;
+
+	const int w = surface.get_width(), h = surface.get_height();
+	const int proxy_w = std::max(1, w >> level), proxy_h = std::max(1, h >> level);
+	const RectInt src_bounds(0, 0, w, h), dest_bounds(0, 0, proxy_w, proxy_h);
+
+	synfig::Surface proxy(proxy_w, proxy_h);
+	if (const rendering::SurfaceSWPacked *packed = dynamic_cast<const rendering::SurfaceSWPacked*>(&surface))
+		rendering::software::Resample::downscale(proxy, dest_bounds, packed->get_surface(), src_bounds);
+	else
+	if (const rendering::SurfaceSW *sw = dynamic_cast<const rendering::SurfaceSW*>(&surface))
+		rendering::software::Resample::downscale(proxy, dest_bounds, sw->get_surface(), src_bounds);
+	else
+		return nullptr;
+
+	// keep the same kind of surface as decoded frames have
+	rendering::Surface::Handle result;
+	if (dynamic_cast<const rendering::SurfaceSWPacked*>(&surface))
+		result = new rendering::SurfaceSWPacked();
+	else
+		result = new rendering::SurfaceSW();
+	result->assign(proxy[0], proxy_w, proxy_h);
+	return result;
+}
+
+void
+ImageCache::insert(const Key &key, const rendering::Surface::Handle &surface)
+{
+	std::map<Key, List::iterator>::iterator i = index.find(key);
+	if (i != index.end()) {
+		memory -= i->second->size;
+		entries.erase(i->second);
+		index.erase(i);
+	}
+
+	Entry entry;
+	entry.key = key;
+	entry.surface = surface;
+	entry.size = get_surface_size(*surface);
+	if (entry.size > budget)
+		return;
+
+	entries.push_front(entry);
+	index[key] = entries.begin();
+	memory += entry.size;
+	evict();
+}
+
+void
+ImageCache::evict()
+{
+	while(memory > budget && !entries.empty()) {
+		memory -= entries.back().size;
+		index.erase(entries.back().key);
+		entries.pop_back();
+	}
+}
+
+void
+ImageCache::release_importers()
+{
+	std::vector<etl::handle<Importer>> importers;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		importers.swap(released);
+	}
+}
+
+rendering::Surface::Handle
+ImageCache::get(const Key &key)
+{
+	if (key.empty())
+		return rendering::Surface::Handle();
+	release_importers();
+
+	std::unique_lock<std::mutex> lock(mutex);
+	while(pending.count(key))
+		ThreadPool::instance().wait(cond, lock);
+
+	std::map<Key, List::iterator>::iterator i = index.find(key);
+	if (i == index.end())
+		return rendering::Surface::Handle();
+
+	// move to front
+	entries.splice(entries.begin(), entries, i->second);
+	rendering::Surface::Handle surface = i->second->surface;
+
+	// mipmaps of the frame may be built since the last access
+	size_t size = get_surface_size(*surface);
+	if (size != i->second->size) {
+		memory = memory - i->second->size + size;
+		i->second->size = size;
+		evict();
+	}
+	return surface;
+}
+
+void
+ImageCache::put(const Key &key, const rendering::Surface::Handle &surface)
+{
+	if (key.empty() || !surface)
+		return;
+	std::lock_guard<std::mutex> lock(mutex);
+	insert(key, surface);
+}
+
+bool
+ImageCache::contains(const Key &key) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return index.count(key) || pending.count(key);
+}
+
+bool
+ImageCache::is_pending(const Key &key) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return pending.count(key);
+}
+
+void
+ImageCache::prefetch_task(const Key &key, Importer *importer, const RendDesc &renddesc)
+{
+	rendering::Surface::Handle surface;
+	try {
+		surface = importer->decode_frame(renddesc, key.time);
+		if (surface && key.proxy_level)
+			surface = make_proxy(*surface, key.proxy_level);
+	} catch(...) { }
+
+	ImageCache &cache = instance();
+	std::lock_guard<std::mutex> lock(cache.mutex);
+	if (surface)
+		cache.insert(key, surface);
+	std::map<Key, etl::handle<Importer>>::iterator i = cache.pending.find(key);
+	if (i != cache.pending.end()) {
+		cache.released.push_back(i->second);
+		cache.pending.erase(i);
+	}
+	cache.cond.notify_all();
+}
+
+void
+ImageCache::prefetch(const Key &key, const etl::handle<Importer> &importer, const RendDesc &renddesc)
+{
+	if (key.empty() || !importer)
+		return;
+	release_importers();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (index.count(key) || pending.count(key))
+			return;
+		pending[key] = importer;
+	}
+	ThreadPool::instance().enqueue(
+		sigc::bind(sigc::ptr_fun(&ImageCache::prefetch_task), key, importer.get(), renddesc) );
+}
+
+void
+ImageCache::forget(const String &filename)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	for(List::iterator i = entries.begin(); i != entries.end();) {
+		if (i->key.filename == filename) {
+			memory -= i->size;
+			index.erase(i->key);
+			i = entries.erase(i);
+		} else ++i;
+	}
+}
+
+void
+ImageCache::clear()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	entries.clear();
+	index.clear();
+	memory = 0;
+}
+
+void
+ImageCache::set_budget(size_t bytes)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	budget = bytes;
+	evict();
+}
+
+size_t
+ImageCache::get_budget() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return budget;
+}
+
+size_t
+ImageCache::get_memory() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return memory;
+}
+
+ImageCache&
+ImageCache::instance()
+{
+	assert(instance_);
+	return *instance_;
+}
+
+bool
+ImageCache::subsys_init()
+{
+	if (!instance_) instance_ = new ImageCache();
+	return true;
+}
+
+bool
+ImageCache::subsys_stop()
+{
+	delete instance_;
+	instance_ = nullptr;
+	return true;
+}
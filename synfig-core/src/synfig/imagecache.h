@@ -0,0 +1,169 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file imagecache.h
+**	\brief Process-wide cache of decoded frames of imported files
+**
+**	\legal
+**	Copyright (c) 2022 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === S T A R T =========================================================== */
+
+#ifndef __SYNFIG_IMAGECACHE_H
+#define __SYNFIG_IMAGECACHE_H
+
+/* === H E A D E R S ======================================================= */
+
+#include <condition_variable>
+#include <list>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "filesystem.h"
+#include "renddesc.h"
+#include "string.h"
+#include "time.h"
+
+#include <synfig/rendering/surface.h>
+
+/* === M A C R O S ========================================================= */
+
+/* === T Y P E D E F S ===================================================== */
+
+/* === C L A S S E S & S T R U C T S ======================================= */
+
+namespace synfig {
+
+class Importer;
+
+/*!	\class ImageCache
+**	\brief Process-wide cache of decoded frames of imported files
+**
+**	Frames are keyed by the real file name, its modification time and the
+**	frame time, so importers of the same file in different layers and
+**	documents share the decoded surface, and a changed file is decoded again.
+**	The least recently used frames are evicted when the memory budget is
+**	exceeded. Files without a real file name (e.g. embedded into a container)
+**	are not cached. Reduced copies of frames (proxies) are cached under
+**	their own keys, see Importer::ProxyScope.
+**
+**	The budget is 512 MB by default, it may be changed by
+**	the SYNFIG_IMAGE_CACHE_SIZE environment variable (in megabytes).
+*/
+class ImageCache
+{
+public:
+	struct Key
+	{
+		String filename;
+		long long mtime;
+		Time time;
+		//! 0 for the full frame, the frame is scaled down by 2^proxy_level otherwise
+		int proxy_level;
+
+		Key(): mtime(), proxy_level() { }
+
+		bool empty() const { return filename.empty(); }
+
+		bool operator< (const Key &other) const
+		{
+			if (filename < other.filename) return true;
+			if (other.filename < filename) return false;
+			if (mtime < other.mtime) return true;
+			if (other.mtime < mtime) return false;
+			if (time < other.time) return true;
+			if (other.time < time) return false;
+			return proxy_level < other.proxy_level;
+		}
+	};
+
+private:
+	struct Entry
+	{
+		Key key;
+		rendering::Surface::Handle surface;
+		size_t size;
+	};
+
+	typedef std::list<Entry> List;
+
+	mutable std::mutex mutex;
+	std::condition_variable cond;
+
+	//! most recently used frames first
+	List entries;
+	std::map<Key, List::iterator> index;
+	//! frames which are being decoded in background, with their importers
+	std::map<Key, etl::handle<Importer>> pending;
+	//! importers are released by the threads which use the cache, not by the background ones
+	std::vector<etl::handle<Importer>> released;
+
+	size_t budget;
+	size_t memory;
+
+	static ImageCache *instance_;
+
+	void insert(const Key &key, const rendering::Surface::Handle &surface);
+	void evict();
+	void release_importers();
+
+	static void prefetch_task(const Key &key, Importer *importer, const RendDesc &renddesc);
+
+	ImageCache();
+	ImageCache(const ImageCache&) = delete;
+
+public:
+	//! Makes the key for the frame of file, returns an empty key if the file cannot be cached
+	static Key make_key(const FileSystem::Identifier &identifier, const Time &time);
+	//! Estimates memory used by \a surface, with the mipmaps built so far.
+	//! Mipmaps are built while rendering, so sizes of frames are updated by get().
+	static size_t get_surface_size(const rendering::Surface &surface);
+	//! Returns \a surface scaled down by 2^level, or null if the surface is not a software one
+	static rendering::Surface::Handle make_proxy(const rendering::Surface &surface, int level);
+
+	//! Returns the cached frame, or null. If the frame is being decoded in background, waits for it.
+	rendering::Surface::Handle get(const Key &key);
+	void put(const Key &key, const rendering::Surface::Handle &surface);
+	bool contains(const Key &key) const;
+	//! Returns true if the frame is being decoded in background
+	bool is_pending(const Key &key) const;
+
+	//! Decodes the frame by \a importer in the thread pool, if it is not cached yet.
+	//! For the proxy key the proxy is made from the decoded frame.
+	void prefetch(const Key &key, const etl::handle<Importer> &importer, const RendDesc &renddesc);
+
+	//! Removes all frames of the file
+	void forget(const String &filename);
+	void clear();
+
+	void set_budget(size_t bytes);
+	size_t get_budget() const;
+	size_t get_memory() const;
+
+	static ImageCache& instance();
+	static bool subsys_init();
+	static bool subsys_stop();
+};
+
+}; // END of namespace synfig
+
+/* === E N D =============================================================== */
+
+#endif
@@ -46,6 +46,8 @@
 #include <synfig/localization.h>
 
 #include "importer.h"
+#include "imagecache.h"
+#include "module.h"
 #include "string.h"
 #include "surface.h"
 
@@ -64,21 +66,63 @@ Importer::Book* synfig::Importer::book_;
 
 static std::map<FileSystem::Identifier,Importer::LooseHandle> *__open_importers;
 
+const int Importer::proxy_level_max = 2;
+
+namespace {
+	thread_local const Importer::ProxyScope *proxy_scope = nullptr;
+}
+
 /* === P R O C E D U R E S ================================================= */
 
 /* === M E T H O D S ======================================================= */
 
+Importer::ProxyScope::ProxyScope(const Matrix &transformation, int pixel_size):
+	previous(proxy_scope),
+	transformation(transformation)
+{
+	if (pixel_size > 1)
+		this->transformation = Matrix().set_scale(1.0/pixel_size) * transformation;
+	proxy_scope = this;
+}
+
+Importer::ProxyScope::~ProxyScope()
+{
+	proxy_scope = previous;
+}
+
+bool
+Importer::ProxyScope::is_active()
+{
+	return proxy_scope != nullptr;
+}
+
+Matrix
+Importer::ProxyScope::get_transformation()
+{
+	return proxy_scope ? proxy_scope->transformation : Matrix();
+}
+
+int
+Importer::get_proxy_level(int width, Real view_width)
+{
+	int level = 0;
+	while(level < proxy_level_max && (width >> (level + 1)) >= view_width)
+		++level;
+	return level;
+}
+
 bool
 Importer::subsys_init()
 {
 	book_=new Book();
 	__open_importers=new std::map<FileSystem::Identifier,Importer::LooseHandle>();
-	return true;
+	return ImageCache::subsys_init();
 }
 
 bool
 Importer::subsys_stop()
 {
+	ImageCache::subsys_stop();
 	delete book_;
 	delete __open_importers;
 	return true;
@@ -119,7 +163,10 @@ Importer::open(const FileSystem::Identifier &identifier, bool force)
 	strtolower(ext);
 
 
-	if(!Importer::book().count(ext))
+	if(Importer::book().count(ext) && !Importer::book()[ext].factory)
+		Module::load_provider(Module::ENTRY_IMPORTER, ext);
+
+	if(!Importer::book().count(ext) || !Importer::book()[ext].factory)
 	{
 		synfig::error(_("Importer::open(): Unknown file type -- ")+ext);
 		return nullptr;
@@ -141,6 +188,7 @@ Importer::open(const FileSystem::Identifier &identifier, bool force)
 void Importer::forget(const FileSystem::Identifier &identifier)
 {
 	__open_importers->erase(identifier);
+	ImageCache::instance().forget(ImageCache::make_key(identifier, Time()).filename);
 }
 
 Importer::Importer(const FileSystem::Identifier &identifier):
@@ -159,25 +207,62 @@ Importer::~Importer()
 }
 
 rendering::Surface::Handle
-Importer::get_frame(const RendDesc & /* renddesc */, const Time &time)
+Importer::get_frame(const RendDesc &renddesc, const Time &time, int proxy_level)
 {
-	if (last_surface_ && last_surface_->is_exists() && !is_animated())
+	const bool animated = is_animated();
+	if (last_surface_ && last_surface_->is_exists() && !animated && !proxy_level)
 		return last_surface_;
 
+	// the same file may be already decoded for another layer or document
+	ImageCache::Key key = ImageCache::make_key(identifier, animated ? time : Time());
+	key.proxy_level = proxy_level;
+	rendering::Surface::Handle surface = ImageCache::instance().get(key);
+	if (!surface && proxy_level) {
+		// make the proxy from the full frame, don't cache the full frame itself,
+		// to keep more proxies in the budget
+		ImageCache::Key full_key = key;
+		full_key.proxy_level = 0;
+		rendering::Surface::Handle full = !animated && last_surface_ && last_surface_->is_exists()
+		                                ? last_surface_ : ImageCache::instance().get(full_key);
+		if (!full)
+			full = decode_frame(renddesc, animated ? time : Time());
+		if (!full)
+			return nullptr;
+		surface = ImageCache::make_proxy(*full, proxy_level);
+		if (!surface)
+			return full;
+		ImageCache::instance().put(key, surface);
+	}
+	if (!surface) {
+		surface = decode_frame(renddesc, animated ? time : Time());
+		if (!surface)
+			return nullptr;
+		ImageCache::instance().put(key, surface);
+	}
+
+	if (!animated && !proxy_level)
+		last_surface_ = surface;
+	return surface;
+}
+
+rendering::Surface::Handle
+Importer::decode_frame(const RendDesc & /* renddesc */, const Time &time)
+{
 	Surface surface;
 	if(!get_frame(surface, RendDesc(), time)) {
 		warning(strprintf(_("Unable to get frame from \"%s\" [%s]"), identifier.filename.u8_str(), time.get_string().c_str()));
 		return nullptr;
 	}
 
+	rendering::Surface::Handle result;
 	const char *s = getenv("SYNFIG_PACK_IMAGES");
 	if (s == nullptr || atoi(s) != 0)
-		last_surface_ = new rendering::SurfaceSWPacked();
+		result = new rendering::SurfaceSWPacked();
 	else
-		last_surface_ = new rendering::SurfaceSW();
+		result = new rendering::SurfaceSW();
 
 	if (surface.is_valid())
-		last_surface_->assign(surface[0], surface.get_w(), surface.get_h());
+		result->assign(surface[0], surface.get_w(), surface.get_h());
 
-	return last_surface_;
+	return result;
 }
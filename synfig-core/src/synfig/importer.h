@@ -35,6 +35,7 @@
 #include <ETL/handle>
 
 #include "filesystem.h"
+#include "matrix.h"
 #include "progresscallback.h"
 #include "renddesc.h"
 #include "string.h"
@@ -143,6 +144,40 @@ public:
 	typedef etl::loose_handle<Importer> LooseHandle;
 	typedef etl::handle<const Importer> ConstHandle;
 
+	//! Proxies are copies of frames scaled down by 2^level: 1 - half, 2 - quarter resolution
+	static const int proxy_level_max;
+
+	//! Tells importing layers that a reduced resolution is enough while it exists.
+	//! The work area loads resources inside of a scope, so the imported footage is served
+	//! by proxies when the view does not need full detail. Final renders never open a scope
+	//! and always get full frames. Scopes belong to the current thread and can be nested:
+	//! groups open a scope with their own transformation around their sub canvas.
+	class ProxyScope
+	{
+	public:
+		//! \param transformation Maps units of the canvas to pixels of the view
+		//! \param pixel_size Size of the pixels drawn by the renderer, low resolution renderers use bigger pixels
+		explicit ProxyScope(const Matrix &transformation, int pixel_size = 1);
+		~ProxyScope();
+
+		//! Returns true if the current thread is inside of a scope
+		static bool is_active();
+		//! Returns the transformation of the innermost scope of the current thread
+		//! from units of the canvas to pixels drawn by the renderer
+		static Matrix get_transformation();
+
+	private:
+		const ProxyScope *previous;
+		Matrix transformation;
+
+		ProxyScope(const ProxyScope&) = delete;
+		ProxyScope& operator=(const ProxyScope&) = delete;
+	};
+
+	//! Returns the level of the smallest proxy of the frame of \a width pixels
+	//! which still has at least \a view_width pixels
+	static int get_proxy_level(int width, Real view_width);
+
 private:
 	rendering::Surface::Handle last_surface_;
 
@@ -165,7 +200,13 @@ public:
 	*/
 	virtual bool get_frame(Surface &surface, const RendDesc &renddesc, Time time, ProgressCallback *callback=nullptr) = 0;
 
-	virtual rendering::Surface::Handle get_frame(const RendDesc &renddesc, const Time &time);
+	//! Gets a frame as a rendering surface, decoded frames are shared through ImageCache
+	/*!	\param proxy_level If not zero, the frame is scaled down by 2^proxy_level,
+	**		proxies are made from the full frame once and cached as well */
+	virtual rendering::Surface::Handle get_frame(const RendDesc &renddesc, const Time &time, int proxy_level = 0);
+
+	//! Decodes a frame bypassing the caches
+	rendering::Surface::Handle decode_frame(const RendDesc &renddesc, const Time &time);
 
 	//! Returns \c true if the importer pays attention to the \a time parameter of get_frame()
 	virtual bool is_animated() { return false; }
@@ -68,6 +68,7 @@
 #include "rendering/common/task/tasklayer.h"
 
 #include "importer.h"
+#include "module.h"
 #include <atomic>
 #include <giomm.h>
 
@@ -176,7 +177,11 @@ Layer::Layer():
 Layer::LooseHandle
 synfig::Layer::create(const String &name)
 {
-	if(!book().count(name))
+	// placeholder of the layer from the module which is not loaded yet
+	if(book().count(name) && !book()[name].factory)
+		Module::load_provider(Module::ENTRY_LAYER, name);
+
+	if(!book().count(name) || !book()[name].factory)
 	{
 		return Layer::LooseHandle(new Layer_Mime(name));
 	}
@@ -41,6 +41,7 @@
 
 #include <synfig/canvas.h>
 #include <synfig/context.h>
+#include <synfig/importer.h>
 #include <synfig/paramdesc.h>
 #include <synfig/renddesc.h>
 #include <synfig/time.h>
@@ -331,7 +332,13 @@ Layer_PasteCanvas::load_resources_vfunc(IndependentContext context, Time time)co
 
 	Real time_dilation = param_time_dilation.get(Real());
 	Time time_offset = param_time_offset.get(Time());
-	sub_canvas->load_resources(time*time_dilation + time_offset);
+	if (Importer::ProxyScope::is_active()) {
+		// imported layers of the sub canvas are seen through the transformation of the group
+		Importer::ProxyScope proxy_scope(Importer::ProxyScope::get_transformation() * get_summary_transformation().get_matrix());
+		sub_canvas->load_resources(time*time_dilation + time_offset);
+	} else {
+		sub_canvas->load_resources(time*time_dilation + time_offset);
+	}
 }
 
 void
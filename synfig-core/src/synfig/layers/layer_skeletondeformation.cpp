@@ -40,6 +40,7 @@
 #include <synfig/paramdesc.h>
 #include <synfig/string.h>
 #include <synfig/time.h>
+#include <synfig/threadpool.h>
 #include <synfig/value.h>
 
 #include <synfig/rendering/common/task/taskblend.h>
@@ -58,6 +59,247 @@ using namespace synfig;
 
 /* === C L A S S E S ======================================================= */
 
+struct Layer_SkeletonDeformation::Skin {
+	typedef std::pair<Real, rendering::Mesh::Triangle> DepthTriangle;
+
+	static const int min_vertices_per_thread = 1024;
+
+	// grid and setup pose of bones, weights was calculated for
+	Point grid_p0;
+	Point grid_p1;
+	int grid_side_count_x;
+	int grid_side_count_y;
+	std::vector<Bone::Shape> shapes;
+
+	// initial positions of grid vertices
+	std::vector<Vector> positions;
+	// influences of vertex i are stored in range [first_influence[i], first_influence[i+1])
+	std::vector<int> first_influence;
+	std::vector<int> influence_bones;
+	std::vector<Real> influence_weights;
+	// triangles of the grid covered by bones, each two sequential triangles form a quad
+	rendering::Mesh::TriangleList triangles;
+
+	// depths of posed bones, sorted_triangles was built for
+	std::vector<Real> depths;
+	rendering::Mesh::TriangleList sorted_triangles;
+
+	Skin(): grid_side_count_x(), grid_side_count_y() { }
+
+	// exact comparison, any change of the setup pose must invalidate weights
+	static bool compare_points(const Point &a, const Point &b)
+		{ return a[0] == b[0] && a[1] == b[1]; }
+
+	static bool compare_shapes(const Bone::Shape &a, const Bone::Shape &b)
+	{
+		return compare_points(a.p0, b.p0) && a.r0 == b.r0
+			&& compare_points(a.p1, b.p1) && a.r1 == b.r1;
+	}
+
+	bool is_actual(
+		const Point &grid_p0,
+		const Point &grid_p1,
+		int grid_side_count_x,
+		int grid_side_count_y,
+		const std::vector<Bone::Shape> &shapes ) const
+	{
+		return compare_points(this->grid_p0, grid_p0)
+			&& compare_points(this->grid_p1, grid_p1)
+			&& this->grid_side_count_x == grid_side_count_x
+			&& this->grid_side_count_y == grid_side_count_y
+			&& this->shapes.size() == shapes.size()
+			&& std::equal(this->shapes.begin(), this->shapes.end(), shapes.begin(), compare_shapes);
+	}
+
+	bool is_used(int vertex) const
+		{ return first_influence[vertex] < first_influence[vertex + 1]; }
+
+	void build(
+		const Point &grid_p0,
+		const Point &grid_p1,
+		int grid_side_count_x,
+		int grid_side_count_y,
+		const std::vector<Bone::Shape> &shapes )
+	{
+		static const Real precision = 1e-10;
+
+		this->grid_p0 = grid_p0;
+		this->grid_p1 = grid_p1;
+		this->grid_side_count_x = grid_side_count_x;
+		this->grid_side_count_y = grid_side_count_y;
+		this->shapes = shapes;
+		depths.clear();
+		sorted_triangles.clear();
+
+		const Real grid_step_x = (grid_p1[0] - grid_p0[0]) / (Real)(grid_side_count_x - 1);
+		const Real grid_step_y = (grid_p1[1] - grid_p0[1]) / (Real)(grid_side_count_y - 1);
+		const Real grid_step_diagonal = sqrt(grid_step_x*grid_step_x + grid_step_y*grid_step_y);
+
+		// build grid
+		positions.clear();
+		positions.reserve(grid_side_count_x * grid_side_count_y);
+		for(int j = 0; j < grid_side_count_y; ++j)
+			for(int i = 0; i < grid_side_count_x; ++i)
+				positions.push_back(Vector(
+					grid_p0[0] + i*grid_step_x,
+					grid_p0[1] + j*grid_step_y ));
+
+		std::vector<Bone::Shape> expanded_shapes(shapes);
+		for(std::vector<Bone::Shape>::iterator i = expanded_shapes.begin(); i != expanded_shapes.end(); ++i) {
+			i->r0 += 2.0*grid_step_diagonal;
+			i->r1 += 2.0*grid_step_diagonal;
+		}
+
+		// calculate weights, bones order is the same as the order of summation in deform()
+		first_influence.clear();
+		influence_bones.clear();
+		influence_weights.clear();
+		first_influence.reserve(positions.size() + 1);
+		for(std::vector<Vector>::const_iterator j = positions.begin(); j != positions.end(); ++j)
+		{
+			first_influence.push_back((int)influence_bones.size());
+			for(int i = 0; i < (int)shapes.size(); ++i)
+			{
+				Real percent = Bone::distance_to_shape_center_percent(expanded_shapes[i], *j);
+				if (percent > precision) {
+					Real distance = distance_to_line(shapes[i].p0, shapes[i].p1, *j);
+					if (distance < precision) distance = precision;
+					Real weight =
+						percent/(distance*distance);
+						// 1.0/distance;
+						// 1.0/(distance*distance);
+						// 1.0/(distance*distance*distance);
+						// exp(-4.0*distance);
+					influence_bones.push_back(i);
+					influence_weights.push_back(weight);
+				}
+			}
+		}
+		first_influence.push_back((int)influence_bones.size());
+
+		// build triangles
+		triangles.clear();
+		triangles.reserve(2*(grid_side_count_x-1)*(grid_side_count_y-1));
+		for(int j = 1; j < grid_side_count_y; ++j)
+		{
+			for(int i = 1; i < grid_side_count_x; ++i)
+			{
+				int v[] = {
+					(j-1)*grid_side_count_x + (i-1),
+					(j-1)*grid_side_count_x +  i,
+					 j   *grid_side_count_x +  i,
+					 j   *grid_side_count_x + (i-1),
+				};
+				if (is_used(v[0]) && is_used(v[1]) && is_used(v[2]) && is_used(v[3]))
+				{
+					triangles.push_back(rendering::Mesh::Triangle(v[0], v[1], v[3]));
+					triangles.push_back(rendering::Mesh::Triangle(v[1], v[2], v[3]));
+				}
+			}
+		}
+	}
+
+	//! Applies the bone matrices to the vertices [begin, end).
+	//! Average depths are calculated only when vertex_depths is not null.
+	void deform_range(
+		int begin,
+		int end,
+		const std::vector<Matrix> *matrices,
+		const std::vector<Real> *bone_depths,
+		rendering::Mesh::VertexList *vertices,
+		std::vector<Real> *vertex_depths ) const
+	{
+		static const Real precision = 1e-10;
+
+		for(int j = begin; j < end; ++j)
+		{
+			const Vector &initial_position = positions[j];
+			Vector summary_position;
+			Real summary_depth = 0.0;
+			Real summary_weight = 0.0;
+
+			for(int k = first_influence[j]; k < first_influence[j + 1]; ++k)
+			{
+				int bone = influence_bones[k];
+				Real weight = influence_weights[k];
+				summary_position += (*matrices)[bone].get_transformed(initial_position) * weight;
+				summary_depth += (*bone_depths)[bone] * weight;
+				summary_weight += weight;
+			}
+
+			bool weighted = summary_weight > precision;
+			(*vertices)[j] = rendering::Mesh::Vertex(
+				weighted ? summary_position/summary_weight : initial_position,
+				initial_position );
+			if (vertex_depths)
+				(*vertex_depths)[j] = weighted ? summary_depth/summary_weight : 0.0;
+		}
+	}
+
+	void deform(
+		const std::vector<Matrix> &matrices,
+		const std::vector<Real> &bone_depths,
+		rendering::Mesh::VertexList &vertices,
+		std::vector<Real> *vertex_depths ) const
+	{
+		int count = (int)positions.size();
+		vertices.resize(count);
+		if (vertex_depths)
+			vertex_depths->resize(count);
+
+		int threads = std::min(ThreadPool::instance().get_max_threads(), count/min_vertices_per_thread);
+		if (threads <= 1) {
+			deform_range(0, count, &matrices, &bone_depths, &vertices, vertex_depths);
+			return;
+		}
+
+		ThreadPool::Group group;
+		for(int i = 0; i < threads; ++i)
+			group.enqueue( sigc::bind(
+				sigc::mem_fun(*this, &Skin::deform_range),
+				count*i/threads,
+				count*(i + 1)/threads,
+				&matrices,
+				&bone_depths,
+				&vertices,
+				vertex_depths ));
+		group.run();
+	}
+
+	void sort_triangles(const std::vector<Real> &vertex_depths)
+	{
+		std::vector<DepthTriangle> list;
+		list.reserve(triangles.size());
+		for(rendering::Mesh::TriangleList::const_iterator i = triangles.begin(); i != triangles.end(); i += 2)
+		{
+			// quad vertices are: i[0].vertices[0], i[0].vertices[1], i[1].vertices[1], i[0].vertices[2]
+			Real depth = 0.25*(vertex_depths[i[0].vertices[0]]
+					         + vertex_depths[i[0].vertices[1]]
+							 + vertex_depths[i[1].vertices[1]]
+							 + vertex_depths[i[0].vertices[2]]);
+			list.push_back(std::make_pair(depth, i[0]));
+			list.push_back(std::make_pair(depth, i[1]));
+		}
+
+		std::sort(list.begin(), list.end(), compare_triagles);
+		sorted_triangles.clear();
+		sorted_triangles.reserve(list.size());
+		for(std::vector<DepthTriangle>::const_iterator i = list.begin(); i != list.end(); ++i)
+			sorted_triangles.push_back(i->second);
+	}
+
+	static bool compare_triagles(const DepthTriangle &a, const DepthTriangle &b)
+	{
+		return a.first < b.first ? false
+			 : b.first < a.first ? true
+			 : a.second.vertices[0] < b.second.vertices[0] ? true
+			 : b.second.vertices[0] < a.second.vertices[0] ? false
+			 : a.second.vertices[1] < b.second.vertices[1] ? true
+			 : b.second.vertices[1] < a.second.vertices[1] ? false
+			 : a.second.vertices[2] < b.second.vertices[2];
+	}
+};
+
 /* === G L O B A L S ======================================================= */
 
 SYNFIG_LAYER_INIT(Layer_SkeletonDeformation);
@@ -175,32 +417,6 @@ Layer_SkeletonDeformation::prepare_mask()
 	this->mask = mask;
 }
 
-struct Layer_SkeletonDeformation::GridPoint {
-	Vector initial_position;
-	Vector summary_position;
-	Real summary_depth;
-	Real summary_weight;
-	Real average_depth;
-	bool used;
-
-	inline GridPoint():
-		summary_depth(0.0), summary_weight(0.0), average_depth(0.0), used(false) { }
-	inline explicit GridPoint(const Vector &initial_position):
-		initial_position(initial_position), summary_depth(0.0), summary_weight(0.0), average_depth(0.0), used(false) { }
-	static bool compare_triagles(
-		const std::pair<Real, rendering::Mesh::Triangle> &a,
-		const std::pair<Real, rendering::Mesh::Triangle> &b )
-	{
-		return a.first < b.first ? false
-			 : b.first < a.first ? true
-			 : a.second.vertices[0] < b.second.vertices[0] ? true
-			 : b.second.vertices[0] < a.second.vertices[0] ? false
-			 : a.second.vertices[1] < b.second.vertices[1] ? true
-			 : b.second.vertices[1] < a.second.vertices[1] ? false
-			 : a.second.vertices[2] < b.second.vertices[2];
-	}
-};
-
 Real Layer_SkeletonDeformation::distance_to_line(const Vector &p0, const Vector &p1, const Vector &x)
 {
 	const Real epsilon = 1e-10;
@@ -225,8 +441,6 @@ Real Layer_SkeletonDeformation::distance_to_line(const Vector &p0, const Vector
 void
 Layer_SkeletonDeformation::prepare_mesh()
 {
-	static const Real precision = 1e-10;
-
 	rendering::Mesh::Handle mesh(new rendering::Mesh());
 
 	// TODO: build grid with dynamic size
@@ -236,20 +450,10 @@ Layer_SkeletonDeformation::prepare_mesh()
 	const int grid_side_count_x = std::max(1, param_x_subdivisions.get(int())) + 1;
 	const int grid_side_count_y = std::max(1, param_y_subdivisions.get(int())) + 1;
 
-	const Real grid_step_x = (grid_p1[0] - grid_p0[0]) / (Real)(grid_side_count_x - 1);
-	const Real grid_step_y = (grid_p1[1] - grid_p0[1]) / (Real)(grid_side_count_y - 1);
-	const Real grid_step_diagonal = sqrt(grid_step_x*grid_step_x + grid_step_y*grid_step_y);
-
-	// build grid
-	std::vector<GridPoint> grid;
-	grid.reserve(grid_side_count_x * grid_side_count_y);
-	for(int j = 0; j < grid_side_count_y; ++j)
-		for(int i = 0; i < grid_side_count_x; ++i)
-			grid.push_back(GridPoint(Vector(
-				grid_p0[0] + i*grid_step_x,
-				grid_p0[1] + j*grid_step_y )));
-
-	// apply deformation
+	// collect bones
+	std::vector<Bone::Shape> shapes;
+	std::vector<Matrix> matrices;
+	std::vector<Real> depths;
 	if (param_bones.can_get(ValueBase::List()))
 	{
 		const ValueBase::List &bones = param_bones.get_list();
@@ -260,10 +464,6 @@ Layer_SkeletonDeformation::prepare_mesh()
 				const BonePair &bone_pair = i->get(BonePair());
 				Bone::Shape shape0 = bone_pair.first.get_shape();
 				Bone::Shape shape1 = bone_pair.second.get_shape();
-				Bone::Shape expandedShape0 = shape0;
-				expandedShape0.r0 += 2.0*grid_step_diagonal;
-				expandedShape0.r1 += 2.0*grid_step_diagonal;
-				Real depth = bone_pair.second.get_depth();
 
 				Matrix into_bone(
 					shape0.p1[0] - shape0.p0[0], shape0.p1[1] - shape0.p0[1], 0.0,
@@ -276,69 +476,29 @@ Layer_SkeletonDeformation::prepare_mesh()
 					shape1.p0[1] - shape1.p1[1], shape1.p1[0] - shape1.p0[0], 0.0,
 					shape1.p0[0], shape1.p0[1], 1.0
 				);
-				Matrix matrix = from_bone * into_bone;
 
-				for(std::vector<GridPoint>::iterator j = grid.begin(); j != grid.end(); ++j)
-				{
-					Real percent = Bone::distance_to_shape_center_percent(expandedShape0, j->initial_position);
-					if (percent > precision) {
-						Real distance = distance_to_line(shape0.p0, shape0.p1, j->initial_position);
-						if (distance < precision) distance = precision;
-						Real weight =
-							percent/(distance*distance);
-							// 1.0/distance;
-							// 1.0/(distance*distance);
-							// 1.0/(distance*distance*distance);
-							// exp(-4.0*distance);
-						j->summary_position += matrix.get_transformed(j->initial_position) * weight;
-						j->summary_depth += depth * weight;
-						j->summary_weight += weight;
-						j->used = true;
-					}
-				}
+				shapes.push_back(shape0);
+				matrices.push_back(from_bone * into_bone);
+				depths.push_back(bone_pair.second.get_depth());
 			}
 		}
 	}
 
-	// build vertices
-	mesh->vertices.reserve(grid.size());
-	for(std::vector<GridPoint>::iterator i = grid.begin(); i != grid.end(); ++i) {
-		Vector average_position = i->summary_weight > precision ? i->summary_position/i->summary_weight : i->initial_position;
-		i->average_depth = i->summary_weight > precision ? i->summary_depth/i->summary_weight : 0.0;
-		mesh->vertices.push_back( rendering::Mesh::Vertex(
-			average_position, i->initial_position ));
-	}
-
-	// build triangles
-	std::vector< std::pair<Real, rendering::Mesh::Triangle> > triangles;
-	triangles.reserve(2*(grid_side_count_x-1)*(grid_side_count_y-1));
-	for(int j = 1; j < grid_side_count_y; ++j)
-	{
-		for(int i = 1; i < grid_side_count_x; ++i)
-		{
-			int v[] = {
-				(j-1)*grid_side_count_x + (i-1),
-				(j-1)*grid_side_count_x +  i,
-				 j   *grid_side_count_x +  i,
-				 j   *grid_side_count_x + (i-1),
-			};
-			if (grid[v[0]].used && grid[v[1]].used && grid[v[2]].used && grid[v[3]].used)
-			{
-				Real depth = 0.25*(grid[v[0]].average_depth
-						         + grid[v[1]].average_depth
-								 + grid[v[2]].average_depth
-								 + grid[v[3]].average_depth);
-				triangles.push_back(std::make_pair(depth, rendering::Mesh::Triangle(v[0], v[1], v[3])));
-				triangles.push_back(std::make_pair(depth, rendering::Mesh::Triangle(v[1], v[2], v[3])));
-			}
-		}
+	// weights and triangles are rebuilt only when setup pose or grid was changed
+	if (!skin)
+		skin.reset(new Skin());
+	if (!skin->is_actual(grid_p0, grid_p1, grid_side_count_x, grid_side_count_y, shapes))
+		skin->build(grid_p0, grid_p1, grid_side_count_x, grid_side_count_y, shapes);
+
+	// apply deformation, triangles are resorted only when depths of bones was changed
+	bool sort = skin->depths != depths || skin->sorted_triangles.size() != skin->triangles.size();
+	std::vector<Real> vertex_depths;
+	skin->deform(matrices, depths, mesh->vertices, sort ? &vertex_depths : nullptr);
+	if (sort) {
+		skin->sort_triangles(vertex_depths);
+		skin->depths = depths;
 	}
-
-	// sort triangles
-	std::sort(triangles.begin(), triangles.end(), GridPoint::compare_triagles);
-	mesh->triangles.reserve(triangles.size());
-	for(std::vector< std::pair<Real, rendering::Mesh::Triangle> >::iterator i = triangles.begin(); i != triangles.end(); ++i)
-		mesh->triangles.push_back(i->second);
+	mesh->triangles = skin->sorted_triangles;
 
 	prepare_mask();
 	this->mesh = mesh;
@@ -30,6 +30,8 @@
 
 /* === H E A D E R S ======================================================= */
 
+#include <memory>
+
 #include "layer_meshtransform.h"
 #include <synfig/pair.h>
 #include <synfig/bone.h>
@@ -60,7 +62,10 @@ private:
 	//! Parameter: (Integer)
 	synfig::ValueBase param_y_subdivisions;
 
-	struct GridPoint;
+	struct Skin;
+	//! Bone weights of the grid vertices, they depend on setup pose of bones only
+	std::unique_ptr<Skin> skin;
+
 	static Real distance_to_line(const Vector &p0, const Vector &p1, const Vector &x);
 
 public:
@@ -33,12 +33,20 @@
 #	include <config.h>
 #endif
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <mutex>
+
 #include "listimporter.h"
 
 #include "general.h"
 #include <synfig/localization.h>
 
+#include "clock.h"
 #include "filesystemnative.h"
+#include "imagecache.h"
 #include <synfig/rendering/software/surfacesw.h>
 
 
@@ -51,6 +59,7 @@ using namespace synfig;
 /* === M A C R O S ========================================================= */
 
 #define LIST_IMPORTER_CACHE_SIZE	20
+#define LIST_IMPORTER_READ_AHEAD_DEFAULT	8
 
 /* === G L O B A L S ======================================================= */
 
@@ -60,12 +69,21 @@ SYNFIG_IMPORTER_SET_EXT(ListImporter,"lst");
 SYNFIG_IMPORTER_SET_VERSION(ListImporter,"0.1");
 SYNFIG_IMPORTER_SET_SUPPORTS_FILE_SYSTEM_WRAPPER(ListImporter, false);
 
+//! -1 until it is read from the environment
+static std::atomic<int> read_ahead_frames(-1);
+
+static std::mutex statistics_mutex;
+static ListImporter::Statistics statistics;
+
 /* === P R O C E D U R E S ================================================= */
 
 /* === M E T H O D S ======================================================= */
 
 ListImporter::ListImporter(const FileSystem::Identifier &identifier):
-Importer(identifier)
+Importer(identifier),
+last_time_valid(false),
+last_step(),
+last_step_valid(false)
 {
 	fps=15;
 
@@ -157,13 +175,54 @@ Importer(identifier)
 
 ListImporter::~ListImporter() = default;
 
-Importer::Handle
-ListImporter::get_sub_importer(const RendDesc &renddesc, Time time, ProgressCallback *cb)
+void
+ListImporter::set_read_ahead(int frames)
+{
+	read_ahead_frames = std::max(0, frames);
+}
+
+int
+ListImporter::get_read_ahead()
+{
+	int frames = read_ahead_frames;
+	if (frames < 0) {
+		frames = LIST_IMPORTER_READ_AHEAD_DEFAULT;
+		if (const char *s = getenv("SYNFIG_LIST_IMPORTER_READ_AHEAD"))
+			frames = std::max(0, atoi(s));
+		read_ahead_frames = frames;
+	}
+	return frames;
+}
+
+ListImporter::Statistics
+ListImporter::get_statistics()
+{
+	std::lock_guard<std::mutex> lock(statistics_mutex);
+	return statistics;
+}
+
+void
+ListImporter::reset_statistics()
+{
+	std::lock_guard<std::mutex> lock(statistics_mutex);
+	statistics = Statistics();
+}
+
+int
+ListImporter::get_frame_index(const RendDesc &renddesc, Time time) const
 {
 	float document_fps=renddesc.get_frame_rate();
 	int document_frame=round_to_int(time*document_fps);
 	int frame = std::floor(document_frame*fps/document_fps);
 
+	if(frame>=(signed)filename_list.size())frame=filename_list.size()-1;
+	if(frame<0)frame=0;
+	return frame;
+}
+
+Importer::Handle
+ListImporter::get_sub_importer(const RendDesc &renddesc, Time time, ProgressCallback *cb)
+{
 	if(!filename_list.size())
 	{
 		if (cb) cb->error(_("No images in list"));
@@ -171,10 +230,7 @@ ListImporter::get_sub_importer(const RendDesc &renddesc, Time time, ProgressCall
 		return Importer::Handle();
 	}
 
-	if(frame<0)frame=0;
-	if(frame>=(signed)filename_list.size())frame=filename_list.size()-1;
-
-	const String &filename = filename_list[frame];
+	const String &filename = filename_list[get_frame_index(renddesc, time)];
 	Importer::Handle importer(Importer::open(FileSystem::Identifier(FileSystemNative::instance(), filename)));
 	if(!importer)
 	{
@@ -194,6 +250,53 @@ ListImporter::get_sub_importer(const RendDesc &renddesc, Time time, ProgressCall
 	return importer;
 }
 
+void
+ListImporter::prefetch(int frame, int proxy_level, const RendDesc &renddesc)
+{
+	FileSystem::Identifier identifier(FileSystemNative::instance(), filename_list[frame]);
+	ImageCache::Key key = ImageCache::make_key(identifier, Time());
+	key.proxy_level = proxy_level;
+	if (key.empty() || ImageCache::instance().contains(key))
+		return;
+	if (Importer::Handle importer = Importer::open(identifier))
+		ImageCache::instance().prefetch(key, importer, renddesc);
+}
+
+void
+ListImporter::read_ahead(const RendDesc &renddesc, Time time, int proxy_level)
+{
+	const int window = get_read_ahead();
+
+	// the render goes with the same step as between the last requests,
+	// big jumps are seeks, then assume playback forward.
+	// Importers are shared between layers, so requests of layers with
+	// different time offsets are interleaved: steps which differ from
+	// the previous one are not trusted either.
+	Real frame_duration = renddesc.get_frame_rate() > 0 ? 1.0/renddesc.get_frame_rate() : 1.0/fps;
+	Real step = last_time_valid ? Real(time - last_time) : 0.0;
+	const bool steady = !last_step_valid || approximate_equal_lp(step, last_step);
+	last_step = step;
+	last_step_valid = last_time_valid;
+	if (!steady || approximate_zero(step) || std::fabs(step) > frame_duration*(window + 1))
+		step = frame_duration;
+	last_time = time;
+	last_time_valid = true;
+
+	const int frame = get_frame_index(renddesc, time);
+	int previous = frame;
+	// several steps may map to the same file, so look a bit further than the window
+	for(int i = 1, queued = 0; queued < window && i <= 4*window; ++i) {
+		int next = get_frame_index(renddesc, Time(Real(time) + step*i));
+		if (next == previous)
+			continue;
+		previous = next;
+		if (filename_list[next] == filename_list[frame])
+			continue;
+		prefetch(next, proxy_level, renddesc);
+		++queued;
+	}
+}
+
 bool
 ListImporter::get_frame(Surface &surface, const RendDesc &renddesc, Time time, ProgressCallback *cb)
 {
@@ -202,10 +305,32 @@ ListImporter::get_frame(Surface &surface, const RendDesc &renddesc, Time time, P
 }
 
 rendering::Surface::Handle
-ListImporter::get_frame(const RendDesc &renddesc, const Time &time)
+ListImporter::get_frame(const RendDesc &renddesc, const Time &time, int proxy_level)
 {
 	Importer::Handle importer = get_sub_importer(renddesc, time, nullptr);
-	return importer ? importer->get_frame(renddesc, 0) : new rendering::SurfaceSW();
+	if (!importer)
+		return new rendering::SurfaceSW();
+
+	ImageCache::Key key = ImageCache::make_key(importer->identifier, Time());
+	key.proxy_level = proxy_level;
+	const bool stalled = ImageCache::instance().is_pending(key);
+	const bool ready = !stalled && ImageCache::instance().contains(key);
+
+	read_ahead(renddesc, time, proxy_level);
+
+	synfig::clock timer;
+	rendering::Surface::Handle surface = importer->get_frame(renddesc, 0, proxy_level);
+	const float wait = timer();
+
+	std::lock_guard<std::mutex> lock(statistics_mutex);
+	++statistics.frames;
+	if (ready) {
+		++statistics.ready;
+	} else {
+		++(stalled ? statistics.stalls : statistics.misses);
+		statistics.stall_time += wait;
+	}
+	return surface;
 }
 
 bool
@@ -45,25 +45,63 @@
 namespace synfig {
 
 /*!	\class ListImporter
-**	\todo Write more detailed description
+**	\brief Imports image sequences (.lst files) and Papagayo lip sync files
+**
+**	Frames which will be needed next are predicted by the time step between
+**	the last requests and decoded by the thread pool into ImageCache, so
+**	the render waits for a decode only when the read-ahead falls behind.
+**	The window is 8 frames by default, it may be changed by set_read_ahead()
+**	or by the SYNFIG_LIST_IMPORTER_READ_AHEAD environment variable.
 */
 class ListImporter : public Importer
 {
 	SYNFIG_IMPORTER_MODULE_EXT
+public:
+	//! Process-wide counters of frames requested from image sequences
+	struct Statistics
+	{
+		long long frames;  //!< frames requested
+		long long ready;   //!< frames which were already decoded
+		long long stalls;  //!< frames which were still being decoded in background
+		long long misses;  //!< frames which were not read ahead and were decoded synchronously
+		double stall_time; //!< total time of waiting for stalled and missed frames, in seconds
+
+		Statistics(): frames(), ready(), stalls(), misses(), stall_time() { }
+	};
+
 private:
 	float fps;
 	std::vector<String> filename_list;
 	std::list<Importer::Handle> frame_cache;
 
+	//! time of the previous request, to predict the next ones
+	Time last_time;
+	bool last_time_valid;
+	//! step between the previous requests, the prediction is used only while steps repeat
+	Real last_step;
+	bool last_step_valid;
+
+	int get_frame_index(const RendDesc &renddesc, Time time) const;
 	Importer::Handle get_sub_importer(const RendDesc &renddesc, Time time, ProgressCallback *cb);
+	//! Starts decoding of the frame in background
+	void prefetch(int frame, int proxy_level, const RendDesc &renddesc);
+	//! Starts decoding of the frames predicted to be needed after \a time
+	void read_ahead(const RendDesc &renddesc, Time time, int proxy_level);
 
 public:
 	ListImporter(const FileSystem::Identifier &identifier);
 
 	~ListImporter();
 
+	//! Sets count of frames decoded ahead, 0 disables read-ahead
+	static void set_read_ahead(int frames);
+	static int get_read_ahead();
+
+	static Statistics get_statistics();
+	static void reset_statistics();
+
 	virtual bool get_frame(Surface &surface, const RendDesc &renddesc, Time time, ProgressCallback* cb = nullptr);
-	virtual rendering::Surface::Handle get_frame(const RendDesc &renddesc, const Time &time);
+	virtual rendering::Surface::Handle get_frame(const RendDesc &renddesc, const Time &time, int proxy_level = 0);
 	virtual bool is_animated();
 
 };
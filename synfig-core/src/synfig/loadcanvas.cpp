@@ -43,10 +43,12 @@
 
 #include <iostream>
 #include <map>
+#include <memory>
 #include <vector>
 #include <stdexcept>
 
 #include <libxml++/libxml++.h>
+#include <libxml/xmlreader.h>
 #include <sigc++/bind.h>
 
 #include "loadcanvas.h"
@@ -55,6 +57,7 @@
 #include "localization.h"
 
 #include "blur.h"
+#include "canvasbinary.h"
 #include "dashitem.h"
 #include "exception.h"
 #include "gradient.h"
@@ -99,6 +102,20 @@ inline bool is_whitespace(char x) { return ((x)=='\n' || (x)=='\t' || (x)==' ');
 inline bool is_true(const std::string& s) { return s=="1" || s=="true" || s=="TRUE" || s=="True"; }
 inline bool is_false(const std::string& s) { return s=="0" || s=="false" || s=="FALSE" || s=="False"; }
 
+static int xml_read_stream(void *context, char *buffer, int len)
+{
+	std::istream &stream = *static_cast<std::istream*>(context);
+	if (stream.bad()) return -1;
+	stream.read(buffer, len);
+	return (int)stream.gcount();
+}
+
+static int xml_close_stream(void *)
+	{ return 0; }
+
+static std::string xml_string(const xmlChar *x)
+	{ return x ? std::string((const char*)x) : std::string(); }
+
 std::set<FileSystem::Identifier> CanvasParser::loading_;
 
 /* === P R O C E D U R E S ================================================= */
@@ -219,7 +236,7 @@ CanvasParser::error_unexpected_element(xmlpp::Node *element,const String &got)
 void
 CanvasParser::warning(xmlpp::Node *element, const String &text)
 {
-	std::string str=strprintf("%s:<%s>:%d: ",filename.c_str(),element->get_name().c_str(),element->get_line())+text;
+	std::string str=strprintf("%s:<%s>:%d: ",filename.c_str(),element->get_name().c_str(),element->get_line() + line_offset_)+text;
 
 	synfig::warning(str);
 	// cerr<<str<<endl;
@@ -233,7 +250,7 @@ CanvasParser::warning(xmlpp::Node *element, const String &text)
 void
 CanvasParser::error(xmlpp::Node *element, const String &text)
 {
-	std::string str=strprintf("%s:<%s>:%d: error: ",filename.c_str(),element->get_name().c_str(),element->get_line())+text;
+	std::string str=strprintf("%s:<%s>:%d: error: ",filename.c_str(),element->get_name().c_str(),element->get_line() + line_offset_)+text;
 	total_errors_++;
 	errors_text += "  * " + str + "\n";
 	if(!allow_errors_)
@@ -245,7 +262,7 @@ CanvasParser::error(xmlpp::Node *element, const String &text)
 void
 CanvasParser::fatal_error(xmlpp::Node *element, const String &text)
 {
-	std::string str=strprintf("%s:<%s>:%d:",filename.c_str(),element->get_name().c_str(),element->get_line())+text;
+	std::string str=strprintf("%s:<%s>:%d:",filename.c_str(),element->get_name().c_str(),element->get_line() + line_offset_)+text;
 	throw std::runtime_error(str);
 }
 
@@ -282,6 +299,18 @@ CanvasParser::parse_keyframe(xmlpp::Element *element,Canvas::Handle canvas)
 }
 
 
+bool
+CanvasParser::get_binary_number(const xmlpp::Element *element,Real &x)const
+{
+	if(!binary_numbers_)
+		return false;
+	CanvasBinary::Numbers::const_iterator i = binary_numbers_->find(element);
+	if(i == binary_numbers_->end())
+		return false;
+	x = i->second;
+	return true;
+}
+
 Real
 CanvasParser::parse_real(xmlpp::Element *element)
 {
@@ -290,6 +319,10 @@ CanvasParser::parse_real(xmlpp::Element *element)
 	if(!element->get_children().empty())
 		warning(element, strprintf(_("<%s> should not contain anything"),"real"));
 
+	Real value;
+	if(get_binary_number(element, value))
+		return value;
+
 	if(!element->get_attribute("value"))
 	{
 		error(element,strprintf(_("<%s> is missing \"value\" attribute"),"real"));
@@ -380,6 +413,8 @@ CanvasParser::parse_vector(xmlpp::Element *element)
 		else
 		if(child->get_name()=="x")
 		{
+			if(get_binary_number(child, vect[0]))
+				continue;
 			if(child->get_children().empty())
 			{
 				error(element, "Undefined value in <x>");
@@ -390,6 +425,8 @@ CanvasParser::parse_vector(xmlpp::Element *element)
 		else
 		if(child->get_name()=="y")
 		{
+			if(get_binary_number(child, vect[1]))
+				continue;
 			if(child->get_children().empty())
 			{
 				error(element, "Undefined value in <y>");
@@ -428,6 +465,12 @@ CanvasParser::parse_color(xmlpp::Element *element)
 		else
 		if(child->get_name()=="r")
 		{
+			Real value;
+			if(get_binary_number(child, value))
+			{
+				color.set_r(value);
+				continue;
+			}
 			if(child->get_children().empty())
 			{
 				error(element, "Undefined value in <r>");
@@ -438,6 +481,12 @@ CanvasParser::parse_color(xmlpp::Element *element)
 		else
 		if(child->get_name()=="g")
 		{
+			Real value;
+			if(get_binary_number(child, value))
+			{
+				color.set_g(value);
+				continue;
+			}
 			if(child->get_children().empty())
 			{
 				error(element, "Undefined value in <g>");
@@ -448,6 +497,12 @@ CanvasParser::parse_color(xmlpp::Element *element)
 		else
 		if(child->get_name()=="b")
 		{
+			Real value;
+			if(get_binary_number(child, value))
+			{
+				color.set_b(value);
+				continue;
+			}
 			if(child->get_children().empty())
 			{
 				error(element, "Undefined value in <b>");
@@ -458,6 +513,12 @@ CanvasParser::parse_color(xmlpp::Element *element)
 		else
 		if(child->get_name()=="a")
 		{
+			Real value;
+			if(get_binary_number(child, value))
+			{
+				color.set_a(value);
+				continue;
+			}
 			if(child->get_children().empty())
 			{
 				error(element, "Undefined value in <a>");
@@ -1273,6 +1334,10 @@ CanvasParser::parse_angle(xmlpp::Element *element)
 	if(!element->get_children().empty())
 		warning(element, strprintf(_("<%s> should not contain anything"),"angle"));
 
+	Real value;
+	if(get_binary_number(element, value))
+		return Angle::deg(value);
+
 	if(!element->get_attribute("value"))
 	{
 		error(element,strprintf(_("<%s> is missing \"value\" attribute"),"angle"));
@@ -3138,8 +3203,9 @@ CanvasParser::parse_layer(xmlpp::Element *element,Canvas::Handle canvas)
 }
 
 Canvas::Handle
-CanvasParser::parse_canvas(xmlpp::Element *element,Canvas::Handle parent,bool inline_,const FileSystem::Identifier &identifier,String filename)
+CanvasParser::parse_canvas_header(xmlpp::Element *element,Canvas::Handle parent,bool inline_,const FileSystem::Identifier &identifier,String filename,bool &finished)
 {
+	finished=true;
 
 	if(element->get_name()!="canvas")
 	{
@@ -3307,164 +3373,163 @@ CanvasParser::parse_canvas(xmlpp::Element *element,Canvas::Handle parent,bool in
 
 	canvas->rend_desc().set_flags(RendDesc::PX_ASPECT|RendDesc::IM_SPAN);
 
-	std::list<ValueNode::Handle> bone_list;
-	xmlpp::Element::NodeList list = element->get_children();
-	for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
+	finished=false;
+	return canvas;
+}
+
+void
+CanvasParser::parse_canvas_child(xmlpp::Element *child,Canvas::Handle canvas)
+{
+	if(child->get_name()=="defs")
 	{
-		xmlpp::Element *child(dynamic_cast<xmlpp::Element*>(*iter));
-		if(child)
+		if(canvas->is_inline())
+			error(child,_("Group canvases cannot have a <defs> section"));
+		parse_canvas_defs(child, canvas);
+	}
+	else
+	if(child->get_name()=="bones")
+	{
+		if(canvas->is_inline())
+			error(child,_("Inline canvas cannot have a <bones> section"));
+		bones_.splice(bones_.end(), parse_canvas_bones(child, canvas));
+	}
+	else
+	if(child->get_name()=="keyframe")
+	{
+		if(canvas->is_inline())
 		{
-			if(child->get_name()=="defs")
-			{
-				if(canvas->is_inline())
-					error(child,_("Group canvases cannot have a <defs> section"));
-				parse_canvas_defs(child, canvas);
-			}
-			else
-			if(child->get_name()=="bones")
-			{
-				if(canvas->is_inline())
-					error(child,_("Inline canvas cannot have a <bones> section"));
-				bone_list = parse_canvas_bones(child, canvas);
-			}
-			else
-			if(child->get_name()=="keyframe")
-			{
-				if(canvas->is_inline())
-				{
-					warning(child,_("Group canvases cannot have keyframes"));
-					continue;
-				}
+			warning(child,_("Group canvases cannot have keyframes"));
+			return;
+		}
 
-				canvas->keyframe_list().add(parse_keyframe(child,canvas));
-				canvas->keyframe_list().sync();
-			}
-			else
-			if(child->get_name()=="meta")
-			{
-				if(canvas->is_inline())
-				{
-					warning(child,_("Group canvases cannot have metadata"));
-					continue;
-				}
+		canvas->keyframe_list().add(parse_keyframe(child,canvas));
+		canvas->keyframe_list().sync();
+	}
+	else
+	if(child->get_name()=="meta")
+	{
+		if(canvas->is_inline())
+		{
+			warning(child,_("Group canvases cannot have metadata"));
+			return;
+		}
 
-				if(!child->get_attribute("name"))
-				{
-					warning(child,_("<meta> must have a name"));
-					continue;
-				}
+		if(!child->get_attribute("name"))
+		{
+			warning(child,_("<meta> must have a name"));
+			return;
+		}
 
-				if(!child->get_attribute("content"))
-				{
-					warning(child,_("<meta> must have content"));
-					continue;
-				}
-				
-				std::string meta_name = child->get_attribute("name")->get_value();
-				std::string content = child->get_attribute("content")->get_value();
-
-				// In Synfig prior to version 1.0 we have messed decimal separator:
-				// some files use ".", but other ones use ","/
-				// Let's try to put a workaround for that.
-				std::vector<String> replacelist;
-				replacelist.push_back("background_first_color");
-				replacelist.push_back("background_second_color");
-				replacelist.push_back("background_size");
-				replacelist.push_back("grid_color");
-				replacelist.push_back("grid_size");
-				replacelist.push_back("jack_offset");
-				if(std::find(replacelist.begin(), replacelist.end(), meta_name) != replacelist.end())
-				{
-					size_t index = 0;
-					while (true) {
-					     /* Locate the substring to replace. */
-					     index = content.find(',', index);
-					     if (index == std::string::npos) break;
+		if(!child->get_attribute("content"))
+		{
+			warning(child,_("<meta> must have content"));
+			return;
+		}
+		
+		std::string meta_name = child->get_attribute("name")->get_value();
+		std::string content = child->get_attribute("content")->get_value();
 
-					     /* Make the replacement. */
-					     content.replace(index, 1, ".");
+		// In Synfig prior to version 1.0 we have messed decimal separator:
+		// some files use ".", but other ones use ","/
+		// Let's try to put a workaround for that.
+		std::vector<String> replacelist;
+		replacelist.push_back("background_first_color");
+		replacelist.push_back("background_second_color");
+		replacelist.push_back("background_size");
+		replacelist.push_back("grid_color");
+		replacelist.push_back("grid_size");
+		replacelist.push_back("jack_offset");
+		if(std::find(replacelist.begin(), replacelist.end(), meta_name) != replacelist.end())
+		{
+			size_t index = 0;
+			while (true) {
+			     /* Locate the substring to replace. */
+			     index = content.find(',', index);
+			     if (index == std::string::npos) break;
 
-					     /* Advance index forward so the next iteration doesn't pick it up as well. */
-					     index += 1;
-					}
-					
-				}
+			     /* Make the replacement. */
+			     content.replace(index, 1, ".");
 
-				// Commit b172e37 (#2777) changed guide lines storage to give them rotation ability
-				if (meta_name == "guide_x") {
-					upgrade_guide_metadata(content, canvas->get_meta_data("guide"), true);
-					meta_name = "guide";
-				}
+			     /* Advance index forward so the next iteration doesn't pick it up as well. */
+			     index += 1;
+			}
+			
+		}
 
-				if (meta_name == "guide_y") {
-					upgrade_guide_metadata(content, canvas->get_meta_data("guide"), false);
-					meta_name = "guide";
-				}
+		// Commit b172e37 (#2777) changed guide lines storage to give them rotation ability
+		if (meta_name == "guide_x") {
+			upgrade_guide_metadata(content, canvas->get_meta_data("guide"), true);
+			meta_name = "guide";
+		}
 
-				canvas->set_meta_data(meta_name, content);
-			}
-			else if(child->get_name()=="name")
-			{
-				xmlpp::Element::NodeList list = child->get_children();
+		if (meta_name == "guide_y") {
+			upgrade_guide_metadata(content, canvas->get_meta_data("guide"), false);
+			meta_name = "guide";
+		}
 
-				// If we don't have any name, warn
-				if(list.empty())
-					warning(child,_("blank \"name\" entity"));
+		canvas->set_meta_data(meta_name, content);
+	}
+	else if(child->get_name()=="name")
+	{
+		xmlpp::Element::NodeList list = child->get_children();
 
-				std::string tmp;
-				for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
-					if(dynamic_cast<xmlpp::TextNode*>(*iter))tmp+=dynamic_cast<xmlpp::TextNode*>(*iter)->get_content();
-				canvas->set_name(tmp);
-			}
-			else
-			if(child->get_name()=="desc")
-			{
+		// If we don't have any name, warn
+		if(list.empty())
+			warning(child,_("blank \"name\" entity"));
 
-				xmlpp::Element::NodeList list = child->get_children();
+		std::string tmp;
+		for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
+			if(dynamic_cast<xmlpp::TextNode*>(*iter))tmp+=dynamic_cast<xmlpp::TextNode*>(*iter)->get_content();
+		canvas->set_name(tmp);
+	}
+	else
+	if(child->get_name()=="desc")
+	{
 
-				// If we don't have any description, warn
-				if(list.empty())
-					warning(child,_("blank \"desc\" entity"));
+		xmlpp::Element::NodeList list = child->get_children();
 
-				std::string tmp;
-				for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
-					if(dynamic_cast<xmlpp::TextNode*>(*iter))tmp+=dynamic_cast<xmlpp::TextNode*>(*iter)->get_content();
-				canvas->set_description(tmp);
-			}
-			else
-			if(child->get_name()=="author")
-			{
+		// If we don't have any description, warn
+		if(list.empty())
+			warning(child,_("blank \"desc\" entity"));
 
-				xmlpp::Element::NodeList list = child->get_children();
+		std::string tmp;
+		for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
+			if(dynamic_cast<xmlpp::TextNode*>(*iter))tmp+=dynamic_cast<xmlpp::TextNode*>(*iter)->get_content();
+		canvas->set_description(tmp);
+	}
+	else
+	if(child->get_name()=="author")
+	{
 
-				// If we don't have any description, warn
-				if(list.empty())
-					warning(child,_("blank \"author\" entity"));
+		xmlpp::Element::NodeList list = child->get_children();
 
-				std::string tmp;
-				for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
-					if(dynamic_cast<xmlpp::TextNode*>(*iter))tmp+=dynamic_cast<xmlpp::TextNode*>(*iter)->get_content();
-				canvas->set_author(tmp);
-			}
-			else
-			if(child->get_name()=="layer")
-			{
-				//if(canvas->is_inline())
-				//	canvas->push_front(parse_layer(child,canvas->parent()));
-				//else
-					canvas->push_front(parse_layer(child,canvas));
-			}
-			else
-			{
-				printf("%s:%d\n", __FILE__, __LINE__);
-				error_unexpected_element(child,child->get_name());
-			}
-		}
-//		else
-//		if((child->get_name()=="text"||child->get_name()=="comment") && child->has_child_text())
-//			continue;
+		// If we don't have any description, warn
+		if(list.empty())
+			warning(child,_("blank \"author\" entity"));
+
+		std::string tmp;
+		for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
+			if(dynamic_cast<xmlpp::TextNode*>(*iter))tmp+=dynamic_cast<xmlpp::TextNode*>(*iter)->get_content();
+		canvas->set_author(tmp);
+	}
+	else
+	if(child->get_name()=="layer")
+	{
+		//if(canvas->is_inline())
+		//	canvas->push_front(parse_layer(child,canvas->parent()));
+		//else
+			canvas->push_front(parse_layer(child,canvas));
+	}
+	else
+	{
+		printf("%s:%d\n", __FILE__, __LINE__);
+		error_unexpected_element(child,child->get_name());
 	}
+}
 
+void
+CanvasParser::parse_canvas_footer(xmlpp::Element *element,Canvas::Handle canvas)
+{
 	if(canvas->value_node_list().placeholder_count())
 	{
 		String nodes;
@@ -3482,6 +3547,129 @@ CanvasParser::parse_canvas(xmlpp::Element *element,Canvas::Handle parent,bool in
 	}
 
 	canvas->set_version(CURRENT_CANVAS_VERSION);
+}
+
+Canvas::Handle
+CanvasParser::parse_canvas(xmlpp::Element *element,Canvas::Handle parent,bool inline_,const FileSystem::Identifier &identifier,String filename)
+{
+	bool finished;
+	Canvas::Handle canvas = parse_canvas_header(element, parent, inline_, identifier, filename, finished);
+	if (finished)
+		return canvas;
+
+	xmlpp::Element::NodeList list = element->get_children();
+	for(xmlpp::Element::NodeList::iterator iter = list.begin(); iter != list.end(); ++iter)
+		if (xmlpp::Element *child = dynamic_cast<xmlpp::Element*>(*iter))
+			parse_canvas_child(child, canvas);
+
+	parse_canvas_footer(element, canvas);
+	return canvas;
+}
+
+Canvas::Handle
+CanvasParser::parse_canvas_stream(std::istream &stream,const FileSystem::Identifier &identifier,String filename)
+{
+	std::unique_ptr<xmlTextReader, void(*)(xmlTextReaderPtr)> reader(
+		xmlReaderForIO(xml_read_stream, xml_close_stream, &stream, filename.c_str(), nullptr, XML_PARSE_HUGE),
+		xmlFreeTextReader );
+	if (!reader)
+		throw std::runtime_error(String("  * ") + _("Can't open file") + " \"" + filename + "\"");
+
+	// find the root element
+	int ret;
+	while((ret = xmlTextReaderRead(reader.get())) == 1)
+		if (xmlTextReaderNodeType(reader.get()) == XML_READER_TYPE_ELEMENT)
+			break;
+	if (ret != 1)
+		throw std::runtime_error(strprintf("%s: %s", filename.c_str(), _("Unable to parse XML document")));
+
+	// the root element is copied without children, only its attributes are used to create the canvas
+	const int root_line = xmlGetLineNo(xmlTextReaderCurrentNode(reader.get()));
+	const bool root_is_empty = xmlTextReaderIsEmptyElement(reader.get()) == 1;
+	xmlpp::Document root_document;
+	xmlpp::Element *root = root_document.create_root_node(xml_string(xmlTextReaderConstName(reader.get())));
+	while(xmlTextReaderMoveToNextAttribute(reader.get()) == 1)
+		if (xmlTextReaderIsNamespaceDecl(reader.get()) != 1)
+			root->set_attribute(
+				xml_string(xmlTextReaderConstName(reader.get())),
+				xml_string(xmlTextReaderConstValue(reader.get())) );
+	xmlTextReaderMoveToElement(reader.get());
+
+	line_offset_ = root_line;
+	bool finished;
+	Canvas::Handle canvas = parse_canvas_header(root, 0, false, identifier, filename, finished);
+	if (finished)
+		return canvas;
+
+	// each child element is expanded by the reader and parsed in place,
+	// the reader drops the already passed nodes, so memory usage does not grow with the file
+	if (!root_is_empty) {
+		line_offset_ = 0;
+		ret = xmlTextReaderRead(reader.get());
+		while(ret == 1 && xmlTextReaderDepth(reader.get()) > 0) {
+			if (xmlTextReaderNodeType(reader.get()) != XML_READER_TYPE_ELEMENT) {
+				ret = xmlTextReaderRead(reader.get());
+				continue;
+			}
+
+			xmlNode *node = xmlTextReaderExpand(reader.get());
+			if (!node) {
+				ret = -1;
+				break;
+			}
+
+			// wrappers of libxml++ are created on demand, and must be freed
+			// before the reader frees the nodes
+			xmlpp::Node::create_wrapper(node);
+			try {
+				parse_canvas_child(static_cast<xmlpp::Element*>(node->_private), canvas);
+			} catch(...) {
+				xmlpp::Node::free_wrappers(node);
+				throw;
+			}
+			xmlpp::Node::free_wrappers(node);
+
+			ret = xmlTextReaderNext(reader.get());
+		}
+		if (ret == -1)
+			throw std::runtime_error(strprintf("%s: %s", filename.c_str(), _("Unable to parse XML document")));
+	}
+
+	line_offset_ = root_line;
+	parse_canvas_footer(root, canvas);
+	line_offset_ = 0;
+	return canvas;
+}
+
+Canvas::Handle
+CanvasParser::parse_canvas_binary(std::istream &stream,const FileSystem::Identifier &identifier,String filename)
+{
+	CanvasBinary::Reader reader(stream);
+
+	xmlpp::Document root_document;
+	reader.read_root(root_document);
+	xmlpp::Element *root = root_document.get_root_node();
+
+	bool finished;
+	Canvas::Handle canvas = parse_canvas_header(root, 0, false, identifier, filename, finished);
+	if (finished)
+		return canvas;
+
+	// like parse_canvas_stream(), only one top-level child is kept in memory
+	binary_numbers_ = &reader.get_numbers();
+	try
+	{
+		while(true) {
+			xmlpp::Document document;
+			if (!reader.read_child(document))
+				break;
+			parse_canvas_child(document.get_root_node(), canvas);
+		}
+	}
+	catch(...) { binary_numbers_ = nullptr; throw; }
+	binary_numbers_ = nullptr;
+
+	parse_canvas_footer(root, canvas);
 	return canvas;
 }
 
@@ -3524,39 +3712,41 @@ CanvasParser::parse_from_file_as(const FileSystem::Identifier &identifier,const
 
 		filename=as;
 		total_warnings_=0;
+		line_offset_=0;
+		bones_.clear();
 		
 		synfig::info(String("Loading file: ") + filename);
 		FileSystem::ReadStream::Handle stream = identifier.get_read_stream();
 		if (stream)
 		{
-			if (identifier.filename.extension().u8string() == ".sifz")
+			const String extension = identifier.filename.extension().u8string();
+			if (extension == ".sifz")
 				stream = FileSystem::ReadStream::Handle(new ZReadStream(stream, zstreambuf::compression::gzip));
 
-			xmlpp::DomParser parser;
-			parser.parse_stream(*stream);
+			Canvas::Handle canvas(extension == ".sifb"
+				? parse_canvas_binary(*stream,identifier,as)
+				: parse_canvas_stream(*stream,identifier,as));
 			stream.reset();
-			if(parser)
-			{
-				Canvas::Handle canvas(parse_canvas(parser.get_document()->get_root_node(),0,false,identifier,as));
-				if (!canvas) return canvas;
-				register_canvas_in_map(canvas, as);
+			// bones are referenced by the layers now, or not used at all
+			bones_.clear();
+			if (!canvas) return canvas;
+			register_canvas_in_map(canvas, as);
 
-				const ValueNodeList& value_node_list(canvas->value_node_list());
+			const ValueNodeList& value_node_list(canvas->value_node_list());
 
-				again:
-				ValueNodeList::const_iterator iter;
-				for(iter=value_node_list.begin();iter!=value_node_list.end();++iter)
+			again:
+			ValueNodeList::const_iterator iter;
+			for(iter=value_node_list.begin();iter!=value_node_list.end();++iter)
+			{
+				ValueNode::Handle value_node(*iter);
+				if(value_node->is_exported() && value_node->get_id().find("Unnamed")==0)
 				{
-					ValueNode::Handle value_node(*iter);
-					if(value_node->is_exported() && value_node->get_id().find("Unnamed")==0)
-					{
-						canvas->remove_value_node(value_node, true);
-						goto again;
-					}
+					canvas->remove_value_node(value_node, true);
+					goto again;
 				}
-
-				return canvas;
 			}
+
+			return canvas;
 		} else {
 			throw std::runtime_error(String("  * ") + _("Can't find linked file") + " \"" + identifier.filename.u8string() + "\"");
 		}
@@ -3597,7 +3787,9 @@ CanvasParser::parse_as(xmlpp::Element* node,String &errors)
 		total_warnings_=0;
 		if(node)
 		{
+			bones_.clear();
 			Canvas::Handle canvas(parse_canvas(node,0,false,FileSystemNative::instance()->get_identifier(std::string()),""));
+			bones_.clear();
 			if (!canvas) return canvas;
 
 			const ValueNodeList& value_node_list(canvas->value_node_list());
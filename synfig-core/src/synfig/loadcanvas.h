@@ -34,6 +34,7 @@
 
 #include "string.h"
 #include "canvas.h"
+#include "canvasbinary.h"
 #include "valuenode.h"
 #include "vector.h"
 #include "value.h"
@@ -87,6 +88,14 @@ private:
 	GUID guid_;
 	//
 	bool in_bones_section;
+	//! Line of the currently parsed fragment in the source file.
+	//! Added to the line numbers in messages when the file is streamed by fragments.
+	int line_offset_;
+	//! Bones of the <bones> sections. The bone map keeps only loose handles,
+	//! so bones are held here until the whole document is parsed.
+	std::list<ValueNode::Handle> bones_;
+	//! Numbers decoded by the reader of a .sifb file, or null for .sif
+	const CanvasBinary::Numbers *binary_numbers_;
 
 	/*
  --	** -- C O N S T R U C T O R S ---------------------------------------------
@@ -99,7 +108,9 @@ public:
 		total_warnings_	(0),
 		total_errors_	(0),
 		allow_errors_	(false),
-		in_bones_section(false)
+		in_bones_section(false),
+		line_offset_	(0),
+		binary_numbers_	(nullptr)
 	{ }
 
 	/*
@@ -165,8 +176,23 @@ private:
 	//! Unexpected element error handling function
 	void error_unexpected_element(xmlpp::Node *node,const String &got);
 
+	//! Takes the number of \a node decoded from a .sifb file, if any
+	bool get_binary_number(const xmlpp::Element *node,Real &x)const;
+
 	//! Canvas Parsing Function
 	Canvas::Handle parse_canvas(xmlpp::Element *node,Canvas::Handle parent=0,bool inline_=false,const FileSystem::Identifier &identifier = FileSystemNative::instance()->get_identifier(std::string()),String path=".");
+	//! Creates canvas from the attributes of <canvas> element.
+	//! \param finished set to true when the returned canvas must not be filled with children
+	Canvas::Handle parse_canvas_header(xmlpp::Element *node,Canvas::Handle parent,bool inline_,const FileSystem::Identifier &identifier,String path,bool &finished);
+	//! Parses a single child element of <canvas> into the canvas
+	void parse_canvas_child(xmlpp::Element *node,Canvas::Handle canvas);
+	//! Checks the canvas after all children are parsed
+	void parse_canvas_footer(xmlpp::Element *node,Canvas::Handle canvas);
+	//! Root Canvas Parsing Function for a stream.
+	//! Reads the document by children of the root element, so only one of them is kept in memory at a time.
+	Canvas::Handle parse_canvas_stream(std::istream &stream,const FileSystem::Identifier &identifier,String path);
+	//! Root Canvas Parsing Function for a binary (.sifb) stream, see CanvasBinary
+	Canvas::Handle parse_canvas_binary(std::istream &stream,const FileSystem::Identifier &identifier,String path);
 	//! Canvas definitions Parsing Function (exported value nodes and exported canvases)
 	void parse_canvas_defs(xmlpp::Element *node,Canvas::Handle canvas);
 
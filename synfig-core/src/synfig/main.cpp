@@ -59,6 +59,7 @@
 #include <unistd.h>
 #endif
 
+#include "clock.h"
 #include "token.h"
 #include "target.h"
 #include "listimporter.h"
@@ -113,6 +114,9 @@ public:
 
 GeneralIOMutexHolder general_io_mutex;
 
+static std::mutex startup_profile_mutex;
+static std::vector<Main::ProfileEntry> startup_profile;
+
 /* === P R O C E D U R E S ================================================= */
 
 /* === M E T H O D S ======================================================= */
@@ -260,9 +264,13 @@ synfig::Main::Main(const synfig::String& rootpath,ProgressCallback *cb):
 #endif
 
 	//_config_search_path=new vector"string.h"();
-	
+
+	// Durations of the steps below are reported by get_startup_profile()
+	synfig::clock timer;
+
 	// Init Gio to allow use Gio::File::create_for_uri() in ValueNode_AnimatedFile::load file() function
 	Gio::init();
+	add_startup_profile_entry("Gio", timer.pop_time());
 
 	// Init the subsystems
 	if(cb)cb->amount_complete(0, 100);
@@ -271,6 +279,8 @@ synfig::Main::Main(const synfig::String& rootpath,ProgressCallback *cb):
 	if(!SoundProcessor::subsys_init())
 		throw std::runtime_error(_("Unable to initialize subsystem \"Sound\""));
 
+	add_startup_profile_entry(_("Subsystem \"Sound\""), timer.pop_time());
+
 	if(cb)cb->task(_("Starting Subsystem \"Types\""));
 	if(!Type::subsys_init())
 	{
@@ -278,6 +288,8 @@ synfig::Main::Main(const synfig::String& rootpath,ProgressCallback *cb):
 		throw std::runtime_error(_("Unable to initialize subsystem \"Types\""));
 	}
 
+	add_startup_profile_entry(_("Subsystem \"Types\""), timer.pop_time());
+
 	if(cb)cb->task(_("Starting Subsystem \"Rendering\""));
 	if(!rendering::Renderer::subsys_init())
 	{
@@ -286,6 +298,8 @@ synfig::Main::Main(const synfig::String& rootpath,ProgressCallback *cb):
 		throw std::runtime_error(_("Unable to initialize subsystem \"Rendering\""));
 	}
 
+	add_startup_profile_entry(_("Subsystem \"Rendering\""), timer.pop_time());
+
 	if(cb)cb->task(_("Starting Subsystem \"Modules\""));
 	if(!Module::subsys_init(root_path))
 	{
@@ -295,6 +309,8 @@ synfig::Main::Main(const synfig::String& rootpath,ProgressCallback *cb):
 		throw std::runtime_error(_("Unable to initialize subsystem \"Modules\""));
 	}
 
+	add_startup_profile_entry(_("Subsystem \"Modules\""), timer.pop_time());
+
 	if(cb)cb->task(_("Starting Subsystem \"Layers\""));
 	if(!Layer::subsys_init())
 	{
@@ -305,6 +321,8 @@ synfig::Main::Main(const synfig::String& rootpath,ProgressCallback *cb):
 		throw std::runtime_error(_("Unable to initialize subsystem \"Layers\""));
 	}
 
+	add_startup_profile_entry(_("Subsystem \"Layers\""), timer.pop_time());
+
 	if(cb)cb->task(_("Starting Subsystem \"Targets\""));
 	if(!Target::subsys_init())
 	{
@@ -316,6 +334,8 @@ synfig::Main::Main(const synfig::String& rootpath,ProgressCallback *cb):
 		throw std::runtime_error(_("Unable to initialize subsystem \"Targets\""));
 	}
 
+	add_startup_profile_entry(_("Subsystem \"Targets\""), timer.pop_time());
+
 	if(cb)cb->task(_("Starting Subsystem \"Importers\""));
 	if(!Importer::subsys_init())
 	{
@@ -328,10 +348,14 @@ synfig::Main::Main(const synfig::String& rootpath,ProgressCallback *cb):
 		throw std::runtime_error(_("Unable to initialize subsystem \"Importers\""));
 	}
 
+	add_startup_profile_entry(_("Subsystem \"Importers\""), timer.pop_time());
+
 	if(cb)cb->task(_("Starting Subsystem \"Thread Pool\""));
 	if(!ThreadPool::subsys_init())
 		throw std::runtime_error(_("Unable to initialize subsystem \"Thread Pool\""));
 
+	add_startup_profile_entry(_("Subsystem \"Thread Pool\""), timer.pop_time());
+
 	// Rebuild tokens data
 	Token::rebuild();
 
@@ -387,17 +411,32 @@ synfig::Main::Main(const synfig::String& rootpath,ProgressCallback *cb):
 		Module::register_default_modules(cb);
 	}
 
+	add_startup_profile_entry(_("Module list"), timer.pop_time());
+
 	std::list<String>::iterator iter;
 
 	for(i=0,iter=modules_to_load.begin();iter!=modules_to_load.end();++iter,i++)
 	{
-		synfig::info("Loading %s..", iter->c_str());
-		Module::Register(*iter,cb);
+		// with lazy loading, modules are loaded on first use of their layers, targets, etc.
+		if (Module::defer(*iter))
+		{
+			add_startup_profile_entry(strprintf(_("Module \"%s\" (deferred)"), iter->c_str()), timer.pop_time());
+		}
+		else
+		{
+			synfig::info("Loading %s..", iter->c_str());
+			Module::Register(*iter,cb);
+			add_startup_profile_entry(strprintf(_("Module \"%s\""), iter->c_str()), timer.pop_time());
+		}
 		if(cb)cb->amount_complete((i+1)*100, modules_to_load.size()*100u);
 	}
 
+	// Remember what the loaded modules provide for lazy loading in the next runs
+	Module::save_manifests();
+
 	// Rebuild tokens data again to include new tokens from modules
 	Token::rebuild();
+	add_startup_profile_entry(_("Module cache and tokens"), timer.pop_time());
 
 	if(cb)cb->amount_complete(100, 100);
 	if(cb)cb->task(_("DONE"));
@@ -445,6 +484,20 @@ synfig::Main::~Main()
 	instance = nullptr;
 }
 
+std::vector<Main::ProfileEntry>
+synfig::Main::get_startup_profile()
+{
+	std::lock_guard<std::mutex> lock(startup_profile_mutex);
+	return startup_profile;
+}
+
+void
+synfig::Main::add_startup_profile_entry(const String &task, Real time)
+{
+	std::lock_guard<std::mutex> lock(startup_profile_mutex);
+	startup_profile.push_back(ProfileEntry{task, time});
+}
+
 static const String
 current_time()
 {
@@ -31,7 +31,9 @@
 /* === H E A D E R S ======================================================= */
 
 #include <cassert>
+#include <vector>
 
+#include "real.h"
 #include "reference_counter.h"
 #include "string.h"
 #include "progresscallback.h"
@@ -68,6 +70,17 @@ public:
 
 	const ReferenceCounter& ref_count()const { return ref_count_; }
 	static const Main& get_instance() { assert(instance); return *instance; }
+
+	//! Time spent on one step of the initialization
+	struct ProfileEntry
+	{
+		String task;
+		Real time; //!< in seconds
+	};
+
+	//! Steps of the initialization, modules loaded on first use are appended when they are loaded
+	static std::vector<ProfileEntry> get_startup_profile();
+	static void add_startup_profile_entry(const String &task, Real time);
 }; // END of class Main
 
 }; // END if namespace synfig
@@ -33,23 +33,228 @@
 #endif
 
 
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <vector>
+
 #include "module.h"
 
+#include "clock.h"
 #include "general.h"
 #include <synfig/localization.h>
+#include "importer.h"
+#include "main.h"
+#include "target.h"
+#include "token.h"
 #include "type.h"
+#include "valuenode_registry.h"
 #include <glibmm.h>
+#include <glib/gstdio.h>
 
 #include <ltdl.h>
 
 #endif
 
+/* === U S I N G =========================================================== */
+
+using namespace synfig;
+
 /* === M A C R O S ========================================================= */
 
 /* === G L O B A L S ======================================================= */
 
+namespace {
+
+//! Entry of the book added by a module, with the fields needed to make a placeholder
+struct ManifestEntry
+{
+	String kind; //!< "layer", "target", "target-ext", "importer" or "valuenode"
+	std::vector<String> fields; //!< the name of the entry first
+};
+
+struct Manifest
+{
+	String filename;
+	long long mtime;
+	long long size;
+	std::vector<ManifestEntry> entries;
+
+	Manifest(): mtime(), size() { }
+};
+
+//! Names of the entries in all books, to find what a module adds
+struct BookKeys
+{
+	std::set<String> layers, targets, target_exts, importers, valuenodes;
+
+	BookKeys()
+	{
+		for(const auto &i : Layer::book()) layers.insert(i.first);
+		for(const auto &i : Target::book()) targets.insert(i.first);
+		for(const auto &i : Target::ext_book()) target_exts.insert(i.first);
+		for(const auto &i : Importer::book()) importers.insert(i.first);
+		for(const auto &i : ValueNodeRegistry::book()) valuenodes.insert(i.first);
+	}
+};
+
+bool lazy_loading = false;
+bool manifests_read = false;
+bool manifests_changed = false;
+std::map<String, Manifest> manifests;
+//! deferred module by the type and name of the entry it provides
+std::map<std::pair<int, String>, String> providers;
+std::set<String> deferred_modules;
+std::recursive_mutex deferred_mutex;
+
+}
+
 /* === P R O C E D U R E S ================================================= */
 
+static String
+get_manifest_cache_filename()
+{
+	if (const char *s = getenv("SYNFIG_MODULE_CACHE"))
+		return s;
+	return Glib::build_filename(Glib::get_user_cache_dir(), "synfig", "modules.cache");
+}
+
+static bool
+get_file_stamp(const String &filename, long long &mtime, long long &size)
+{
+	GStatBuf buf;
+	if (filename.empty() || g_stat(filename.c_str(), &buf) != 0)
+		return false;
+	mtime = (long long)buf.st_mtime;
+	size = (long long)buf.st_size;
+	return true;
+}
+
+static void
+read_manifests()
+{
+	if (manifests_read) return;
+	manifests_read = true;
+
+	std::ifstream file(get_manifest_cache_filename().c_str());
+	Manifest *manifest = nullptr;
+	String line;
+	while(std::getline(file, line)) {
+		// fields may be empty, even the last one
+		std::vector<String> fields;
+		for(String::size_type pos = 0;;) {
+			String::size_type end = line.find('\t', pos);
+			fields.push_back(line.substr(pos, end == String::npos ? String::npos : end - pos));
+			if (end == String::npos) break;
+			pos = end + 1;
+		}
+
+		if (fields[0] == "module" && fields.size() == 5) {
+			manifest = &manifests[fields[1]];
+			manifest->filename = fields[2];
+			manifest->mtime = atoll(fields[3].c_str());
+			manifest->size = atoll(fields[4].c_str());
+		} else
+		if (manifest && fields.size() >= 2) {
+			ManifestEntry entry;
+			entry.kind = fields[0];
+			entry.fields.assign(fields.begin() + 1, fields.end());
+			manifest->entries.push_back(entry);
+		}
+	}
+}
+
+//! Makes the manifest of the module from entries of the books which are not in \a before
+static Manifest
+make_manifest(const String &filename, const BookKeys &before)
+{
+	Manifest manifest;
+	manifest.filename = filename;
+	get_file_stamp(filename, manifest.mtime, manifest.size);
+
+	ManifestEntry entry;
+	for(const auto &i : Layer::book())
+		if (!before.layers.count(i.first)) {
+			entry.kind = "layer";
+			entry.fields = { i.first, i.second.local_name, i.second.category, i.second.version };
+			manifest.entries.push_back(entry);
+		}
+	for(const auto &i : Target::book())
+		if (!before.targets.count(i.first)) {
+			entry.kind = "target";
+			entry.fields = { i.first, i.second.file_extension };
+			manifest.entries.push_back(entry);
+		}
+	for(const auto &i : Target::ext_book())
+		if (!before.target_exts.count(i.first)) {
+			entry.kind = "target-ext";
+			entry.fields = { i.first, i.second };
+			manifest.entries.push_back(entry);
+		}
+	for(const auto &i : Importer::book())
+		if (!before.importers.count(i.first)) {
+			entry.kind = "importer";
+			entry.fields = { i.first, i.second.supports_file_system_wrapper ? "1" : "0" };
+			manifest.entries.push_back(entry);
+		}
+	for(const auto &i : ValueNodeRegistry::book())
+		if (!before.valuenodes.count(i.first)) {
+			entry.kind = "valuenode";
+			entry.fields = { i.first, i.second.get_local_name(), strprintf("%d", (int)i.second.release_version) };
+			manifest.entries.push_back(entry);
+		}
+
+	// the cache is tab separated, such entries cannot be stored
+	for(const ManifestEntry &e : manifest.entries)
+		for(const String &field : e.fields)
+			if (field.find_first_of("\t\n") != String::npos) {
+				manifest.filename.clear();
+				return manifest;
+			}
+	return manifest;
+}
+
+static bool
+is_same_manifest(const Manifest &a, const Manifest &b)
+{
+	if (a.filename != b.filename || a.mtime != b.mtime || a.size != b.size || a.entries.size() != b.entries.size())
+		return false;
+	for(size_t i = 0; i < a.entries.size(); ++i)
+		if (a.entries[i].kind != b.entries[i].kind || a.entries[i].fields != b.entries[i].fields)
+			return false;
+	return true;
+}
+
+//! Removes entries of the deferred module which are not replaced by the loaded one
+static void
+remove_placeholders(const Manifest &manifest)
+{
+	for(const ManifestEntry &entry : manifest.entries) {
+		const String &name = entry.fields[0];
+		if (entry.kind == "layer") {
+			Layer::Book::iterator i = Layer::book().find(name);
+			if (i != Layer::book().end() && !i->second.factory)
+				Layer::book().erase(i);
+		} else
+		if (entry.kind == "target") {
+			Target::Book::iterator i = Target::book().find(name);
+			if (i != Target::book().end() && !i->second.factory)
+				Target::book().erase(i);
+		} else
+		if (entry.kind == "importer") {
+			Importer::Book::iterator i = Importer::book().find(name);
+			if (i != Importer::book().end() && !i->second.factory)
+				Importer::book().erase(i);
+		} else
+		if (entry.kind == "valuenode") {
+			ValueNodeRegistry::Book::iterator i = ValueNodeRegistry::book().find(name);
+			if (i != ValueNodeRegistry::book().end() && !i->second.factory)
+				ValueNodeRegistry::book().erase(i);
+		}
+	}
+}
+
 static void add_search_dir(const std::string& dir) {
 	lt_dladdsearchdir(dir.c_str());
 #ifdef _MSC_VER
@@ -143,6 +348,9 @@ synfig::Module::Register(const String &module_name, ProgressCallback *callback)
 
 	if(callback)callback->task(strprintf(_("Attempting to register \"%s\""),module_name.c_str()));
 
+	// entries added by the module are recorded to its manifest
+	BookKeys book_keys;
+
 	module=lt_dlopenext((std::string("lib")+module_name).c_str());
 	if(!module)module=lt_dlopenext(module_name.c_str());
 	Type::initialize_all();
@@ -188,9 +396,160 @@ synfig::Module::Register(const String &module_name, ProgressCallback *callback)
 
 	if(callback)callback->task(strprintf(_("Success for \"%s\""),module_name.c_str()));
 
+	const lt_dlinfo *info = lt_dlgetinfo(module);
+	Manifest manifest = make_manifest(info && info->filename ? String(info->filename) : String(), book_keys);
+	if (!manifest.filename.empty()) {
+		read_manifests();
+		std::map<String, Manifest>::iterator i = manifests.find(module_name);
+		// a module registered twice adds nothing the second time, keep the first manifest
+		bool keep = i != manifests.end() && manifest.entries.empty() && !i->second.entries.empty();
+		if (!keep && (i == manifests.end() || !is_same_manifest(i->second, manifest))) {
+			manifests[module_name] = manifest;
+			manifests_changed = true;
+		}
+	}
+
 	return true;
 }
 
+void
+synfig::Module::set_lazy_loading(bool x)
+	{ lazy_loading = x; }
+
+bool
+synfig::Module::get_lazy_loading()
+	{ return lazy_loading; }
+
+bool
+synfig::Module::defer(const String &module_name)
+{
+	if (!lazy_loading)
+		return false;
+
+	std::lock_guard<std::recursive_mutex> lock(deferred_mutex);
+	read_manifests();
+	std::map<String, Manifest>::const_iterator i = manifests.find(module_name);
+	if (i == manifests.end())
+		return false;
+	const Manifest &manifest = i->second;
+
+	// modules which add nothing to the books may have other side effects, they are always loaded
+	if (manifest.entries.empty())
+		return false;
+
+	long long mtime = 0, size = 0;
+	if (!get_file_stamp(manifest.filename, mtime, size) || mtime != manifest.mtime || size != manifest.size)
+		return false;
+
+	for(const ManifestEntry &entry : manifest.entries) {
+		const std::vector<String> &f = entry.fields;
+		if (entry.kind == "layer" && f.size() == 4) {
+			if (Layer::book().count(f[0])) continue;
+			Layer::register_in_book(Layer::BookEntry(nullptr, f[0], f[1], f[2], f[3]));
+			providers[std::make_pair((int)ENTRY_LAYER, f[0])] = module_name;
+		} else
+		if (entry.kind == "target" && f.size() == 2) {
+			if (Target::book().count(f[0])) continue;
+			Target::book()[f[0]].factory = nullptr;
+			Target::book()[f[0]].file_extension = f[1];
+			providers[std::make_pair((int)ENTRY_TARGET, f[0])] = module_name;
+		} else
+		if (entry.kind == "target-ext" && f.size() == 2) {
+			if (Target::ext_book().count(f[0])) continue;
+			Target::ext_book()[f[0]] = f[1];
+		} else
+		if (entry.kind == "importer" && f.size() == 2) {
+			if (Importer::book().count(f[0])) continue;
+			Importer::book()[f[0]] = Importer::BookEntry(nullptr, f[1] == "1");
+			providers[std::make_pair((int)ENTRY_IMPORTER, f[0])] = module_name;
+		} else
+		if (entry.kind == "valuenode" && f.size() == 3) {
+			if (ValueNodeRegistry::book().count(f[0])) continue;
+			ValueNodeRegistry::register_node_type(f[0], f[1], (ReleaseVersion)atoi(f[2].c_str()), nullptr, nullptr);
+			providers[std::make_pair((int)ENTRY_VALUENODE, f[0])] = module_name;
+		}
+	}
+
+	deferred_modules.insert(module_name);
+	return true;
+}
+
+bool
+synfig::Module::load_provider(EntryType type, const String &name)
+{
+	std::lock_guard<std::recursive_mutex> lock(deferred_mutex);
+	std::map<std::pair<int, String>, String>::iterator i = providers.find(std::make_pair((int)type, name));
+	if (i == providers.end())
+		return false;
+
+	const String module_name = i->second;
+	for(std::map<std::pair<int, String>, String>::iterator j = providers.begin(); j != providers.end();)
+		if (j->second == module_name) j = providers.erase(j); else ++j;
+	if (!deferred_modules.erase(module_name))
+		return false;
+
+	// value nodes are not replaced by registration, so placeholders go first
+	remove_placeholders(manifests[module_name]);
+
+	synfig::clock timer;
+	bool success = Register(module_name, nullptr);
+	Token::rebuild();
+	Main::add_startup_profile_entry(strprintf(_("Module \"%s\" (on first use)"), module_name.c_str()), timer());
+
+	if (!success)
+		synfig::error(_("Unable to load module '%s'"), module_name.c_str());
+	return success;
+}
+
+void
+synfig::Module::load_deferred(ProgressCallback *cb)
+{
+	std::lock_guard<std::recursive_mutex> lock(deferred_mutex);
+	std::set<String> modules;
+	modules.swap(deferred_modules);
+	providers.clear();
+	for(const String &module_name : modules) {
+		remove_placeholders(manifests[module_name]);
+		Register(module_name, cb);
+	}
+	Token::rebuild();
+}
+
+void
+synfig::Module::save_manifests()
+{
+	if (!manifests_changed)
+		return;
+	manifests_changed = false;
+
+	const String filename = get_manifest_cache_filename();
+	g_mkdir_with_parents(Glib::path_get_dirname(filename).c_str(), 0755);
+
+	// write to the temporary file first, other processes may read the cache at the same time
+	const String temporary_filename = filename + strprintf(".%u", g_random_int());
+	{
+		std::ofstream file(temporary_filename.c_str());
+		for(const auto &i : manifests) {
+			file << "module\t" << i.first << "\t" << i.second.filename
+				 << "\t" << i.second.mtime << "\t" << i.second.size << "\n";
+			for(const ManifestEntry &entry : i.second.entries) {
+				file << entry.kind;
+				for(const String &field : entry.fields)
+					file << "\t" << field;
+				file << "\n";
+			}
+		}
+		if (!file) {
+			synfig::warning(_("Unable to write the module cache %s"), temporary_filename.c_str());
+			return;
+		}
+	}
+	if (g_rename(temporary_filename.c_str(), filename.c_str()) != 0) {
+		g_unlink(temporary_filename.c_str());
+		synfig::warning(_("Unable to write the module cache %s"), filename.c_str());
+	}
+}
+
 synfig::Module::~Module()
 {
 	destructor_();
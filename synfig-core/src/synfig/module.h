@@ -212,6 +212,13 @@ class ProgressCallback;
 * Modules are not auto-registered. Instead, Synfig register those listed in a
 * plain-text file called "synfig_modules.cfg" or that defined by envvar SYNFIG_MODULE_LIST.
 * See synfig::Main for further details.
+*
+* Layers, targets, importers and value nodes added to the books by each loaded
+* module are written to the manifest cache ("synfig/modules.cache" in the user
+* cache directory, or the file defined by envvar SYNFIG_MODULE_CACHE).
+* If lazy loading is enabled, a module with an up to date manifest is not loaded
+* at startup: its entries are added to the books without factories, and the module
+* is loaded on the first use of any of them (see load_provider()).
 */
 class Module : public etl::shared_object
 {
@@ -230,6 +237,15 @@ public:
 	typedef Module* (*constructor_type)(ProgressCallback *);
 	//! Type of registered modules: maps Module name to Module handle
 	typedef std::map<String, Handle> Book;
+
+	//! Kinds of book entries provided by modules
+	enum EntryType
+	{
+		ENTRY_LAYER,
+		ENTRY_TARGET,
+		ENTRY_IMPORTER,
+		ENTRY_VALUENODE
+	};
 public:
 	//! The registered modules
 	static Book& book();
@@ -248,6 +264,21 @@ public:
 	//!Register Module by instance pointer
 	static inline void Register(Module *mod) { Register(Handle(mod)); }
 
+	//! Enables loading of modules on first use, see defer()
+	static void set_lazy_loading(bool x);
+	static bool get_lazy_loading();
+	//! If lazy loading is enabled and the manifest of the module is up to date,
+	//! adds the entries of the module to the books without loading it
+	//! \return whether the module is deferred
+	static bool defer(const String &module_name);
+	//! Loads the deferred module which provides the entry of the book, if any
+	//! \return whether the module was loaded
+	static bool load_provider(EntryType type, const String &name);
+	//! Loads all deferred modules, e.g. to list them
+	static void load_deferred(ProgressCallback *cb=nullptr);
+	//! Writes the manifest cache if manifests of the loaded modules have changed
+	static void save_manifests();
+
 	// Virtual Modules properties wrappers.
 	// They MUST be defined in the module implementation classes.
 	// They SHOULD be defined via MODULE_* macros inside MODULE_DESC_BEGIN/END block.
@@ -35,8 +35,10 @@
 
 #include "node.h"
 
+#include <algorithm>
 #include <cstdlib>
-#include <map>
+#include <set>
+#include <vector>
 
 #include "synfig/general.h"
 
@@ -51,40 +53,123 @@ using namespace synfig;
 /* === G L O B A L S ======================================================= */
 
 namespace {
+	//! Map of all GUIDs to their nodes.
+	//! Split into independently locked shards, so nodes created on different threads rarely wait for each other.
 	class GlobalNodeMap {
-	public:
-		typedef std::map<GUID, Node*> Map;
-	
 	private:
-		std::mutex mutex;
-		Map map;
-	
+		enum { SHARD_BITS = 6, SHARD_COUNT = 1 << SHARD_BITS };
+
+		struct Entry {
+			GUID guid;  //!< zero for a never used slot
+			Node *node; //!< null for a removed slot
+			Entry(): guid(GUID::zero()), node() { }
+		};
+
+		//! Open addressing hash table with linear probing
+		class Shard {
+		public:
+			std::mutex mutex;
+
+		private:
+			std::vector<Entry> entries;
+			size_t used;  //!< slots with non-zero guid, including removed ones
+			size_t count; //!< slots with node
+
+			void rehash(size_t size) {
+				std::vector<Entry> old;
+				old.swap(entries);
+				entries.resize(size);
+				used = count = 0;
+				for(std::vector<Entry>::const_iterator i = old.begin(); i != old.end(); ++i)
+					if (i->node)
+						insert(i->guid, hash(i->guid), i->node);
+			}
+
+		public:
+			Shard(): used(), count() { }
+
+			Entry* find(const GUID &guid, uint64_t hash) {
+				if (entries.empty())
+					return nullptr;
+				const size_t mask = entries.size() - 1;
+				for(size_t i = hash & mask; entries[i].guid; i = (i + 1) & mask)
+					if (entries[i].node && entries[i].guid == guid)
+						return &entries[i];
+				return nullptr;
+			}
+
+			//! guid must not be in the table
+			void insert(const GUID &guid, uint64_t hash, Node *node) {
+				// keep at least half of slots empty, removed slots are dropped while growing
+				if (2*(used + 1) > entries.size())
+					rehash(round_up(std::max(size_t(16), 4*(count + 1))));
+
+				const size_t mask = entries.size() - 1;
+				size_t i = hash & mask;
+				while(entries[i].node)
+					i = (i + 1) & mask;
+				if (!entries[i].guid)
+					++used;
+				entries[i].guid = guid;
+				entries[i].node = node;
+				++count;
+			}
+
+			void erase(Entry *entry) {
+				entry->node = nullptr;
+				--count;
+			}
+		};
+
+		Shard shards[SHARD_COUNT];
+
+		static size_t round_up(size_t x) {
+			size_t size = 1;
+			while(size < x) size <<= 1;
+			return size;
+		}
+
+		//! GUIDs are random or hashed already, so their own bits are mixed only a little
+		static uint64_t hash(const GUID &guid)
+			{ uint64_t h = guid.get_hi() ^ (guid.get_lo()*0x9e3779b97f4a7c15ull); return h ^ (h >> 32); }
+
+		//! shard is chosen by the top bits, slot in the shard by the bottom ones
+		Shard& shard(uint64_t hash)
+			{ return shards[hash >> (64 - SHARD_BITS)]; }
+
 	public:
 		Node* get(const GUID &guid) {
-			std::lock_guard<std::mutex> lock(mutex);
-			Map::iterator i = map.find(guid);
-			return i == map.end() ? nullptr : i->second;
+			const uint64_t h = hash(guid);
+			Shard &s = shard(h);
+			std::lock_guard<std::mutex> lock(s.mutex);
+			Entry *entry = s.find(guid, h);
+			return entry ? entry->node : nullptr;
 		}
 
 		bool add(const GUID &guid, Node *node) {
 			assert(guid);
 			assert(node);
-			
-			std::lock_guard<std::mutex> lock(mutex);
-			if (map.count(guid) > 0)
+
+			const uint64_t h = hash(guid);
+			Shard &s = shard(h);
+			std::lock_guard<std::mutex> lock(s.mutex);
+			if (s.find(guid, h))
 				return false;
-			map[guid] = node;
+			s.insert(guid, h, node);
 			return true;
 		}
 
 		void remove(const GUID &guid, Node *node) {
 			assert(guid);
 			assert(node);
-			
-			std::lock_guard<std::mutex> lock(mutex);
-			Map::iterator i = map.find(guid);
-			assert(i != map.end() && i->second == node);
-			map.erase(i);
+
+			const uint64_t h = hash(guid);
+			Shard &s = shard(h);
+			std::lock_guard<std::mutex> lock(s.mutex);
+			Entry *entry = s.find(guid, h);
+			assert(entry && entry->node == node);
+			if (entry)
+				s.erase(entry);
 		}
 
 		void move(const GUID &guid, const GUID &oldguid, Node *node) {
@@ -95,16 +180,62 @@ namespace {
 				return;
 			}
 			assert(oldguid);
-			
-			std::lock_guard<std::mutex> lock(mutex);
-			Map::iterator i = map.find(oldguid);
-			assert(i != map.end() && i->second == node);
-			map.erase(i);
-			
-			assert(!map.count(guid));
-			map[guid] = node;
+
+			const uint64_t h = hash(guid);
+			const uint64_t old_h = hash(oldguid);
+			Shard &s = shard(h);
+			Shard &old_s = shard(old_h);
+
+			// both shards are locked, so the node is never seen without a guid
+			std::unique_lock<std::mutex> lock(s.mutex, std::defer_lock);
+			std::unique_lock<std::mutex> old_lock(old_s.mutex, std::defer_lock);
+			if (&s == &old_s)
+				lock.lock();
+			else
+				std::lock(lock, old_lock);
+
+			Entry *entry = old_s.find(oldguid, old_h);
+			assert(entry && entry->node == node);
+			if (entry)
+				old_s.erase(entry);
+
+			assert(!s.find(guid, h));
+			s.insert(guid, h, node);
+		}
+	};
+}
+
+namespace {
+	//! Postponed signals of the current thread, see Node::ChangeBatch
+	struct ChangeBatchState {
+		//! changed node, and its changed child for signal_child_changed(), or null for signal_changed()
+		typedef std::pair<etl::handle<Node>, etl::handle<const Node> > Entry;
+
+		int depth;
+		bool flushing;
+		//! signals to emit, in order of the first change
+		std::vector<Entry> pending;
+		std::set<std::pair<const Node*, const Node*> > pending_set;
+
+		ChangeBatchState(): depth(), flushing() { }
+
+		bool active() const { return depth > 0 || flushing; }
+
+		//! Returns false if the signal should be emitted immediately
+		bool postpone(Node *node, const Node *child) {
+			if (!active())
+				return false;
+			// pending nodes are kept alive by handles, this is not possible
+			// for nodes under construction or destruction
+			if (node->use_count() <= 0 || (child && child->use_count() <= 0))
+				return false;
+			if (pending_set.insert(std::make_pair(node, child)).second)
+				pending.push_back(Entry(etl::handle<Node>(node), etl::handle<const Node>(child)));
+			return true;
 		}
 	};
+
+	thread_local ChangeBatchState change_batch_state;
 }
 
 // A map to store all the GUIDs with a pointer to the Node.
@@ -366,7 +497,8 @@ Node::on_changed()
 	}
 
 	bchanged = true;
-	signal_changed()();
+	if (!change_batch_state.postpone(this, nullptr))
+		notify_changed();
 
 	std::lock_guard<std::mutex> lock(parent_set_mutex_);
 	std::set<Node*>::iterator iter;
@@ -376,10 +508,17 @@ Node::on_changed()
 	}
 }
 
+void
+Node::notify_changed()
+{
+	signal_changed()();
+}
+
 void
 Node::on_child_changed(const Node *x)
 {
-	signal_child_changed()(x);
+	if (!change_batch_state.postpone(this, x))
+		signal_child_changed()(x);
 	changed();
 }
 
@@ -388,3 +527,52 @@ Node::on_guid_changed(synfig::GUID guid)
 {
 	signal_guid_changed()(guid);
 }
+
+Node::ChangeBatch::ChangeBatch()
+	{ ++change_batch_state.depth; }
+
+Node::ChangeBatch::~ChangeBatch()
+{
+	assert(change_batch_state.depth > 0);
+	if (--change_batch_state.depth == 0 && !change_batch_state.flushing) {
+		try {
+			flush();
+		} catch(...) {
+			synfig::error("Node::ChangeBatch: Caught exception while emitting change notifications");
+		}
+	}
+}
+
+bool
+Node::ChangeBatch::is_active()
+	{ return change_batch_state.active(); }
+
+void
+Node::ChangeBatch::flush()
+{
+	ChangeBatchState &state = change_batch_state;
+	if (state.flushing)
+		return;
+
+	// nodes changed by handlers of the signals are collected for the next round
+	state.flushing = true;
+	std::vector<ChangeBatchState::Entry> round;
+	try {
+		while(!state.pending.empty()) {
+			round.clear();
+			round.swap(state.pending);
+			state.pending_set.clear();
+			for(std::vector<ChangeBatchState::Entry>::const_iterator i = round.begin(); i != round.end(); ++i)
+				if (i->second)
+					i->first->signal_child_changed()(i->second.get());
+				else
+					i->first->notify_changed();
+		}
+	} catch(...) {
+		state.pending.clear();
+		state.pending_set.clear();
+		state.flushing = false;
+		throw;
+	}
+	state.flushing = false;
+}
@@ -37,6 +37,7 @@
 #include <ctime>
 #include <mutex>
 #include <set>
+#include <utility>
 #include <vector>
 
 #include <glibmm/threads.h>
@@ -125,6 +126,10 @@ public:
 	template <typename ITER> void insert(ITER begin, ITER end)
 		{ for(;begin!=end;++begin) insert(*begin); }
 
+	//! Returns the time points in the closed range [\a begin, \a end]
+	std::pair<const_iterator, const_iterator> find_range(const Time &begin, const Time &end) const
+		{ return std::make_pair(lower_bound(TimePoint(begin)), upper_bound(TimePoint(end))); }
+
 }; // END of class TimePointSet
 
 
@@ -140,6 +145,30 @@ public:
 
 	typedef	TimePointSet time_set;
 
+	//! Coalesces change signals of nodes while it exists.
+	//! Inside of a batch changed() still runs on_changed() and on_child_changed()
+	//! of the node and all its ancestors, so their caches are updated at once,
+	//! but signal_changed() and signal_child_changed() are postponed until
+	//! the outermost batch ends. Then each of them is emitted once per node,
+	//! in order of the first change. Nodes with postponed signals are kept alive until then.
+	//! Batches belong to the current thread and can be nested.
+	class ChangeBatch
+	{
+	public:
+		ChangeBatch();
+		~ChangeBatch();
+
+		//! Returns true if the current thread is inside of a batch
+		static bool is_active();
+
+		//! Emits the postponed notifications now, the batch stays open
+		static void flush();
+
+	private:
+		ChangeBatch(const ChangeBatch&) = delete;
+		ChangeBatch& operator=(const ChangeBatch&) = delete;
+	};
+
 	/*
  --	** -- D A T A -------------------------------------------------------------
 	*/
@@ -345,6 +374,10 @@ protected:
 	//! the GUI can be connected to.
 	virtual void on_child_changed(const Node *x);
 
+	//! Emits signal_changed().
+	//! Called by on_changed(), or once per node at the end of a ChangeBatch.
+	virtual void notify_changed();
+
 	//! Used when the node's GUID has changed.
 	//! To be overloaded by the derivative classes. Emits a signal where the
 	//! the GUI can be connected to.
@@ -72,6 +72,16 @@ public:
 	 */
 	Rect required_source_rect;
 
+	/**
+	 * Allowed error of the remapped positions, in pixels of the source surface.
+	 * If it's above zero, the implementation may evaluate the distortion on
+	 * a coarse grid and interpolate it where the error stays within this value.
+	 * Zero (default) means the distortion is evaluated for every pixel.
+	 */
+	Real tolerance;
+
+	TaskDistort(): tolerance() { }
+
 	void set_coords_sub_tasks() override;
 
 	const Task::Handle& sub_task() const { return Task::sub_task(0); }
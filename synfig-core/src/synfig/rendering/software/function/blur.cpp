@@ -39,6 +39,8 @@
 
 #include "blur.h"
 
+#include <synfig/threadpool.h>
+
 #include "blurtemplates.h"
 #include "fft.h"
 //#include "blur_iir_coefficients.cpp"
@@ -53,6 +55,98 @@ using namespace rendering;
 
 /* === P R O C E D U R E S ================================================= */
 
+namespace {
+
+const int channels = 4;
+const int transpose_block = 32;
+const int min_rows_per_thread = 16;
+
+typedef sigc::slot<void, int, int> RowsSlot;
+
+//! Calls slot(begin, end) for the ranges of rows in the pool threads
+void
+process_rows(int rows, const RowsSlot &slot)
+{
+	int threads = std::min(ThreadPool::instance().get_max_threads(), rows/min_rows_per_thread);
+	if (threads <= 1) {
+		slot(0, rows);
+		return;
+	}
+
+	ThreadPool::Group group;
+	for(int i = 0; i < threads; ++i)
+		group.enqueue(sigc::bind(slot, rows*i/threads, rows*(i + 1)/threads));
+	group.run();
+}
+
+//! Running-sum box blur of interleaved RGBA rows, all four channels at once.
+//! Like BlurTemplates::blur_box_discrete() leaves pixels without
+//! the full window unchanged.
+void
+blur_box_rows(int begin, int end, ColorReal *data, int cols, int size, int passes)
+{
+	int s = std::abs(size);
+	int full_size = 1 + 2*s;
+	if (s == 0 || cols < full_size) return;
+
+	const ColorReal w = ColorReal(1.0)/ColorReal(full_size);
+	std::vector<ColorReal> line(cols*channels);
+	for(int r = begin; r < end; ++r) {
+		ColorReal *row = data + (size_t)r*cols*channels;
+		for(int p = 0; p < passes; ++p) {
+			std::copy(row, row + cols*channels, line.begin());
+
+			ColorReal sum[channels] = {};
+			for(int i = 0; i < full_size; ++i)
+				for(int c = 0; c < channels; ++c)
+					sum[c] += line[i*channels + c];
+
+			const ColorReal *in = &line[full_size*channels];
+			const ColorReal *out = &line.front();
+			ColorReal *dst = row + s*channels;
+			for(int i = full_size; i < cols; ++i, in += channels, out += channels, dst += channels)
+				for(int c = 0; c < channels; ++c) {
+					dst[c] = w*sum[c];
+					sum[c] += in[c] - out[c];
+				}
+		}
+	}
+}
+
+//! Copies rows [begin, end) of src (rows x cols) into the columns of dst (cols x rows).
+//! Works by square blocks to keep both sides in cache.
+void
+transpose_rows(int begin, int end, ColorReal *dst, const ColorReal *src, int rows, int cols, bool add)
+{
+	for(int r0 = begin; r0 < end; r0 += transpose_block) {
+		int r1 = std::min(r0 + transpose_block, end);
+		for(int c0 = 0; c0 < cols; c0 += transpose_block) {
+			int c1 = std::min(c0 + transpose_block, cols);
+			for(int r = r0; r < r1; ++r) {
+				const ColorReal *s = src + ((size_t)r*cols + c0)*channels;
+				ColorReal *d = dst + ((size_t)c0*rows + r)*channels;
+				for(int c = c0; c < c1; ++c, s += channels, d += rows*channels)
+					for(int i = 0; i < channels; ++i)
+						d[i] = add ? d[i] + s[i] : s[i];
+			}
+		}
+	}
+}
+
+void
+transpose(ColorReal *dst, const ColorReal *src, int rows, int cols, bool add = false)
+{
+	process_rows(rows, sigc::bind(sigc::ptr_fun(&transpose_rows), dst, src, rows, cols, add));
+}
+
+void
+blur_box_rows_parallel(ColorReal *data, int rows, int cols, int size, int passes)
+{
+	process_rows(rows, sigc::bind(sigc::ptr_fun(&blur_box_rows), data, cols, size, passes));
+}
+
+} // end of anonimous namespace
+
 /* === M E T H O D S ======================================================= */
 
 bool
@@ -465,11 +559,10 @@ software::Blur::blur_fft(const Params &params)
 void
 software::Blur::blur_box(const Params &params)
 {
-	const Real precision(1e-5);
-	const int channels = 4;
 	int rows = params.src_rect.get_size()[1];
 	int cols = params.src_rect.get_size()[0];
 
+	// interleaved premultiplied RGBA
 	std::vector<ColorReal> surface(rows*cols*channels);
 	Array<ColorReal, 3> arr_surface(&surface.front());
 	arr_surface
@@ -498,44 +591,31 @@ software::Blur::blur_box(const Params &params)
 		return;
 	}
 
-	std::deque<ColorReal> q;
-	std::vector<ColorReal> surface_copy;
-	Array<ColorReal, 3> arr_surface_rows(arr_surface.reorder(2, 0, 1));
-	Array<ColorReal, 3> arr_surface_cols(arr_surface_rows.reorder(0, 2, 1));
+	int size_x = (int)round(size[0]);
+	int size_y = (int)round(size[1]);
+
+	// vertical pass works with transposed copy, so columns are contiguous in memory
+	std::vector<ColorReal> transposed;
 
 	if (cross)
 	{
+		transposed.resize(surface.size());
 		arr_surface.process< std::multiplies<ColorReal> >(0.5);
-		surface_copy = surface;
-		arr_surface_cols.pointer = &surface_copy.front();
+		transpose(&transposed.front(), &surface.front(), rows, cols);
+		blur_box_rows_parallel(&surface.front(), rows, cols, size_x, count);
+		blur_box_rows_parallel(&transposed.front(), cols, rows, size_y, count);
+		transpose(&surface.front(), &transposed.front(), cols, rows, true);
 	}
-
-	if (true || fabs(size[0] - round(size[0])) < precision)
-		for(Array<ColorReal, 3>::Iterator channel(arr_surface_rows); channel; ++channel)
-			for(Array<ColorReal, 2>::Iterator r(*channel); r; ++r)
-				for(int i = 0; i < count; ++i)
-					BlurTemplates::blur_box_discrete(*r, q, (int)round(size[0]));
-	else
-		for(Array<ColorReal, 3>::Iterator channel(arr_surface_rows); channel; ++channel)
-			for(Array<ColorReal, 2>::Iterator r(*channel); r; ++r)
-				for(int i = 0; i < count; ++i)
-					BlurTemplates::blur_box_aa(*r, q, (ColorReal)size[0]);
-
-	if (true || fabs(size[1] - round(size[1])) < precision)
-		for(Array<ColorReal, 3>::Iterator channel(arr_surface_cols); channel; ++channel)
-			for(Array<ColorReal, 2>::Iterator c(*channel); c; ++c)
-				for(int i = 0; i < count; ++i)
-					BlurTemplates::blur_box_discrete(*c, q, (int)round(size[1]));
 	else
-		for(Array<ColorReal, 3>::Iterator channel(arr_surface_cols); channel; ++channel)
-			for(Array<ColorReal, 2>::Iterator c(*channel); c; ++c)
-				for(int i = 0; i < count; ++i)
-					BlurTemplates::blur_box_aa(*c, q, (ColorReal)size[1]);
-
-	if (cross)
-		arr_surface_rows
-			.process< std::plus<ColorReal> >(
-				arr_surface_cols.reorder(0, 2, 1) );
+	{
+		blur_box_rows_parallel(&surface.front(), rows, cols, size_x, count);
+		if (size_y != 0) {
+			transposed.resize(surface.size());
+			transpose(&transposed.front(), &surface.front(), rows, cols);
+			blur_box_rows_parallel(&transposed.front(), cols, rows, size_y, count);
+			transpose(&surface.front(), &transposed.front(), cols, rows);
+		}
+	}
 
 	BlurTemplates::surface_write(
 		*params.dest,
@@ -32,6 +32,7 @@
 #	include <config.h>
 #endif
 
+#include <atomic>
 #include <cassert>
 #include <climits>
 //#include <ccomplex>
@@ -62,31 +63,49 @@ class software::FFT::Internal
 {
 public:
 	static std::set<int> counts;
+	static std::atomic<bool> counts_ready;
+	static std::mutex counts_mutex;
 	static std::mutex mutex;
+
+	//! Counts are filled on first use, to not spend startup time when nothing is blurred
+	static const std::set<int>& get_counts()
+	{
+		if (!counts_ready) {
+			std::lock_guard<std::mutex> lock(counts_mutex);
+			if (!counts_ready) {
+				const int max2 = INT_MAX/2 + 1;
+				const int max3 = INT_MAX/3 + 1;
+				const int max5 = INT_MAX/5 + 1;
+				const int max7 = INT_MAX/7 + 1;
+				for(int c2 = 1; c2 < max2; c2 *= 2)
+					for(int c3 = c2; c3 < max3; c3 *= 3)
+						for(int c5 = c3; c5 < max5; c5 *= 5)
+							for(int c7 = c5; c7 < max7; c7 *= 7)
+								counts.insert(c7);
+				counts_ready = true;
+			}
+		}
+		return counts;
+	}
 };
 
 std::set<int> software::FFT::Internal::counts;
+std::atomic<bool> software::FFT::Internal::counts_ready(false);
+std::mutex software::FFT::Internal::counts_mutex;
 std::mutex software::FFT::Internal::mutex;
 
 void
 software::FFT::initialize()
 {
-	const int max2 = INT_MAX/2 + 1;
-	const int max3 = INT_MAX/3 + 1;
-	const int max5 = INT_MAX/5 + 1;
-	const int max7 = INT_MAX/7 + 1;
-	for(int c2 = 1; c2 < max2; c2 *= 2)
-		for(int c3 = c2; c3 < max3; c3 *= 3)
-			for(int c5 = c3; c5 < max5; c5 *= 5)
-				for(int c7 = c5; c7 < max7; c7 *= 7)
-					Internal::counts.insert(c7);
 	fftw_set_timelimit(0.0);
 }
 
 void
 software::FFT::deinitialize()
 {
+	std::lock_guard<std::mutex> lock(Internal::counts_mutex);
 	Internal::counts.clear();
+	Internal::counts_ready = false;
 }
 
 int
@@ -94,8 +113,9 @@ software::FFT::get_valid_count(int x)
 {
 	if (x > 0)
 	{
-		std::set<int>::const_iterator i = Internal::counts.upper_bound(x - 1);
-		if (i != Internal::counts.end())
+		const std::set<int> &counts = Internal::get_counts();
+		std::set<int>::const_iterator i = counts.upper_bound(x - 1);
+		if (i != counts.end())
 			return *i;
 	}
 	assert(false);
@@ -105,7 +125,7 @@ software::FFT::get_valid_count(int x)
 bool
 software::FFT::is_valid_count(int x)
 {
-	return Internal::counts.count(x);
+	return Internal::get_counts().count(x);
 }
 
 void
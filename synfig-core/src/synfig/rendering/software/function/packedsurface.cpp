@@ -32,6 +32,7 @@
 #	include <config.h>
 #endif
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 
@@ -201,7 +202,8 @@ PackedSurface::PackedSurface():
 	chunk_size(0),
 	chunk_row_size(0),
 	chunks_width(0),
-	chunks_height(0)
+	chunks_height(0),
+	mipmap_size(0)
 {
 	memset(channels, 0, sizeof(channels));
 	memset(discrete_to_float, 0, sizeof(discrete_to_float));
@@ -230,6 +232,10 @@ PackedSurface::clear() {
 	chunks_width = 0;
 	chunks_height = 0;
 	data.clear();
+
+	std::lock_guard<std::mutex> lock(mipmap_mutex);
+	mipmaps.clear();
+	mipmap_size = 0;
 }
 
 Color::value_type
@@ -477,6 +483,91 @@ PackedSurface::get_pixels(Color *target) const {
 			*color = reader.get_pixel(x, y);
 }
 
+int
+PackedSurface::get_mipmap_count() const
+{
+	int count = 0;
+	for(int size = std::max(width, height); size > 1; size >>= 1)
+		++count;
+	return count;
+}
+
+template<typename T>
+static void
+build_mipmap(synfig::Surface &dest, const T &src, int src_w, int src_h)
+{
+	// box filter, each source pixel goes to exactly one destination pixel
+	const int w = dest.get_w();
+	const int h = dest.get_h();
+
+	std::vector<int> cols(src_w);
+	std::vector<ColorReal> col_weights(w);
+	for(int x = 0; x < src_w; ++x) {
+		cols[x] = (int)((long long)x*w/src_w);
+		col_weights[cols[x]] += ColorReal(1);
+	}
+
+	std::vector<Color> row(w);
+	for(int y = 0, y0 = 0; y < h; ++y) {
+		int y1 = (int)((long long)(y + 1)*src_h/h);
+		std::fill(row.begin(), row.end(), Color());
+		for(int sy = y0; sy < y1; ++sy)
+			for(int x = 0; x < src_w; ++x)
+				row[cols[x]] += src(x, sy);
+
+		Color *dest_row = dest[y];
+		for(int x = 0; x < w; ++x)
+			dest_row[x] = row[x]/(col_weights[x]*ColorReal(y1 - y0));
+		y0 = y1;
+	}
+}
+
+namespace {
+	struct PackedReaderCook {
+		const PackedSurface::Reader &reader;
+		explicit PackedReaderCook(const PackedSurface::Reader &reader): reader(reader) { }
+		Color operator() (int x, int y) const { return ColorPrep::cook_static(reader.get_pixel(x, y)); }
+	};
+
+	struct SurfaceReader {
+		const synfig::Surface &surface;
+		explicit SurfaceReader(const synfig::Surface &surface): surface(surface) { }
+		Color operator() (int x, int y) const { return surface[y][x]; }
+	};
+}
+
+const synfig::Surface&
+PackedSurface::get_mipmap(int level) const
+{
+	assert(level > 0 && level <= get_mipmap_count());
+
+	std::lock_guard<std::mutex> lock(mipmap_mutex);
+	std::map<int, synfig::Surface>::iterator i = mipmaps.find(level);
+	if (i != mipmaps.end())
+		return i->second;
+
+	// build from the nearest finer level, or from the pixels if there is no such level
+	i = mipmaps.insert(std::make_pair(level, synfig::Surface())).first;
+	synfig::Surface &mipmap = i->second;
+	mipmap.set_wh(std::max(1, width >> level), std::max(1, height >> level));
+	if (i != mipmaps.begin()) {
+		const synfig::Surface &finer = (--i)->second;
+		build_mipmap(mipmap, SurfaceReader(finer), finer.get_w(), finer.get_h());
+	} else {
+		Reader reader(*this);
+		build_mipmap(mipmap, PackedReaderCook(reader), width, height);
+	}
+	mipmap_size += sizeof(Color)*mipmap.get_w()*mipmap.get_h();
+	return mipmap;
+}
+
+size_t
+PackedSurface::get_mipmap_size() const
+{
+	std::lock_guard<std::mutex> lock(mipmap_mutex);
+	return mipmap_size;
+}
+
 
 
 /* === E N T R Y P O I N T ================================================= */
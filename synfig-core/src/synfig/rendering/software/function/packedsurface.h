@@ -30,6 +30,7 @@
 
 /* === H E A D E R S ======================================================= */
 
+#include <map>
 #include <set>
 
 #include <synfig/real.h>
@@ -148,6 +149,10 @@ private:
 
 	std::vector<char> data;
 
+	mutable std::mutex mipmap_mutex;
+	mutable std::map<int, synfig::Surface> mipmaps;
+	mutable size_t mipmap_size;
+
 	static Color::value_type get_channel(const void *pixel, int offset, ChannelType type, Color::value_type constant, const Color::value_type *discrete_to_float);
 	static void set_channel(void *pixel, int offset, ChannelType type, Color::value_type color, const Color::value_type *discrete_to_float);
 
@@ -164,7 +169,16 @@ public:
 	void set_pixels(const Color *pixels, int width, int height, int pitch = 0);
 	int get_width() const { return width; }
 	int get_height() const { return height; }
+	size_t get_data_size() const { return data.size(); }
 	void get_pixels(Color *target) const;
+
+	//! Returns count of mipmap levels, the last one is 1 pixel width or height
+	int get_mipmap_count() const;
+	//! Returns the surface downscaled 2^level times with cooked colors,
+	//! it is built on first request and kept until the pixels are changed
+	const synfig::Surface& get_mipmap(int level) const;
+	//! Returns memory used by the mipmap levels built so far
+	size_t get_mipmap_size() const;
 };
 
 } /* end namespace software */
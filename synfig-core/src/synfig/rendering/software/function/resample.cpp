@@ -32,6 +32,9 @@
 #	include <config.h>
 #endif
 
+#include <cmath>
+#include <type_traits>
+
 #include <synfig/debug/debugsurface.h>
 
 #include "resample.h"
@@ -169,6 +172,12 @@ namespace {
 						fill_cut<pen, sampler_func>(p, i);
 			}
 
+			struct DefaultFill {
+				template<typename pen>
+				static inline void fill(Color::Interpolation interpolation, bool cut, pen &p, Iterator &i)
+					{ Generic::fill(interpolation, cut, p, i); }
+			};
+
 			template<typename pen>
 			static inline void fill(Color::Interpolation interpolation, bool cut, pen &p, Iterator &i)
 			{
@@ -206,6 +215,30 @@ namespace {
 				bool blend,
 				ColorReal blend_amount,
 				Color::BlendMethod blend_method )
+			{
+				resample_fill<DefaultFill>(
+					dest,
+					dest_bounds,
+					src,
+					src_bounds,
+					transformation,
+					interpolation,
+					blend,
+					blend_amount,
+					blend_method );
+			}
+
+			template<typename Filler>
+			static void resample_fill(
+				synfig::Surface &dest,
+				const RectInt &dest_bounds,
+				const void *src,
+				const RectInt &src_bounds,
+				const Matrix &transformation,
+				Color::Interpolation interpolation,
+				bool blend,
+				ColorReal blend_amount,
+				Color::BlendMethod blend_method )
 			{
 				// bounds
 
@@ -288,10 +321,10 @@ namespace {
 						synfig::Surface::alpha_pen p(dest.get_pen(bounds.minx, bounds.miny));
 						p.set_blend_method(blend_method);
 						p.set_alpha(blend_amount);
-						fill(interpolation, cut, p, i);
+						Filler::fill(interpolation, cut, p, i);
 					} else {
 						synfig::Surface::pen p(dest.get_pen(bounds.minx, bounds.miny));
-						fill(interpolation, cut, p, i);
+						Filler::fill(interpolation, cut, p, i);
 					}
 				}
 			}
@@ -487,6 +520,145 @@ namespace {
 			}
 		};
 	};
+
+	class Mipmap
+	{
+	public:
+		enum { MaxAnisotropy = 8 };
+
+		typedef Helper::Generic<synfig::Surface::reader, synfig::Surface::reader> Host;
+		typedef Host::Coord Coord;
+		typedef Host::SamplerFunc SamplerFunc;
+		typedef synfig::Surface::sampler<synfig::Surface::reader> LevelSampler;
+		typedef software::PackedSurface::Sampler SourceSampler;
+
+		//! Two neighbour levels, coordinates are given in the first (finer) one
+		struct Levels {
+			const void *surfaces[2];
+			Vector scale;
+			Vector step;
+			int taps;
+			ColorReal k;
+			Levels(): surfaces(), taps(1), k() { }
+		};
+
+		template<SamplerFunc sample0, SamplerFunc sample1>
+		static Color sample(const void *data, Coord x, Coord y)
+		{
+			const Levels &l = *(const Levels*)data;
+			Vector pos = Vector(x, y) - l.step*(0.5*(l.taps - 1));
+			Color c0, c1;
+			for(int i = 0; i < l.taps; ++i, pos += l.step) {
+				c0 += sample0(l.surfaces[0], pos[0], pos[1]);
+				if (l.surfaces[1])
+					c1 += sample1(
+						l.surfaces[1],
+						(pos[0] + 0.5)*l.scale[0] - 0.5,
+						(pos[1] + 0.5)*l.scale[1] - 0.5 );
+			}
+			Color c = l.surfaces[1] ? c0*(ColorReal(1) - l.k) + c1*l.k : c0;
+			return ColorPrep::uncook_static( c/(ColorReal)l.taps );
+		}
+
+		//! The first level may be the source surface itself
+		template<bool from_source>
+		struct Fill {
+			typedef typename std::conditional<from_source, SourceSampler, LevelSampler>::type FirstSampler;
+
+			template<typename pen>
+			static void fill(Color::Interpolation interpolation, bool cut, pen &p, Host::Iterator &i)
+			{
+				switch(interpolation)
+				{
+				case Color::INTERPOLATION_COSINE:
+					Host::fill< pen, sample<FirstSampler::cosine_sample, LevelSampler::cosine_sample> >(cut, true, p, i); break;
+				case Color::INTERPOLATION_CUBIC:
+					Host::fill< pen, sample<FirstSampler::cubic_sample, LevelSampler::cubic_sample> >(cut, true, p, i); break;
+				default:
+					Host::fill< pen, sample<FirstSampler::linear_sample, LevelSampler::linear_sample> >(cut, true, p, i); break;
+				}
+			}
+		};
+
+		//! Samples the mipmaps of \a src if the transformation downscales it,
+		//! returns false if the source should be sampled directly
+		static bool resample(
+			synfig::Surface &dest,
+			const RectInt &dest_bounds,
+			const software::PackedSurface &src,
+			const software::PackedSurface::Reader &src_reader,
+			const RectInt &src_bounds,
+			const Matrix &transformation,
+			Color::Interpolation interpolation,
+			bool blend,
+			ColorReal blend_amount,
+			Color::BlendMethod blend_method )
+		{
+			const Real threshold = 1.2;
+
+			if (interpolation == Color::INTERPOLATION_NEAREST)
+				return false;
+			const int count = src.get_mipmap_count();
+			if (!count)
+				return false;
+
+			// footprint of the destination pixel in source pixels
+			Matrix back_transformation = transformation.get_inverted();
+			Vector axis_x = back_transformation.get_transformed(Vector(1.0, 0.0), false);
+			Vector axis_y = back_transformation.get_transformed(Vector(0.0, 1.0), false);
+			Real length_x = axis_x.mag();
+			Real length_y = axis_y.mag();
+			Real major = std::max(length_x, length_y);
+			Real minor = std::min(length_x, length_y);
+			if (!(major > threshold) || !std::isfinite(major))
+				return false;
+
+			// anisotropic footprint is covered by several taps along the major axis,
+			// level is chosen by footprint of tap and blended with the next one (trilinear)
+			int taps = synfig::clamp((int)ceil(major/std::max(minor, real_low_precision<Real>())), 1, (int)MaxAnisotropy);
+			Real lod = std::max(Real(0), log2(major/taps));
+			int level = std::min((int)floor(lod), count);
+			ColorReal k = level < count ? (ColorReal)(lod - level) : ColorReal(0);
+
+			const int w = src.get_width();
+			const int h = src.get_height();
+			const synfig::Surface *level0 = level ? &src.get_mipmap(level) : nullptr;
+			const synfig::Surface *level1 = approximate_not_zero_lp(k) ? &src.get_mipmap(level + 1) : nullptr;
+			const int w0 = level0 ? level0->get_w() : w;
+			const int h0 = level0 ? level0->get_h() : h;
+
+			Levels levels;
+			levels.surfaces[0] = level0 ? (const void*)level0 : (const void*)&src_reader;
+			levels.surfaces[1] = level1;
+			levels.taps = taps;
+			levels.k = k;
+			if (level1)
+				levels.scale = Vector((Real)level1->get_w()/(Real)w0, (Real)level1->get_h()/(Real)h0);
+
+			Vector scale((Real)w0/(Real)w, (Real)h0/(Real)h);
+			const Vector &major_axis = length_x < length_y ? axis_y : axis_x;
+			if (taps > 1)
+				levels.step = Vector(major_axis[0]*scale[0], major_axis[1]*scale[1])/(Real)taps;
+
+			RectInt level_bounds(
+				(int)approximate_floor(src_bounds.minx*scale[0]),
+				(int)approximate_floor(src_bounds.miny*scale[1]),
+				(int)approximate_ceil (src_bounds.maxx*scale[0]),
+				(int)approximate_ceil (src_bounds.maxy*scale[1]) );
+			Matrix level_transformation = transformation
+										* Matrix().set_scale(1.0/scale[0], 1.0/scale[1]);
+
+			if (level0)
+				Host::resample_fill< Fill<false> >(
+					dest, dest_bounds, &levels, level_bounds, level_transformation,
+					interpolation, blend, blend_amount, blend_method );
+			else
+				Host::resample_fill< Fill<true> >(
+					dest, dest_bounds, &levels, level_bounds, level_transformation,
+					interpolation, blend, blend_amount, blend_method );
+			return true;
+		}
+	};
 }
 
 
@@ -561,7 +733,19 @@ software::Resample::resample(
 {
 	typedef software::PackedSurface::Reader Reader;
 	software::PackedSurface::Reader src_reader(src);
-	Helper::Generic<Reader::reader, Reader::reader_cook>::resample_with_downscale(
+	if (Mipmap::resample(
+			dest,
+			dest_bounds,
+			src,
+			src_reader,
+			src_bounds,
+			transformation,
+			interpolation,
+			blend,
+			blend_amount,
+			blend_method ))
+		return;
+	Helper::Generic<Reader::reader, Reader::reader_cook>::resample(
 		dest,
 		dest_bounds,
 		&src_reader,
@@ -33,6 +33,10 @@
 #  include <config.h>
 # endif
 
+# include <algorithm>
+# include <cmath>
+# include <vector>
+
 # include "taskdistortsw.h"
 
 #endif
@@ -43,12 +47,104 @@ using namespace synfig::rendering;
 
 /* === M A C R O S ========================================================= */
 
+//! Size of the initial cells of the adaptive grid, in pixels
+#define DISTORT_GRID_CELL_SIZE 16
+
 /* === G L O B A L S ======================================================= */
 
 /* === P R O C E D U R E S ================================================= */
 
 /* === M E T H O D S ======================================================= */
 
+//! Remapped positions of a strip of target pixels, in pixels of the source surface
+struct TaskDistortSW::Grid
+{
+	Vector origin;   //!< target position of the pixel (0, 0)
+	Vector axis_x;
+	Vector axis_y;
+	Vector offset;   //!< source position of the source pixel (0, 0)
+	Vector ppu;      //!< source pixels per unit
+	Real tolerance;
+	int source_w, source_h;
+	int strip_y;     //!< first row of the strip
+	int pitch;
+	Point *positions;
+
+	Point target(Real x, Real y) const
+		{ return origin + axis_x*x + axis_y*y; }
+	Point to_pixels(const Point &p) const
+		{ return Point((p[0] - offset[0])*ppu[0], (p[1] - offset[1])*ppu[1]); }
+	bool is_valid(const Point &p) const
+	{
+		return p[0] >= 0 && p[1] >= 0 && p[0] < source_w && p[1] < source_h;
+	}
+	Point& at(int x, int y) const
+		{ return positions[(y - strip_y)*pitch + x]; }
+};
+
+void
+TaskDistortSW::fill_cell(const Grid &grid, int x0, int y0, int w, int h, const Point corners[4]) const
+{
+	// small cells are evaluated exactly
+	if (w <= 2 || h <= 2) {
+		for(int y = 0; y < h; ++y)
+			for(int x = 0; x < w; ++x)
+				grid.at(x0 + x, y0 + y) = x || y ? grid.to_pixels(point_vfunc(grid.target(x0 + x, y0 + y))) : corners[0];
+		return;
+	}
+
+	// corners are ordered as: (x0, y0), (x0 + w, y0), (x0, y0 + h), (x0 + w, y0 + h)
+	bool valid = grid.is_valid(corners[0]) && grid.is_valid(corners[1])
+	          && grid.is_valid(corners[2]) && grid.is_valid(corners[3]);
+
+	// compare the middle points with the interpolated ones
+	const int xm = x0 + w/2;
+	const int ym = y0 + h/2;
+	const Real u = Real(xm - x0)/w;
+	const Real v = Real(ym - y0)/h;
+	const Point top    = grid.to_pixels(point_vfunc(grid.target(xm, y0)));
+	const Point left   = grid.to_pixels(point_vfunc(grid.target(x0, ym)));
+	const Point center = grid.to_pixels(point_vfunc(grid.target(xm, ym)));
+	const Point right  = grid.to_pixels(point_vfunc(grid.target(x0 + w, ym)));
+	const Point bottom = grid.to_pixels(point_vfunc(grid.target(xm, y0 + h)));
+
+	if (valid) {
+		// probes only estimate the error between them, so keep a margin
+		const Real tolerance2 = 0.25*grid.tolerance*grid.tolerance;
+		const Point top_i    = corners[0]*(1 - u) + corners[1]*u;
+		const Point bottom_i = corners[2]*(1 - u) + corners[3]*u;
+		valid = (top - top_i).mag_squared() <= tolerance2
+		     && (bottom - bottom_i).mag_squared() <= tolerance2
+		     && (left - (corners[0]*(1 - v) + corners[2]*v)).mag_squared() <= tolerance2
+		     && (right - (corners[1]*(1 - v) + corners[3]*v)).mag_squared() <= tolerance2
+		     && (center - (top_i*(1 - v) + bottom_i*v)).mag_squared() <= tolerance2;
+	}
+
+	if (valid) {
+		const Real kx = 1.0/w;
+		const Real ky = 1.0/h;
+		for(int y = 0; y < h; ++y) {
+			const Real ty = y*ky;
+			const Point row0 = corners[0]*(1 - ty) + corners[2]*ty;
+			const Point row1 = corners[1]*(1 - ty) + corners[3]*ty;
+			const Vector step = (row1 - row0)*kx;
+			Point p = row0;
+			for(int x = 0; x < w; ++x, p += step)
+				grid.at(x0 + x, y0 + y) = p;
+		}
+		return;
+	}
+
+	const Point c0[4] = { corners[0], top, left, center };
+	const Point c1[4] = { top, corners[1], center, right };
+	const Point c2[4] = { left, center, corners[2], bottom };
+	const Point c3[4] = { center, right, bottom, corners[3] };
+	fill_cell(grid, x0, y0, xm - x0, ym - y0, c0);
+	fill_cell(grid, xm, y0, x0 + w - xm, ym - y0, c1);
+	fill_cell(grid, x0, ym, xm - x0, y0 + h - ym, c2);
+	fill_cell(grid, xm, ym, x0 + w - xm, y0 + h - ym, c3);
+}
+
 bool TaskDistortSW::run_task(const rendering::TaskDistort& task) const
 {
 	if (!task.sub_task())
@@ -83,6 +179,51 @@ bool TaskDistortSW::run_task(const rendering::TaskDistort& task) const
 	Vector dy = inv_matrix.axis_y() - dx*(Real)tw;
 	Vector p = inv_matrix.get_transformed( Vector((Real)task.target_rect.minx, (Real)task.target_rect.miny) );
 
+	if (task.tolerance > 0) {
+		// evaluate the distortion on the adaptive grid, row of cells by row
+		const int th = task.target_rect.get_height();
+		const int cell = DISTORT_GRID_CELL_SIZE;
+		std::vector<Point> positions(tw*cell);
+
+		Grid grid;
+		grid.origin = p;
+		grid.axis_x = inv_matrix.axis_x();
+		grid.axis_y = inv_matrix.axis_y();
+		grid.offset = Vector(task.required_source_rect.minx, task.required_source_rect.miny);
+		grid.ppu = ppub;
+		grid.tolerance = task.tolerance;
+		grid.source_w = b.get_w();
+		grid.source_h = b.get_h();
+		grid.pitch = tw;
+		grid.positions = positions.data();
+
+		for (int y0 = 0; y0 < th; y0 += cell) {
+			const int h = std::min(cell, th - y0);
+			grid.strip_y = y0;
+			for (int x0 = 0; x0 < tw; x0 += cell) {
+				const int w = std::min(cell, tw - x0);
+				const Point corners[4] = {
+					grid.to_pixels(point_vfunc(grid.target(x0, y0))),
+					grid.to_pixels(point_vfunc(grid.target(x0 + w, y0))),
+					grid.to_pixels(point_vfunc(grid.target(x0, y0 + h))),
+					grid.to_pixels(point_vfunc(grid.target(x0 + w, y0 + h))) };
+				fill_cell(grid, x0, y0, w, h, corners);
+			}
+
+			for (int y = 0; y < h; ++y, pen.inc_y(), pen.dec_x(tw)) {
+				for (const Point *i = &grid.at(0, y0 + y), *end = i + tw; i < end; ++i, pen.inc_x()) {
+					float u = (*i)[0];
+					float v = (*i)[1];
+					if (u<0 || v<0 || u>=b.get_w() || v>=b.get_h() || std::isnan(u) || std::isnan(v))
+						pen.put_value(Color::magenta());
+					else
+						pen.put_value(b.cubic_sample(u,v));
+				}
+			}
+		}
+		return true;
+	}
+
 	for (int iy = task.target_rect.miny; iy < task.target_rect.maxy; ++iy, p += dy, pen.inc_y(), pen.dec_x(tw)) {
 		for (int ix = task.target_rect.minx; ix < task.target_rect.maxx; ++ix, p += dx, pen.inc_x()) {
 			Point tmp = point_vfunc(p);
@@ -55,10 +55,17 @@ namespace rendering
  *
  * The final task class should call run_task() in its run() method, that actually
  * calls point_vfunc() pixel by pixel of target surface.
+ * If TaskDistort::tolerance is set, point_vfunc() is called on a coarse grid,
+ * which is subdivided where the interpolated positions are not accurate enough.
  */
 class TaskDistortSW
 	: public synfig::rendering::TaskSW
 {
+private:
+	struct Grid;
+
+	void fill_cell(const Grid &grid, int x0, int y0, int w, int h, const Point corners[4]) const;
+
 protected:
 	/**
 	 * Convert @a point coordinates in target vectorial region to the vectorial coordinates in source region.
@@ -35,6 +35,8 @@
 
 #include "taskpaintpixelsw.h"
 
+#include <vector>
+
 #include <synfig/general.h>
 #include <synfig/localization.h>
 
@@ -71,6 +73,13 @@ synfig::rendering::TaskPaintPixelSW::get_supported_blend_methods() const
 	return Color::BLEND_METHODS_ALL;
 }
 
+void
+synfig::rendering::TaskPaintPixelSW::get_colors(const Vector* p, Color* colors, int count) const
+{
+	for(int i = 0; i < count; ++i)
+		colors[i] = get_color(p[i]);
+}
+
 bool
 synfig::rendering::TaskPaintPixelSW::run_task() const
 {
@@ -101,7 +110,7 @@ synfig::rendering::TaskPaintPixelSW::run_task() const
 
 	int tw = target_rect.get_width();
 	Vector dx = inv_matrix.axis_x();
-	Vector dy = inv_matrix.axis_y() - dx*(Real)tw;
+	Vector dy = inv_matrix.axis_y();
 	Vector p = inv_matrix.get_transformed( Vector((Real)target_rect.minx, (Real)target_rect.miny) );
 
 	pre_run(matrix, inv_matrix);
@@ -114,10 +123,15 @@ synfig::rendering::TaskPaintPixelSW::run_task() const
 	ColorReal amount = blend ? this->amount : ColorReal(1.0);
 	apen.set_blend_method(blend ? blend_method : Color::BLEND_COMPOSITE);
 
+	std::vector<Vector> positions(tw);
+	std::vector<Color> colors(tw);
 	for(int iy = target_rect.miny; iy < target_rect.maxy; ++iy, p += dy, apen.inc_y(), apen.dec_x(tw)) {
-		for(int ix = target_rect.minx; ix < target_rect.maxx; ++ix, p += dx, apen.inc_x()) {
-			apen.put_value(get_color(p), amount);
-		}
+		Vector pp = p;
+		for(int ix = 0; ix < tw; ++ix, pp += dx)
+			positions[ix] = pp;
+		get_colors(positions.data(), colors.data(), tw);
+		for(int ix = 0; ix < tw; ++ix, apen.inc_x())
+			apen.put_value(colors[ix], amount);
 	}
 
 	return true;
@@ -71,6 +71,11 @@ public:
 	//! Fetch color at position p (in synfig units) when antialias is false
 	virtual Color get_color(const Vector& p) const = 0;
 
+	//! Fetch colors for a whole row of positions at once.
+	//! Default implementation calls get_color() for each position,
+	//! override it when several pixels can be evaluated together.
+	virtual void get_colors(const Vector* p, Color* colors, int count) const;
+
 	//! Call this method from run() method of the real task implementation
 	virtual bool run_task() const;
 
@@ -58,7 +58,9 @@
 #include "transformation.h"
 
 #include "zstreambuf.h"
+#include "threadpool.h"
 #include "importer.h"
+#include "canvasbinary.h"
 
 #include <libxml++/libxml++.h>
 #include "gradient.h"
@@ -1023,46 +1025,84 @@ xmlpp::Element* encode_canvas_toplevel(xmlpp::Element* root,Canvas::ConstHandle
 	return ret;
 }
 
-bool
-synfig::save_canvas(const FileSystem::Identifier &identifier, Canvas::ConstHandle canvas, bool safe)
+std::shared_ptr<xmlpp::Document>
+synfig::encode_canvas_document(Canvas::ConstHandle canvas)
 {
-    ChangeLocale change_locale(LC_NUMERIC, "C");
-
-	synfig::String tmp_filename(identifier.filename.u8string());
-	if (safe)
-		tmp_filename.append(".TMP");
+	ChangeLocale change_locale(LC_NUMERIC, "C");
+	assert(canvas);
 
 	try
 	{
-		assert(canvas);
-		xmlpp::Document document;
+		std::shared_ptr<xmlpp::Document> document = std::make_shared<xmlpp::Document>();
+		encode_canvas_toplevel(document->create_root_node("canvas"),canvas);
+		return document;
+	}
+	catch(...) { synfig::error("synfig::encode_canvas_document(): Caught unknown exception"); }
 
-		encode_canvas_toplevel(document.create_root_node("canvas"),canvas);
+	return nullptr;
+}
 
-		FileSystem::WriteStream::Handle stream = identifier.file_system->get_write_stream(tmp_filename);
-		if (!stream)
-		{
-			synfig::error("synfig::save_canvas(): Unable to open file for write");
-			return false;
-		}
+bool
+synfig::write_canvas_document(FileSystem::WriteStream::Handle stream, xmlpp::Document &document, bool compress, bool fast)
+{
+	if (!stream)
+		return false;
 
-		if (identifier.filename.extension().u8string() == ".sifz")
-			stream = FileSystem::WriteStream::Handle(new ZWriteStream(stream));
+	try
+	{
+		if (compress)
+			stream = FileSystem::WriteStream::Handle(fast
+				? new ZWriteStream(stream, Z_BEST_SPEED)
+				: new ZWriteStream(stream, Z_BEST_COMPRESSION, ThreadPool::instance().get_max_threads()) );
 
 		document.write_to_stream_formatted(*stream, "UTF-8");
+	}
+	catch(...) { synfig::error("synfig::write_canvas_document(): Caught unknown exception"); return false; }
 
-		// close stream
-		stream.reset();
+	return true;
+}
 
-		if (safe)
-		{
-			if (!identifier.file_system->file_rename(tmp_filename, identifier.filename.u8string())) {
-				synfig::error("synfig::save_canvas(): Unable to rename file to correct filename");
-				return false;
-			}
+bool
+synfig::write_canvas_document_binary(FileSystem::WriteStream::Handle stream, xmlpp::Document &document)
+{
+	return stream && CanvasBinary::write(*stream, document);
+}
+
+bool
+synfig::save_canvas(const FileSystem::Identifier &identifier, Canvas::ConstHandle canvas, bool safe)
+{
+	synfig::String tmp_filename(identifier.filename.u8string());
+	if (safe)
+		tmp_filename.append(".TMP");
+
+	std::shared_ptr<xmlpp::Document> document = encode_canvas_document(canvas);
+	if (!document)
+		return false;
+
+	FileSystem::WriteStream::Handle stream = identifier.file_system->get_write_stream(tmp_filename);
+	if (!stream)
+	{
+		synfig::error("synfig::save_canvas(): Unable to open file for write");
+		return false;
+	}
+
+	const String extension = identifier.filename.extension().u8string();
+	const bool written = extension == ".sifb"
+		? write_canvas_document_binary(stream, *document)
+		: write_canvas_document(stream, *document, extension == ".sifz");
+	if (!written)
+		return false;
+
+	// close stream
+	stream.reset();
+
+	if (safe)
+	{
+		if (!identifier.file_system->file_rename(tmp_filename, identifier.filename.u8string())) {
+			synfig::error("synfig::save_canvas(): Unable to rename file to correct filename");
+			return false;
 		}
 	}
-	catch(...) { synfig::error("synfig::save_canvas(): Caught unknown exception"); return false; }
 
 	return true;
 }
@@ -32,6 +32,7 @@
 /* === H E A D E R S ======================================================= */
 
 #include <list>
+#include <memory>
 #include "string.h"
 #include "canvas.h"
 #include "releases.h"
@@ -43,6 +44,10 @@
 
 /* === C L A S S E S & S T R U C T S ======================================= */
 
+namespace xmlpp {
+class Document;
+}
+
 namespace synfig {
 
 /* === E X T E R N S ======================================================= */
@@ -54,6 +59,23 @@ typedef bool (*save_canvas_external_file_callback_t)(void *user_data, Layer::Con
 /*!	\return	\c true on success, \c false on error. */
 bool save_canvas(const FileSystem::Identifier &identifier, Canvas::ConstHandle canvas, bool safe = true);
 
+//! Encodes a Canvas into a XML document detached from the canvas
+/*!	The document can be written with write_canvas_document() later,
+**	even from another thread while the canvas is being edited.
+**	\return The document, or null on error */
+std::shared_ptr<xmlpp::Document> encode_canvas_document(Canvas::ConstHandle canvas);
+
+//!	Writes a document made by encode_canvas_document() to \a stream
+/*!	\param compress if \c true, stream is gzip-compressed (.sifz)
+**	\param fast if \c true, the fastest compression level is used (autosave),
+**	       else the best one, compressed by all threads of the thread pool
+**	\return	\c true on success, \c false on error. */
+bool write_canvas_document(FileSystem::WriteStream::Handle stream, xmlpp::Document &document, bool compress, bool fast = false);
+
+//!	Writes a document made by encode_canvas_document() to \a stream in binary form (.sifb)
+/*!	\return	\c true on success, \c false on error. */
+bool write_canvas_document_binary(FileSystem::WriteStream::Handle stream, xmlpp::Document &document);
+
 //! Stores a Canvas in a string in XML format
 /*! \return The string with the XML canvas definition */
 String canvas_to_string(Canvas::ConstHandle canvas);
@@ -33,6 +33,7 @@
 #include "target.h"
 #include "string.h"
 #include "canvas.h"
+#include "module.h"
 #include "target_null.h"
 #include "target_null_tile.h"
 #include "targetparam.h"
@@ -108,7 +109,10 @@ Target::Handle
 Target::create(const String& name, const filesystem::Path& filename,
 			   const synfig::TargetParam& params)
 {
-	if(!book().count(name))
+	if(book().count(name) && !book()[name].factory)
+		Module::load_provider(Module::ENTRY_TARGET, name);
+
+	if(!book().count(name) || !book()[name].factory)
 		return Target::Handle();
 
 	return Target::Handle(book()[name].factory(filename, params));
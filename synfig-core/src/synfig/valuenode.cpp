@@ -142,6 +142,12 @@ ValueNode::on_changed()
 	DEBUG_LOG("SYNFIG_DEBUG_ON_CHANGED",
 		"%s:%d ValueNode::on_changed()\n", __FILE__, __LINE__);
 
+	Node::on_changed();
+}
+
+void
+ValueNode::notify_changed()
+{
 	Canvas::LooseHandle parent_canvas = get_parent_canvas();
 	if(parent_canvas)
 		do						// signal to all the ancestor canvases
@@ -150,7 +156,7 @@ ValueNode::on_changed()
 	else if(get_root_canvas())
 		get_root_canvas()->signal_value_node_changed()(this);
 
-	Node::on_changed();
+	Node::notify_changed();
 }
 
 int
@@ -286,6 +286,8 @@ protected:
 
 	virtual void on_changed();
 
+	virtual void notify_changed();
+
 	virtual void get_values_vfunc(std::map<Time, ValueBase> &x) const;
 }; // END of class ValueNode
 
@@ -29,6 +29,7 @@
 
 #include "general.h"
 #include "localization.h"
+#include "module.h"
 
 /* === U S I N G =========================================================== */
 
@@ -80,7 +81,12 @@ ValueNodeRegistry::create(const String &name, const ValueBase& x)
 {
 	// forbid creating a node if class is not registered
 	auto iter = ValueNodeRegistry::book().find(name);
-	if(iter == ValueNodeRegistry::book().end()) {
+	if(iter != ValueNodeRegistry::book().end() && !iter->second.factory) {
+		// placeholder of the value node from the module which is not loaded yet
+		Module::load_provider(Module::ENTRY_VALUENODE, name);
+		iter = ValueNodeRegistry::book().find(name);
+	}
+	if(iter == ValueNodeRegistry::book().end() || !iter->second.factory) {
 		error(_("Bad name: ValueNode type name '%s' isn't registered"), name.c_str());
 		return nullptr;
 	}
@@ -105,6 +111,10 @@ ValueNodeRegistry::check_type(const String &name, Type &x)
 		return true;
 
 	auto iter = ValueNodeRegistry::book().find(name);
+	if(iter != ValueNodeRegistry::book().end() && !iter->second.check_type) {
+		Module::load_provider(Module::ENTRY_VALUENODE, name);
+		iter = ValueNodeRegistry::book().find(name);
+	}
 	if(iter == ValueNodeRegistry::book().end() || !iter->second.check_type)
 		return false;
 	return iter->second.check_type(x);
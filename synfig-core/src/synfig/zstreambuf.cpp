@@ -32,8 +32,13 @@
 #	include <config.h>
 #endif
 
+#include <algorithm>
 #include <cstring>
+
+#include <sigc++/bind.h>
+
 #include "zstreambuf.h"
+#include "threadpool.h"
 
 #endif
 
@@ -47,20 +52,89 @@ using namespace synfig;
 
 /* === P R O C E D U R E S ================================================= */
 
+namespace {
+	//! A piece of input compressed independently by the parallel gzip
+	struct ParallelBlock {
+		const char *data;
+		size_t size;
+		const char *dictionary;
+		size_t dictionary_size;
+		bool last;
+		std::vector<char> output;
+		uLong crc;
+		bool success;
+
+		ParallelBlock(): data(), size(), dictionary(), dictionary_size(), last(), crc(), success() { }
+	};
+
+	//! Makes raw deflate data, which ends at a byte boundary (Z_SYNC_FLUSH),
+	//! or with the final block if it is the last one
+	void deflate_parallel_block(ParallelBlock *block, int compression_level)
+	{
+		block->crc = crc32(crc32(0L, Z_NULL, 0), (const Bytef*)block->data, (uInt)block->size);
+
+		z_stream stream;
+		memset(&stream, 0, sizeof(stream));
+		if (Z_OK != deflateInit2(&stream,
+				compression_level,
+				zstreambuf::option_method,
+				-MAX_WBITS,
+				zstreambuf::option_mem_level,
+				zstreambuf::option_strategy ))
+			return;
+		if (block->dictionary_size)
+			deflateSetDictionary(&stream, (const Bytef*)block->dictionary, (uInt)block->dictionary_size);
+
+		block->output.resize(deflateBound(&stream, block->size) + 16);
+		stream.next_in = (Bytef*)const_cast<char*>(block->data);
+		stream.avail_in = (uInt)block->size;
+		const int flush = block->last ? Z_FINISH : Z_SYNC_FLUSH;
+		while(true) {
+			if (stream.total_out >= block->output.size())
+				block->output.resize(2*block->output.size());
+			stream.next_out = (Bytef*)&block->output[stream.total_out];
+			stream.avail_out = (uInt)(block->output.size() - stream.total_out);
+
+			int ret = ::deflate(&stream, flush);
+			if (ret == Z_STREAM_ERROR)
+				break;
+			// sync flush is complete when some output space is left
+			if (block->last ? ret == Z_STREAM_END : stream.avail_in == 0 && stream.avail_out != 0) {
+				block->output.resize(stream.total_out);
+				block->success = true;
+				break;
+			}
+		}
+		deflateEnd(&stream);
+	}
+
+	void put_u32_le(std::vector<char> &out, uLong x)
+	{
+		for(int i = 0; i < 4; ++i)
+			out.push_back((char)((x >> (8*i)) & 0xff));
+	}
+}
+
 /* === M E T H O D S ======================================================= */
 
-zstreambuf::zstreambuf(std::streambuf *buf, zstreambuf::compression compression):
+zstreambuf::zstreambuf(std::streambuf *buf, zstreambuf::compression compression, int compression_level, int threads):
 	buf_(buf),
 	compression_(compression),
+	compression_level_(compression_level),
+	threads_(compression == compression::gzip ? std::max(1, threads) : 1),
 	inflate_initialized(false),
 	inflate_stream_{},
 	deflate_initialized(false),
-	deflate_stream_{}
+	deflate_stream_{},
+	parallel_started_(false),
+	parallel_crc_(0),
+	parallel_size_(0)
 {
 }
 
 zstreambuf::~zstreambuf()
 {
+	if (threads_ > 1) deflate_buf_parallel(true);
 	sync();
 	if (inflate_initialized) inflateEnd(&inflate_stream_);
 	if (deflate_initialized) deflateEnd(&deflate_stream_);
@@ -201,6 +275,9 @@ bool zstreambuf::inflate_buf()
 
 bool zstreambuf::deflate_buf(bool flush)
 {
+	if (threads_ > 1)
+		return deflate_buf_parallel(flush);
+
 	if (pbase() && pptr() > pbase())
 	{
 		// initialize deflate if need
@@ -209,7 +286,7 @@ bool zstreambuf::deflate_buf(bool flush)
 			memset(&deflate_stream_, 0, sizeof(deflate_stream_));
 
 			if (Z_OK != deflateInit2(&deflate_stream_,
-					option_compression_level,
+					compression_level_,
 					option_method,
 					option_window_bits,
 					option_mem_level,
@@ -238,9 +315,100 @@ bool zstreambuf::deflate_buf(bool flush)
 	return true;
 }
 
+bool zstreambuf::deflate_buf_parallel(bool flush)
+{
+	const size_t size = pbase() ? pptr() - pbase() : 0;
+	if (!size && !(flush && parallel_started_))
+		return true;
+
+	std::vector<char> header;
+	if (!parallel_started_) {
+		// gzip member header: magic, deflate, no flags, no time, unknown OS
+		const char gzip_header[] = { '\x1f', '\x8b', 8, 0, 0, 0, 0, 0, 0, '\xff' };
+		header.assign(gzip_header, gzip_header + sizeof(gzip_header));
+		parallel_crc_ = crc32(0L, Z_NULL, 0);
+		parallel_size_ = 0;
+		parallel_dictionary_.clear();
+		parallel_started_ = true;
+	}
+
+	// split input into blocks, each block uses the end of the previous one as a dictionary
+	const size_t block_size = parallel_option_block_size;
+	const size_t count = std::max(size_t(1), (size + block_size - 1)/block_size);
+	std::vector<ParallelBlock> blocks(count);
+	for(size_t i = 0; i < count; ++i) {
+		ParallelBlock &block = blocks[i];
+		block.data = pbase() + i*block_size;
+		block.size = std::min(block_size, size - std::min(size, i*block_size));
+		block.last = flush && i + 1 == count;
+		if (i) {
+			block.dictionary_size = std::min(block_size, (size_t)parallel_option_dictionary_size);
+			block.dictionary = block.data - block.dictionary_size;
+		} else
+		if (!parallel_dictionary_.empty()) {
+			block.dictionary = parallel_dictionary_.data();
+			block.dictionary_size = parallel_dictionary_.size();
+		}
+	}
+
+	if (count > 1) {
+		ThreadPool::Group group;
+		for(size_t i = 0; i < count; ++i)
+			group.enqueue(sigc::bind(sigc::ptr_fun(&deflate_parallel_block), &blocks[i], compression_level_));
+		group.run();
+	} else {
+		deflate_parallel_block(&blocks.front(), compression_level_);
+	}
+
+	if (!header.empty())
+		buf_->sputn(header.data(), header.size());
+	for(size_t i = 0; i < count; ++i) {
+		const ParallelBlock &block = blocks[i];
+		if (!block.success)
+			return false;
+		buf_->sputn(block.output.data(), block.output.size());
+		parallel_crc_ = crc32_combine(parallel_crc_, block.crc, (z_off_t)block.size);
+		parallel_size_ += block.size;
+	}
+
+	if (flush) {
+		// gzip member trailer, the next data will start a new member
+		std::vector<char> trailer;
+		put_u32_le(trailer, parallel_crc_);
+		put_u32_le(trailer, parallel_size_);
+		buf_->sputn(trailer.data(), trailer.size());
+		parallel_started_ = false;
+		parallel_dictionary_.clear();
+	} else {
+		parallel_dictionary_.insert(parallel_dictionary_.end(), pbase(), pptr());
+		if (parallel_dictionary_.size() > parallel_option_dictionary_size)
+			parallel_dictionary_.erase(
+				parallel_dictionary_.begin(),
+				parallel_dictionary_.end() - parallel_option_dictionary_size );
+	}
+
+	setp(nullptr, nullptr);
+	return true;
+}
+
+bool zstreambuf::prepare_write_buffer()
+{
+	if (pptr() < epptr())
+		return true;
+
+	// save data and prepare new buffer
+	if (!deflate_buf(false)) return false;
+	const size_t size = threads_ > 1 ? (size_t)threads_*parallel_option_block_size : (size_t)option_bufsize;
+	if (write_buffer_.size() < size) write_buffer_.resize(size);
+	char *pointer = &write_buffer_.front();
+	setp(pointer, pointer + write_buffer_.size());
+	return true;
+}
+
 int zstreambuf::sync()
 {
-	bool deflate_success = deflate_buf(true);
+	// parallel gzip member stays open until destruction, it is just flushed to the byte boundary
+	bool deflate_success = deflate_buf(threads_ <= 1);
 	bool buf_sync_success = 0 == buf_->pubsync();
 	return deflate_success && buf_sync_success ? 0 : -1;
 }
@@ -258,14 +426,7 @@ int zstreambuf::overflow(int c)
 	// flush
 	if (c == traits_type::eof()) { sync(); return traits_type::eof(); }
 
-	// save data and prepare new buffer
-	if (pptr() >= epptr())
-	{
-		if (!deflate_buf(false)) return traits_type::eof();
-		if (write_buffer_.size() < option_bufsize) write_buffer_.resize(option_bufsize);
-		char *pointer = &write_buffer_.front();
-		setp(pointer, pointer + write_buffer_.size());
-	}
+	if (!prepare_write_buffer()) return traits_type::eof();
 
 	// put character
 	*pptr() = traits_type::to_char_type(c);
@@ -273,5 +434,19 @@ int zstreambuf::overflow(int c)
 	return c;
 }
 
+std::streamsize zstreambuf::xsputn(const char *s, std::streamsize n)
+{
+	// copy whole pieces into the write buffer
+	std::streamsize written = 0;
+	while(written < n) {
+		if (!prepare_write_buffer()) break;
+		std::streamsize size = std::min(n - written, (std::streamsize)(epptr() - pptr()));
+		memcpy(pptr(), s + written, size);
+		pbump((int)size);
+		written += size;
+	}
+	return written;
+}
+
 /* === E N T R Y P O I N T ================================================= */
 
@@ -67,12 +67,19 @@ namespace synfig {
 
 			fast_option_compression_level = Z_BEST_SPEED,
 			fast_option_mem_level		= 9,
-			fast_option_strategy		= Z_FIXED
+			fast_option_strategy		= Z_FIXED,
+
+			//! input size compressed by one thread in parallel gzip mode
+			parallel_option_block_size	= 256*1024,
+			//! each block is compressed with this much of the previous input as a dictionary
+			parallel_option_dictionary_size = 32*1024
 		};
 
 	private:
 		std::streambuf *buf_;
 		zstreambuf::compression compression_;
+		int compression_level_;
+		int threads_;
 
 		bool inflate_initialized;
 		z_stream inflate_stream_;
@@ -82,17 +89,31 @@ namespace synfig {
 		z_stream deflate_stream_;
 		std::vector<char> write_buffer_;
 
+		//! parallel gzip: a gzip member is open
+		bool parallel_started_;
+		uLong parallel_crc_;
+		uLong parallel_size_;
+		//! parallel gzip: tail of the previous input, used as a dictionary for the next block
+		std::vector<char> parallel_dictionary_;
+
 		bool inflate_buf();
 		bool deflate_buf(bool flush);
+		bool deflate_buf_parallel(bool flush);
+		bool prepare_write_buffer();
 
 	public:
-		zstreambuf(std::streambuf *buf, zstreambuf::compression compression);
+		//! \param compression_level zlib level used for writing, from Z_BEST_SPEED to Z_BEST_COMPRESSION
+		//! \param threads if greater than 1, the gzip output is compressed by independent blocks in parallel,
+		//!        concatenated blocks form a usual gzip stream
+		zstreambuf(std::streambuf *buf, zstreambuf::compression compression,
+			int compression_level = option_compression_level, int threads = 1);
 		virtual ~zstreambuf();
 
 	protected:
 		int sync() override;
 		int underflow() override;
 		int overflow(int c = traits_type::eof()) override;
+		std::streamsize xsputn(const char *s, std::streamsize n) override;
 
 	public:
 		static bool pack(std::vector<char> &dest, const void *src, size_t size, bool fast = false);
@@ -133,23 +154,18 @@ namespace synfig {
 	private:
 		FileSystem::WriteStream::Handle stream_;
 		zstreambuf buf_;
-		std::ostream ostream_;
 
 	protected:
 		virtual size_t internal_write(const void *buffer, size_t size)
-		{
-			for(size_t i = 0; i < size; i++)
-				if (!ostream_.put(((const char*)buffer)[i]).good())
-					return i;
-			return size;
-		}
+			{ return (size_t)buf_.sputn((const char*)buffer, size); }
 
 	public:
-		ZWriteStream(FileSystem::WriteStream::Handle stream):
+		//! \see zstreambuf::zstreambuf()
+		ZWriteStream(FileSystem::WriteStream::Handle stream,
+				int compression_level = zstreambuf::option_compression_level, int threads = 1):
 			FileSystem::WriteStream(stream->file_system()),
 			stream_(stream),
-			buf_(stream_->rdbuf(), zstreambuf::compression::gzip),
-			ostream_(&buf_)
+			buf_(stream_->rdbuf(), zstreambuf::compression::gzip, compression_level, threads)
 		{ }
 	};
 }
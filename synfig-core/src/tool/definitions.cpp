@@ -38,6 +38,7 @@ SynfigToolGeneralOptions::SynfigToolGeneralOptions()
 	  _threads(1),
 	  _should_be_quiet(false),
 	  _should_print_benchmarks(false),
+	  _should_print_startup_profile(false),
 	  _repeats(1)
 { }
 
@@ -94,6 +95,16 @@ void SynfigToolGeneralOptions::set_should_print_benchmarks(bool print_benchmarks
 	_should_print_benchmarks = print_benchmarks;
 }
 
+bool SynfigToolGeneralOptions::should_print_startup_profile() const
+{
+	return _should_print_startup_profile;
+}
+
+void SynfigToolGeneralOptions::set_should_print_startup_profile(bool print_startup_profile)
+{
+	_should_print_startup_profile = print_startup_profile;
+}
+
 int SynfigToolGeneralOptions::get_repeats() const
 {
 	return _repeats;
@@ -110,6 +110,10 @@ public:
 
 	void set_should_print_benchmarks(bool print_benchmarks);
 
+	bool should_print_startup_profile() const;
+
+	void set_should_print_startup_profile(bool print_startup_profile);
+
 	int get_repeats() const;
 
 	void set_repeats(int repeats);
@@ -120,7 +124,8 @@ private:
 	int _verbosity;
 	size_t _threads;
 	bool _should_be_quiet,
-		 _should_print_benchmarks;
+		 _should_print_benchmarks,
+		 _should_print_startup_profile;
 
 	int _repeats;
 };
@@ -44,6 +44,7 @@
 #include <synfig/target_tile.h>
 #include <synfig/savecanvas.h>
 #include <synfig/filesystemnative.h>
+#include <synfig/listimporter.h>
 
 #include "definitions.h"
 #include "synfigtoolexception.h"
@@ -249,6 +250,7 @@ static void save_canvas_to_file(const std::string& filename, const synfig::Canva
 
 void render_job(const Job& job, RenderProgress& progress, bool should_print_benchmarks, int repeats) {
 	double total_duration = 0.f;
+	ListImporter::reset_statistics();
 
 	for(int i = 0; i < repeats; i++)
 	{
@@ -279,6 +281,16 @@ void render_job(const Job& job, RenderProgress& progress, bool should_print_benc
 				  << _(" Average time per render: ")
 				  << total_duration / repeats
 				  << _(" ms.") << std::endl;
+
+		ListImporter::Statistics stats = ListImporter::get_statistics();
+		if (stats.frames)
+			std::cout << job.filename.c_str()
+					  << _(": Image sequence frames: ") << stats.frames
+					  << _(", read ahead: ") << stats.ready
+					  << _(", stalled: ") << stats.stalls
+					  << _(", missed: ") << stats.misses
+					  << _(", waiting time: ") << stats.stall_time*1000.0
+					  << _(" ms.") << std::endl;
 	}
 }
 
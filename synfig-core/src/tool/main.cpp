@@ -43,6 +43,7 @@
 
 #include <synfig/localization.h>
 #include <synfig/main.h>
+#include <synfig/module.h>
 #include <synfig/version.h>
 #include <autorevision.h>
 #include "definitions.h"
@@ -52,6 +53,7 @@
 #include "optionsprocessor.h"
 #include "joblistprocessor.h"
 #include "printing_functions.h"
+#include "renderserver.h"
 
 #endif
 
@@ -112,14 +114,31 @@ int main(int argc, char* argv[])
 		// Trivial info options -----------------------------------------------
 		parser.process_trivial_info_options();
 
+		// Modules are loaded on first use of their layers, targets, importers
+		// and value nodes, a single render rarely needs all of them
+		synfig::Module::set_lazy_loading(true);
+
 		// Synfig Main initialization needs to be after verbose and
 		// before any other where it's used
 		Progress p(binary_path.c_str());
 		synfig::Main synfig_main(root_path, &p);
 
+		// Printed on exit, to include modules loaded on first use
+		struct StartupProfilePrinter {
+			~StartupProfilePrinter() {
+				if (SynfigToolGeneralOptions::instance()->should_print_startup_profile())
+					print_startup_profile();
+			}
+		} startup_profile_printer;
+
 		// Info options -----------------------------------------------
 		parser.process_info_options();
 
+		// Server mode keeps modules and documents loaded between the jobs
+		const std::string serve_path = parser.extract_serve_path();
+		if (!serve_path.empty())
+			return RenderServer(parser.extract_targetparam()).run(serve_path);
+
 		std::list<Job> job_list;
 
 		// Processing --------------------------------------------------
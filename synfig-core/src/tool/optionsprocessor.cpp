@@ -114,12 +114,14 @@ SynfigCommandLineParser::SynfigCommandLineParser() :
 	sw_verbosity(),
 	sw_quiet(),
 	sw_print_benchmarks(),
+	sw_startup_profile(),
 	sw_extract_alpha(),
 
 	// Misc group
 	misc_append_filename(),
 	misc_canvas_info(),
 	misc_canvases(),
+	misc_serve(),
 
 	//FFMPEG group
 	video_codec(),
@@ -176,12 +178,14 @@ SynfigCommandLineParser::SynfigCommandLineParser() :
 	add_option(og_switch, "verbose",       'v', sw_verbosity, 			_("Output verbosity level"), "NUM");
 	add_option(og_switch, "quiet",         'q', sw_quiet, 				_("Quiet mode (No progress/time-remaining display)"), "");
 	add_option(og_switch, "benchmarks",    'b', sw_print_benchmarks,	_("Print benchmarks"), "");
+	add_option(og_switch, "startup-profile", ' ', sw_startup_profile,	_("Print time spent on loading modules and starting subsystems"), "");
 	add_option(og_switch, "extract-alpha", 'x', sw_extract_alpha, 		_("Extract alpha"), "");
 
 	//SynfigOptionGroup og_misc("misc", _("Misc options"), "Show Misc options help");
 	add_option_filename(og_misc, "append", ' ', misc_append_filename, 	_("Append layers in <filename> to composition"), _("filename"));
 	add_option(og_misc, "canvas-info",     ' ', misc_canvas_info, 			_("Print out specified details of the root canvas"), _("fields"));
 	add_option(og_misc, "canvases",		   ' ', misc_canvases,				_("Print out the list of exported canvases in the composition"), "");
+	add_option(og_misc, "serve",           ' ', misc_serve,					_("Keep running and render jobs received as JSON lines on the Unix socket <path>, or on standard input if <path> is \"-\""), _("path"));
 
 	//SynfigOptionGroup og_ffmpeg("ffmpeg", _("FFMPEG target options"), "Show FFMPEG target options help");
 	add_option(og_ffmpeg, "video-codec",   ' ', video_codec, 	_("Set the codec for the video. See --target-video-codecs"), _("codec"));
@@ -357,6 +361,11 @@ void SynfigCommandLineParser::process_settings_options() const
 		SynfigToolGeneralOptions::instance()->set_should_print_benchmarks(true);
 	}
 
+	if (sw_startup_profile)
+	{
+		SynfigToolGeneralOptions::instance()->set_should_print_startup_profile(true);
+	}
+
 	if(set_repeats > 0)
 	{
 		SynfigToolGeneralOptions::instance()->set_repeats(set_repeats);
@@ -477,6 +486,7 @@ void SynfigCommandLineParser::process_info_options()
 	}
 
 	if (show_modules) {
+		synfig::Module::load_deferred();
 		for (const auto& iter : synfig::Module::book()) {
 			std::cout << (iter.first).c_str() << std::endl;
 		}
@@ -657,6 +667,11 @@ TargetParam SynfigCommandLineParser::extract_targetparam()
 	return params;
 }
 
+std::string SynfigCommandLineParser::extract_serve_path() const
+{
+	return misc_serve;
+}
+
 Job SynfigCommandLineParser::extract_job()
 {
 	Job job;
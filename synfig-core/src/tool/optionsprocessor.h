@@ -71,6 +71,11 @@ public:
 	/// canvas-info
 	void extract_canvas_info(Job& job);
 
+	/// Path of the socket to serve render jobs on, "-" for standard input,
+	/// or empty if the server mode is not requested
+	/// serve
+	std::string extract_serve_path() const;
+
 	void print_target_video_codecs_help() const;
 
 #ifdef _DEBUG
@@ -123,12 +128,14 @@ private:
 	int				sw_verbosity;
 	bool			sw_quiet;
 	bool			sw_print_benchmarks;
+	bool			sw_startup_profile;
 	bool			sw_extract_alpha;
 
 	// Misc group
 	std::string		misc_append_filename;
 	Glib::ustring	misc_canvas_info;
 	bool			misc_canvases;
+	Glib::ustring	misc_serve;
 
 	//FFMPEG group
 	Glib::ustring	video_codec;
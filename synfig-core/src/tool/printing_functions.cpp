@@ -35,6 +35,8 @@
 #include <iostream>
 #include <string>
 #include <synfig/canvas.h>
+#include <synfig/general.h>
+#include <synfig/main.h>
 #include <synfig/target.h>
 #include "definitions.h"
 #include "job.h"
@@ -260,3 +262,17 @@ void print_canvas_info(const Job& job)
 			std::cout << (*key).c_str() << "=" << canvas->get_meta_data(*key).c_str()<< std::endl;
 	}
 }
+
+void print_startup_profile()
+{
+	// standard output may be used by the server mode
+	std::vector<synfig::Main::ProfileEntry> profile = synfig::Main::get_startup_profile();
+	Real total = 0.0;
+	std::cerr << std::endl << "# " << _("Startup profile") << std::endl;
+	for (const synfig::Main::ProfileEntry& entry : profile)
+	{
+		std::cerr << strprintf("%10.3f ms  ", entry.time*1000.0) << entry.task << std::endl;
+		total += entry.time;
+	}
+	std::cerr << strprintf("%10.3f ms  ", total*1000.0) << _("Total") << std::endl;
+}
@@ -36,4 +36,8 @@ void print_child_canvases(const std::string& prefix,
 
 void print_canvas_info(const Job& job);
 
+/// Print time spent on each step of the initialization of synfig::Main,
+/// and on the modules loaded on first use
+void print_startup_profile();
+
 #endif // __SYNFIG_PRINTING_FUNCTIONS_H
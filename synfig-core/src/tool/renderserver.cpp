@@ -0,0 +1,644 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file tool/renderserver.cpp
+**	\brief Implementation of the render server of the command line tool
+**
+**	\legal
+**	Copyright (c) 2022 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+#ifdef USING_PCH
+#	include "pch.h"
+#else
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include <glib/gstdio.h>
+
+#include <synfig/general.h>
+#include <synfig/imagecache.h>
+#include <synfig/localization.h>
+#include <synfig/canvasfilenaming.h>
+#include <synfig/filesystemnative.h>
+#include <synfig/loadcanvas.h>
+#include <synfig/savecanvas.h>
+#include <synfig/rendering/renderer.h>
+
+#include "definitions.h"
+#include "synfigtoolexception.h"
+#include "joblistprocessor.h"
+#include "renderserver.h"
+#endif
+
+using namespace synfig;
+
+/* === M A C R O S ========================================================= */
+
+#define RENDER_SERVER_CANVAS_CACHE_SIZE 32
+
+/* === P R O C E D U R E S ================================================= */
+
+namespace {
+
+class StreamChannel : public RenderServer::Channel
+{
+public:
+	bool read_line(std::string& line) override
+		{ return (bool)std::getline(std::cin, line); }
+	void write_line(const std::string& line) override
+		{ std::cout << line << std::endl; }
+};
+
+#ifndef _WIN32
+class SocketChannel : public RenderServer::Channel
+{
+	int fd;
+	std::string buffer;
+
+public:
+	explicit SocketChannel(int fd): fd(fd) { }
+
+	bool read_line(std::string& line) override
+	{
+		for(;;) {
+			std::string::size_type pos = buffer.find('\n');
+			if (pos != std::string::npos) {
+				line = buffer.substr(0, pos);
+				buffer.erase(0, pos + 1);
+				return true;
+			}
+			char data[4096];
+			ssize_t size = ::read(fd, data, sizeof(data));
+			if (size < 0 && errno == EINTR)
+				continue;
+			if (size <= 0) {
+				// the last line may have no line break
+				line.swap(buffer);
+				buffer.clear();
+				return !line.empty();
+			}
+			buffer.append(data, size);
+		}
+	}
+
+	void write_line(const std::string& line) override
+	{
+		std::string data = line + "\n";
+		const char *pos = data.c_str();
+		size_t left = data.size();
+		while(left > 0) {
+			ssize_t size = ::write(fd, pos, left);
+			if (size < 0 && errno == EINTR)
+				continue;
+			if (size <= 0)
+				return; // client is gone, the job is finished anyway
+			pos += size;
+			left -= size;
+		}
+	}
+};
+#endif
+
+/// Reports progress of the job to the client
+class ServerProgress : public ProgressCallback
+{
+	RenderServer::Channel& channel;
+	std::string id;
+	int last_current;
+	bool failed;
+
+public:
+	ServerProgress(RenderServer::Channel& channel, const std::string& id):
+		channel(channel), id(id), last_current(-1), failed(false) { }
+
+	bool error(const std::string& task) override
+	{
+		// the error is the final reply of the job, the client stops waiting for it
+		if (!failed)
+			channel.write_line(reply("error") + ",\"message\":\"" + RenderServer::escape(task) + "\"}");
+		failed = true;
+		return true;
+	}
+
+	bool warning(const std::string& task) override
+	{
+		channel.write_line(reply("warning") + ",\"message\":\"" + RenderServer::escape(task) + "\"}");
+		return true;
+	}
+
+	bool amount_complete(int current, int total) override
+	{
+		// targets report every frame or scanline, report each of them only once
+		if (current == last_current)
+			return true;
+		last_current = current;
+		channel.write_line(reply("progress") + strprintf(",\"current\":%d,\"total\":%d}", current, total));
+		return true;
+	}
+
+	//! Returns true if the error of the job is already sent to the client
+	bool has_failed() const
+		{ return failed; }
+
+	std::string reply(const std::string& status) const
+		{ return "{\"id\":\"" + RenderServer::escape(id) + "\",\"status\":\"" + status + "\""; }
+};
+
+/// Restores the render description of the cached canvas after the job
+class RendDescGuard
+{
+	Canvas::Handle canvas;
+	RendDesc desc;
+
+public:
+	explicit RendDescGuard(const Canvas::Handle& canvas):
+		canvas(canvas), desc(canvas->rend_desc()) { }
+	~RendDescGuard()
+		{ canvas->rend_desc() = desc; }
+};
+
+void
+skip_spaces(const std::string& line, size_t& pos)
+{
+	while(pos < line.size() && isspace((unsigned char)line[pos]))
+		++pos;
+}
+
+bool
+parse_string(const std::string& line, size_t& pos, std::string& out)
+{
+	if (pos >= line.size() || line[pos] != '"')
+		return false;
+	out.clear();
+	for(++pos; pos < line.size(); ++pos) {
+		char c = line[pos];
+		if (c == '"') {
+			++pos;
+			return true;
+		}
+		if (c != '\\') {
+			out += c;
+			continue;
+		}
+		if (++pos >= line.size())
+			return false;
+		switch(line[pos]) {
+			case 'n': out += '\n'; break;
+			case 't': out += '\t'; break;
+			case 'r': out += '\r'; break;
+			case 'b': out += '\b'; break;
+			case 'f': out += '\f'; break;
+			case 'u': {
+				if (pos + 4 >= line.size())
+					return false;
+				unsigned int code = strtoul(line.substr(pos + 1, 4).c_str(), nullptr, 16);
+				pos += 4;
+				// encode as UTF-8, file names may be non-latin
+				if (code < 0x80) {
+					out += (char)code;
+				} else if (code < 0x800) {
+					out += (char)(0xC0 | (code >> 6));
+					out += (char)(0x80 | (code & 0x3F));
+				} else {
+					out += (char)(0xE0 | (code >> 12));
+					out += (char)(0x80 | ((code >> 6) & 0x3F));
+					out += (char)(0x80 | (code & 0x3F));
+				}
+				break;
+			}
+			default: out += line[pos]; break;
+		}
+	}
+	return false;
+}
+
+std::string
+get_value(const RenderServer::Request& request, const std::string& key)
+{
+	RenderServer::Request::const_iterator i = request.find(key);
+	return i == request.end() ? std::string() : i->second;
+}
+
+/// Applies overrides of the job, like extract_renddesc() does for the command line
+RendDesc
+apply_renddesc(const RendDesc& renddesc, const RenderServer::Request& request)
+{
+	RendDesc desc = renddesc;
+
+	std::string fps = get_value(request, "fps");
+	if (!fps.empty() && atof(fps.c_str()) > 0)
+		desc.set_frame_rate(atof(fps.c_str()));
+
+	std::string begin_time = get_value(request, "begin-time");
+	if (!begin_time.empty())
+		desc.set_time_start(Time(begin_time, desc.get_frame_rate()));
+	std::string end_time = get_value(request, "end-time");
+	if (!end_time.empty())
+		desc.set_time_end(Time(end_time, desc.get_frame_rate()));
+	std::string time = get_value(request, "time");
+	if (!time.empty())
+		desc.set_time(Time(time, desc.get_frame_rate()));
+
+	int w = atoi(get_value(request, "width").c_str());
+	int h = atoi(get_value(request, "height").c_str());
+	if (w > 0 || h > 0) {
+		// scale properly
+		if (w <= 0)
+			w = desc.get_w() * h / desc.get_h();
+		else if (h <= 0)
+			h = desc.get_h() * w / desc.get_w();
+		desc.set_wh(w, h);
+	}
+
+	return desc;
+}
+
+} // END of anonymous namespace
+
+/* === M E T H O D S ======================================================= */
+
+RenderServer::RenderServer(const TargetParam& target_parameters):
+	target_parameters(target_parameters),
+	access_counter(),
+	quit(false)
+{ }
+
+bool
+RenderServer::parse_request(const std::string& line, Request& request)
+{
+	request.clear();
+	size_t pos = 0;
+	skip_spaces(line, pos);
+	if (pos >= line.size() || line[pos++] != '{')
+		return false;
+
+	skip_spaces(line, pos);
+	if (pos < line.size() && line[pos] == '}')
+		return true;
+
+	for(;;) {
+		std::string key, value;
+		skip_spaces(line, pos);
+		if (!parse_string(line, pos, key))
+			return false;
+		skip_spaces(line, pos);
+		if (pos >= line.size() || line[pos++] != ':')
+			return false;
+		skip_spaces(line, pos);
+		if (pos < line.size() && line[pos] == '"') {
+			if (!parse_string(line, pos, value))
+				return false;
+		} else {
+			// numbers, true, false and null are taken as they are written
+			size_t end = line.find_first_of(",}", pos);
+			if (end == std::string::npos)
+				return false;
+			value = line.substr(pos, end - pos);
+			while(!value.empty() && isspace((unsigned char)value.back()))
+				value.pop_back();
+			if (value.empty() || value[0] == '{' || value[0] == '[')
+				return false;
+			pos = end;
+		}
+		request[key] = value;
+
+		skip_spaces(line, pos);
+		if (pos >= line.size())
+			return false;
+		if (line[pos] == '}')
+			return true;
+		if (line[pos++] != ',')
+			return false;
+	}
+}
+
+std::string
+RenderServer::escape(const std::string& str)
+{
+	std::string out;
+	out.reserve(str.size());
+	for(std::string::const_iterator i = str.begin(); i != str.end(); ++i) {
+		switch(*i) {
+			case '"':  out += "\\\""; break;
+			case '\\': out += "\\\\"; break;
+			case '\n': out += "\\n"; break;
+			case '\r': out += "\\r"; break;
+			case '\t': out += "\\t"; break;
+			default:
+				if ((unsigned char)*i < 0x20)
+					out += strprintf("\\u%04x", (unsigned int)(unsigned char)*i);
+				else
+					out += *i;
+		}
+	}
+	return out;
+}
+
+RenderServer::FileStamp
+RenderServer::get_file_stamp(const std::string& filename)
+{
+	FileStamp stamp;
+	GStatBuf buf;
+	if (g_stat(filename.c_str(), &buf) != 0)
+		return stamp;
+
+	stamp.size = (long long)buf.st_size;
+	stamp.mtime = (long long)buf.st_mtime;
+	// files may be rewritten several times per second
+#if defined(__APPLE__)
+	stamp.mtime_nsec = (long long)buf.st_mtimespec.tv_nsec;
+#elif !defined(_WIN32)
+	stamp.mtime_nsec = (long long)buf.st_mtim.tv_nsec;
+#endif
+	return stamp;
+}
+
+void
+RenderServer::collect_files(const Canvas::Handle& canvas, std::set<Canvas::Handle>& visited, FileStamps& files)
+{
+	if (!canvas || !visited.insert(canvas).second)
+		return;
+
+	const std::string canvas_filename = canvas->get_file_name();
+	if (!canvas_filename.empty() && !files.count(canvas_filename))
+		files[canvas_filename] = get_file_stamp(canvas_filename);
+
+	for(Canvas::const_iterator i = canvas->begin(); i != canvas->end(); ++i) {
+		ValueBase filename_value((*i)->get_param("filename"));
+		if (filename_value.get_type() == type_string && !filename_value.get(String()).empty()) {
+			const std::string filename = CanvasFileNaming::make_full_filename(canvas_filename, filename_value.get(String()));
+			files[filename] = get_file_stamp(filename);
+		}
+
+		// inline canvases and canvases of external documents
+		ValueBase canvas_value((*i)->get_param("canvas"));
+		if (canvas_value.get_type() == type_canvas)
+			collect_files(Canvas::Handle(canvas_value.get(Canvas::Handle())), visited, files);
+	}
+}
+
+Canvas::Handle
+RenderServer::open_canvas(const filesystem::Path& filename, bool reload, std::string& errors)
+{
+	const std::string absolute_filename = filesystem::absolute(filename).u8string();
+
+	std::map<std::string, CachedCanvas>::iterator i = canvases.find(absolute_filename);
+	if (i != canvases.end()) {
+		bool changed = reload;
+		for(FileStamps::iterator j = i->second.files.begin(); j != i->second.files.end(); ++j) {
+			if (reload || j->second != get_file_stamp(j->first)) {
+				// images are cached by the modification time in seconds
+				ImageCache::instance().forget(j->first);
+				changed = true;
+			}
+		}
+		if (!changed) {
+			VERBOSE_OUT(2) << _("Using loaded document ") << absolute_filename << std::endl;
+			i->second.access = ++access_counter;
+			return i->second.root;
+		}
+		canvases.erase(i);
+	}
+
+	// stamp the document before loading, so changes made while it is loading are not missed
+	const FileStamp stamp = get_file_stamp(absolute_filename);
+
+	Canvas::Handle root;
+	std::string warnings;
+	try
+	{
+		if (FileSystem::Handle file_system = CanvasFileNaming::make_filesystem(filename.u8string()))
+		{
+			FileSystem::Identifier identifier = file_system->get_identifier(CanvasFileNaming::project_file(filename.u8string()));
+			root = open_canvas_as(identifier, absolute_filename, errors, warnings);
+		}
+		else
+		{
+			errors.append("Cannot open container " + filename.u8string() + "\n");
+		}
+	}
+	catch(std::runtime_error& x)
+	{
+		errors.append(x.what());
+		root = nullptr;
+	}
+	if (!root)
+		return root;
+
+	// forget the least recently used documents
+	while(canvases.size() >= RENDER_SERVER_CANVAS_CACHE_SIZE) {
+		std::map<std::string, CachedCanvas>::iterator oldest = canvases.begin();
+		for(std::map<std::string, CachedCanvas>::iterator j = canvases.begin(); j != canvases.end(); ++j)
+			if (j->second.access < oldest->second.access)
+				oldest = j;
+		canvases.erase(oldest);
+	}
+
+	CachedCanvas &cached = canvases[absolute_filename];
+	cached.files.clear();
+	std::set<Canvas::Handle> visited;
+	collect_files(root, visited, cached.files);
+	cached.files[absolute_filename] = stamp;
+	cached.access = ++access_counter;
+	cached.root = root;
+	return root;
+}
+
+void
+RenderServer::process(const Request& request, Channel& channel)
+{
+	const std::string id = get_value(request, "id");
+	ServerProgress progress(channel, id);
+
+	Job job;
+	std::string input_file = get_value(request, "input-file");
+	if (input_file.empty())
+		throw SynfigToolException(SYNFIGTOOL_MISSINGARGUMENT, _("No input file provided."));
+	job.filename = filesystem::Path(input_file);
+
+	std::string errors;
+	const std::string reload = get_value(request, "reload");
+	job.root = open_canvas(job.filename, reload == "true" || reload == "1", errors);
+	if (!job.root)
+		throw SynfigToolException(SYNFIGTOOL_FILENOTFOUND,
+			strprintf(_("Unable to load file '%s'."), job.filename.u8_str()) + (errors.empty() ? "" : " " + errors));
+	job.root->set_time(0);
+	job.canvas = job.root;
+
+	std::string canvas_id = get_value(request, "canvas");
+	if (!canvas_id.empty()) {
+		try
+		{
+			std::string warnings;
+			job.canvas = job.root->find_canvas(canvas_id, warnings);
+		}
+		catch(...)
+		{
+			throw SynfigToolException(SYNFIGTOOL_INVALIDJOB,
+				strprintf(_("Unable to find canvas with ID \"%s\" in %s."), canvas_id.c_str(), job.filename.c_str()));
+		}
+	}
+
+	std::string renderer = get_value(request, "renderer");
+	if (!renderer.empty()) {
+		if (!rendering::Renderer::get_renderers().count(renderer))
+			throw SynfigToolException(SYNFIGTOOL_INVALIDJOB, strprintf(_("Invalid renderer: %s"), renderer.c_str()));
+		job.render_engine = renderer;
+	}
+
+	job.target_name = get_value(request, "target");
+	std::string output_file = get_value(request, "output-file");
+	if (!output_file.empty())
+		job.outfilename = filesystem::Path(output_file);
+
+	int quality = atoi(get_value(request, "quality").c_str());
+	job.quality = quality > 0 ? quality : DEFAULT_QUALITY;
+
+	// the document stays in the cache, so the overrides must not outlive the job
+	RendDescGuard guard(job.canvas);
+	job.desc = job.canvas->rend_desc() = apply_renddesc(job.canvas->rend_desc(), request);
+
+	if (!setup_job(job, target_parameters))
+		throw SynfigToolException(SYNFIGTOOL_INVALIDJOB, _("Unable to set up the job, see the log of the server."));
+
+	channel.write_line(progress.reply("started") + ",\"output\":\"" + escape(job.outfilename.u8string()) + "\"}");
+
+	std::chrono::steady_clock::time_point start_timepoint = std::chrono::steady_clock::now();
+	if (job.sifout) {
+		if (!save_canvas(FileSystemNative::instance()->get_identifier(job.outfilename.u8string()), job.canvas))
+			throw SynfigToolException(SYNFIGTOOL_RENDERFAILURE, _("Render Failure."));
+	} else {
+		if (!job.target->render(&progress) && !progress.has_failed())
+			throw SynfigToolException(SYNFIGTOOL_RENDERFAILURE, _("Render Failure."));
+	}
+	std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start_timepoint;
+
+	// targets may keep the output file open until they are destroyed
+	job.target.reset();
+
+	// the error is already reported instead of the result
+	if (progress.has_failed())
+		return;
+
+	channel.write_line(progress.reply("done") + strprintf(",\"time\":%.3f}", duration.count()));
+}
+
+void
+RenderServer::serve(Channel& channel)
+{
+	std::string line;
+	while(!quit && channel.read_line(line)) {
+		if (line.find_first_not_of(" \t\r") == std::string::npos)
+			continue;
+
+		Request request;
+		if (!parse_request(line, request)) {
+			channel.write_line("{\"status\":\"error\",\"message\":\"" + escape(_("Invalid request")) + "\"}");
+			continue;
+		}
+
+		if (get_value(request, "command") == "quit") {
+			channel.write_line("{\"status\":\"quit\"}");
+			quit = true;
+			break;
+		}
+
+		try
+		{
+			process(request, channel);
+		}
+		catch(SynfigToolException& e)
+		{
+			channel.write_line("{\"id\":\"" + escape(get_value(request, "id")) + "\",\"status\":\"error\",\"message\":\""
+				+ escape(e.get_message()) + "\"}");
+		}
+		catch(std::exception& e)
+		{
+			channel.write_line("{\"id\":\"" + escape(get_value(request, "id")) + "\",\"status\":\"error\",\"message\":\""
+				+ escape(e.what()) + "\"}");
+		}
+	}
+}
+
+int
+RenderServer::run(const std::string& path)
+{
+	if (path == "-") {
+		// replies are written to the standard output, info messages would break them
+		SynfigToolGeneralOptions::instance()->set_should_be_quiet(true);
+		StreamChannel channel;
+		serve(channel);
+		return SYNFIGTOOL_OK;
+	}
+
+#ifdef _WIN32
+	throw SynfigToolException(SYNFIGTOOL_UNKNOWNARGUMENT,
+		_("Unix sockets are not supported on this platform, use \"--serve -\" to read jobs from standard input."));
+#else
+	sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (path.size() >= sizeof(address.sun_path))
+		throw SynfigToolException(SYNFIGTOOL_UNKNOWNARGUMENT, strprintf(_("Socket path is too long: %s"), path.c_str()));
+	strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+	int server = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (server < 0)
+		throw SynfigToolException(SYNFIGTOOL_UNKNOWNERROR, strprintf(_("Unable to create socket: %s"), strerror(errno)));
+
+	// the socket file is left by the previous run
+	unlink(path.c_str());
+	if (bind(server, (sockaddr*)&address, sizeof(address)) < 0 || listen(server, 8) < 0) {
+		std::string message = strprintf(_("Unable to listen on %s: %s"), path.c_str(), strerror(errno));
+		close(server);
+		throw SynfigToolException(SYNFIGTOOL_UNKNOWNERROR, message);
+	}
+
+	VERBOSE_OUT(1) << _("Waiting for jobs on ") << path << std::endl;
+	while(!quit) {
+		int client = accept(server, nullptr, nullptr);
+		if (client < 0) {
+			if (errno == EINTR)
+				continue;
+			synfig::error(_("Unable to accept connection: %s"), strerror(errno));
+			break;
+		}
+		SocketChannel channel(client);
+		serve(channel);
+		close(client);
+	}
+
+	close(server);
+	unlink(path.c_str());
+	return SYNFIGTOOL_OK;
+#endif
+}
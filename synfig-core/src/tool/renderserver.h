@@ -0,0 +1,126 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file tool/renderserver.h
+**	\brief RenderServer class
+**
+**	\legal
+**	Copyright (c) 2022 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+#ifndef __SYNFIG_RENDERSERVER_H
+#define __SYNFIG_RENDERSERVER_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <synfig/canvas.h>
+#include <synfig/targetparam.h>
+#include "job.h"
+
+/// Keeps modules and loaded documents in memory and renders jobs
+/// received one per line as flat JSON objects, for example:
+///   {"id": "shot1", "input-file": "shot1.sifz", "output-file": "shot1.png",
+///    "target": "png", "width": 640, "height": 360, "begin-time": "0", "end-time": "2s"}
+/// Recognized fields are "id", "input-file", "output-file", "target", "canvas",
+/// "renderer", "quality", "width", "height", "fps", "time", "begin-time", "end-time"
+/// and "reload".
+/// The request {"command": "quit"} stops the server.
+///
+/// Replies are JSON lines too, with the "id" of the job and the "status":
+/// "started", "progress" (with "current" and "total"), "warning" (with "message"),
+/// and finally "done" (with "time" in milliseconds) or "error" (with "message").
+/// Info messages are suppressed when the replies go to the standard output.
+///
+/// Documents are cached by file name, so the next job on the same document
+/// skips loading, unless the size or the modification time of the document,
+/// of its external canvases or of imported files has changed.
+/// The job with "reload": true loads the document again anyway.
+class RenderServer
+{
+public:
+	typedef std::map<std::string, std::string> Request;
+
+	/// Reads requests and writes replies
+	class Channel
+	{
+	public:
+		virtual ~Channel() { }
+		virtual bool read_line(std::string& line) = 0;
+		virtual void write_line(const std::string& line) = 0;
+	};
+
+	explicit RenderServer(const synfig::TargetParam& target_parameters);
+
+	/// Serves the Unix socket at \a path, one client at a time,
+	/// or standard input and output if \a path is "-"
+	/// \return exit code
+	int run(const std::string& path);
+
+	/// Parses the flat JSON object, values of any type are returned as strings
+	/// \return whether the line is a valid object
+	static bool parse_request(const std::string& line, Request& request);
+
+	static std::string escape(const std::string& str);
+
+private:
+	struct FileStamp
+	{
+		long long size;
+		long long mtime;
+		long long mtime_nsec;
+
+		FileStamp(): size(), mtime(), mtime_nsec() { }
+		bool operator==(const FileStamp& other) const
+			{ return size == other.size && mtime == other.mtime && mtime_nsec == other.mtime_nsec; }
+		bool operator!=(const FileStamp& other) const
+			{ return !(*this == other); }
+	};
+
+	typedef std::map<std::string, FileStamp> FileStamps;
+
+	struct CachedCanvas
+	{
+		FileStamps files;
+		long long access;
+		synfig::Canvas::Handle root;
+	};
+
+	synfig::TargetParam target_parameters;
+	std::map<std::string, CachedCanvas> canvases;
+	long long access_counter;
+	bool quit;
+
+	/// Returns the size and the modification time of the file, zeros if it does not exist
+	static FileStamp get_file_stamp(const std::string& filename);
+
+	/// Adds stamps of external canvases and imported files used by \a canvas
+	static void collect_files(const synfig::Canvas::Handle& canvas, std::set<synfig::Canvas::Handle>& visited, FileStamps& files);
+
+	/// Returns the cached document, or loads it
+	/// \param reload load the document again, even if its files are not changed
+	synfig::Canvas::Handle open_canvas(const synfig::filesystem::Path& filename, bool reload, std::string& errors);
+
+	/// Serves requests of one client until the end of input or the quit command
+	void serve(Channel& channel);
+
+	/// Renders one job, throws SynfigToolException on errors
+	void process(const Request& request, Channel& channel);
+};
+
+#endif // __SYNFIG_RENDERSERVER_H
@@ -24,12 +24,21 @@
 
 /* === H E A D E R S ======================================================= */
 
+#include <algorithm>
 #include <cstdio>
 
+#include <thread>
+#include <vector>
+
 #include <synfig/angle.h>
 #include <synfig/bezier.h>
 #include <synfig/clock.h>
+#include <synfig/node.h>
 #include <synfig/surface_etl.h>
+#include <synfig/threadpool.h>
+#include <synfig/type.h>
+#include <synfig/value.h>
+#include <synfig/layers/layer_skeletondeformation.h>
 
 /* === M A C R O S ========================================================= */
 
@@ -37,8 +46,23 @@ using namespace synfig;
 
 #define HERMITE_TEST_ITERATIONS		(100000)
 
+#define SKELETON_TEST_BONES			(60)
+#define SKELETON_TEST_SUBDIVISIONS	(100)
+#define SKELETON_TEST_FRAMES		(50)
+
+#define NODE_MAP_TEST_NODES			(200000)
+#define NODE_MAP_TEST_ALIVE			(1000)
+
 /* === C L A S S E S ======================================================= */
 
+class BenchmarkNode: public Node
+{
+public:
+	String get_string() const override { return "BenchmarkNode"; }
+protected:
+	void get_times_vfunc(time_set &) const override { }
+};
+
 /* === P R O C E D U R E S ================================================= */
 
 template <class Angle>
@@ -282,6 +306,110 @@ int hermite_angle_test(void)
 }
 
 
+int skeleton_deformation_test()
+{
+	typedef Layer_SkeletonDeformation::BonePair BonePair;
+
+	Layer_SkeletonDeformation::Handle layer(new Layer_SkeletonDeformation());
+	layer->set_param("x_subdivisions", ValueBase(int(SKELETON_TEST_SUBDIVISIONS)));
+	layer->set_param("y_subdivisions", ValueBase(int(SKELETON_TEST_SUBDIVISIONS)));
+
+	synfig::clock timer;
+	float first_frame = 0.0;
+	float t = 0.0;
+
+	for(int frame = 0; frame < SKELETON_TEST_FRAMES; ++frame)
+	{
+		// bones are placed around the center of the grid, pose rotates them a bit each frame
+		std::vector<BonePair> bones;
+		for(int i = 0; i < SKELETON_TEST_BONES; ++i)
+		{
+			Angle angle = Angle::deg(360.0*i/SKELETON_TEST_BONES);
+			Vector origin = Vector(2.0, 0.0).rotate(angle);
+
+			Bone bone;
+			bone.set_length(1.5);
+			bone.set_width(0.3);
+			bone.set_tipwidth(0.2);
+			bone.set_animated_matrix(Matrix().set_rotate(angle) * Matrix().set_translate(origin));
+
+			Bone pose(bone);
+			pose.set_depth(i % 3);
+			pose.set_animated_matrix(
+				Matrix().set_rotate(angle + Angle::deg(frame*0.5*(i % 5)))
+			  * Matrix().set_translate(origin) );
+
+			bones.push_back(BonePair(bone, pose));
+		}
+		ValueBase value;
+		value.set_list_of(bones);
+
+		timer.reset();
+		layer->set_param("bones", value);
+		float frame_time = timer();
+		if (frame == 0) first_frame = frame_time; else t += frame_time;
+	}
+
+	fprintf(stderr, "skeleton_deformation(%dx%d grid, %d bones): first frame=%f milliseconds, next frames=%f milliseconds per frame\n",
+		SKELETON_TEST_SUBDIVISIONS, SKELETON_TEST_SUBDIVISIONS, SKELETON_TEST_BONES,
+		first_frame*1000, t*1000/(SKELETON_TEST_FRAMES - 1));
+
+	return 0;
+}
+
+
+//! Creates and destroys nodes from many threads, like cloning and loading do
+static void node_map_thread(int *errors)
+{
+	std::vector<BenchmarkNode*> nodes;
+	nodes.reserve(NODE_MAP_TEST_ALIVE);
+	for(int i = 0; i < NODE_MAP_TEST_NODES; ++i)
+	{
+		if ((int)nodes.size() == NODE_MAP_TEST_ALIVE)
+		{
+			BenchmarkNode *node = nodes[i % NODE_MAP_TEST_ALIVE];
+			if (find_node(node->get_guid()) != node) ++*errors;
+			delete node;
+			nodes[i % NODE_MAP_TEST_ALIVE] = new BenchmarkNode();
+		}
+		else
+		{
+			nodes.push_back(new BenchmarkNode());
+		}
+
+		BenchmarkNode *node = nodes[i % nodes.size()];
+		if (i % 4 == 0)
+			node->set_guid(GUID());
+		if (find_node(node->get_guid()) != node) ++*errors;
+	}
+	for(std::vector<BenchmarkNode*>::iterator i = nodes.begin(); i != nodes.end(); ++i)
+		delete *i;
+}
+
+int node_map_test()
+{
+	const int thread_count = std::max(2u, std::thread::hardware_concurrency());
+	std::vector<int> errors(thread_count, 0);
+	std::vector<std::thread> threads;
+
+	synfig::clock timer;
+	for(int i = 0; i < thread_count; ++i)
+		threads.push_back(std::thread(node_map_thread, &errors[i]));
+	for(std::vector<std::thread>::iterator i = threads.begin(); i != threads.end(); ++i)
+		i->join();
+	float t = timer();
+
+	int error = 0;
+	for(int i = 0; i < thread_count; ++i)
+		error += errors[i];
+
+	fprintf(stderr, "node_map(%d threads, %d nodes per thread): %f milliseconds, %d errors\n",
+		thread_count, NODE_MAP_TEST_NODES, t*1000, error);
+
+	return error ? 1 : 0;
+}
+
+
 /* === E N T R Y P O I N T ================================================= */
 
 int main()
@@ -292,6 +420,13 @@ int main()
 	error+=hermite_double_test();
 	error+=hermite_int_test();
 	error+=hermite_angle_test();
+	error+=node_map_test();
+
+	Type::subsys_init();
+	ThreadPool::subsys_init();
+	error+=skeleton_deformation_test();
+	ThreadPool::subsys_stop();
+	Type::subsys_stop();
 
 	return error;
 }
@@ -0,0 +1,158 @@
+/* === S Y N F I G ========================================================= */
+/*! \file filecontainerzip.cpp
+**  \brief Test synfig::FileContainerZip reading and writing
+**
+**  \legal
+**  Copyright (c) 2022 Synfig contributors
+**
+**  This file is part of Synfig.
+**
+**  Synfig is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  Synfig is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**  \endlegal
+*/
+/* ========================================================================= */
+
+/* === H E A D E R S ======================================================= */
+
+#include <cstdio>
+
+#include <synfig/filecontainerzip.h>
+
+#include "test_base.h"
+
+using namespace synfig;
+
+/* === P R O C E D U R E S ================================================= */
+
+static const String container_filename = "test_filecontainerzip.sfg";
+
+static String
+make_content(const String &pattern, int count)
+{
+	String content;
+	for(int i = 0; i < count; ++i)
+		content += pattern;
+	return content;
+}
+
+static String
+read_file(FileContainerZip::Handle container, const String &filename)
+{
+	FileSystem::ReadStream::Handle stream = container->get_read_stream(filename);
+	if (!stream) return "<no stream>";
+	String content;
+	char buffer[1000];
+	while(size_t size = stream->read_block(buffer, sizeof(buffer)))
+		content.append(buffer, size);
+	return content;
+}
+
+static void
+write_file(FileContainerZip::Handle container, const String &filename, const String &content)
+{
+	FileSystem::WriteStream::Handle stream = container->get_write_stream(filename);
+	ASSERT(stream)
+	ASSERT(stream->write_whole_block(content.c_str(), content.size()))
+}
+
+void
+test_compressed_files_are_detected_by_extension()
+{
+	ASSERT(FileContainerZip::file_is_compressed("images/frame.png"))
+	ASSERT(FileContainerZip::file_is_compressed("images/FRAME.JPG"))
+	ASSERT(FileContainerZip::file_is_compressed("project.sifz"))
+	ASSERT_FALSE(FileContainerZip::file_is_compressed("project.sif"))
+	ASSERT_FALSE(FileContainerZip::file_is_compressed("sounds/voice.wav"))
+}
+
+void
+test_written_files_are_read_after_reopening()
+{
+	const String text = make_content("<layer type=\"circle\"/>\n", 10000);
+	const String image = make_content("\x89PNG\r\n", 1000);
+
+	{
+		FileContainerZip::Handle container(new FileContainerZip());
+		ASSERT(container->create(container_filename))
+		ASSERT(container->directory_create("images"))
+		write_file(container, "project.sif", text);
+		write_file(container, "images/frame.png", image);
+		// entries written in this session are readable before saving
+		ASSERT_EQUAL(text, read_file(container, "project.sif"))
+		container->close();
+	}
+
+	FileContainerZip::Handle container(new FileContainerZip());
+	ASSERT(container->open(container_filename))
+	ASSERT(container->is_file("project.sif"))
+	ASSERT(container->is_file("images/frame.png"))
+	ASSERT_EQUAL(text, read_file(container, "project.sif"))
+	ASSERT_EQUAL(image, read_file(container, "images/frame.png"))
+	container->close();
+
+	remove(container_filename.c_str());
+}
+
+void
+test_several_files_are_read_at_once()
+{
+	const String first = make_content("first", 50000);
+	const String second = make_content("second", 50000);
+
+	{
+		FileContainerZip::Handle container(new FileContainerZip());
+		ASSERT(container->create(container_filename))
+		write_file(container, "first.txt", first);
+		write_file(container, "second.png", second);
+		container->close();
+	}
+
+	FileContainerZip::Handle container(new FileContainerZip());
+	ASSERT(container->open(container_filename))
+	FileSystem::ReadStream::Handle first_stream = container->get_read_stream("first.txt");
+	FileSystem::ReadStream::Handle second_stream = container->get_read_stream("second.png");
+	ASSERT(first_stream)
+	ASSERT(second_stream)
+
+	String first_content(first.size(), ' '), second_content(second.size(), ' ');
+	ASSERT(first_stream->read_whole_block(&first_content[0], 1000))
+	ASSERT(second_stream->read_whole_block(&second_content[0], second.size()))
+	ASSERT(first_stream->read_whole_block(&first_content[1000], first.size() - 1000))
+	ASSERT_EQUAL(first, first_content)
+	ASSERT_EQUAL(second, second_content)
+
+	// streams outlive the closed container
+	FileSystem::ReadStream::Handle stream = container->get_read_stream("second.png");
+	container->close();
+	String content(second.size(), ' ');
+	ASSERT(stream->read_whole_block(&content[0], content.size()))
+	ASSERT_EQUAL(second, content)
+
+	remove(container_filename.c_str());
+}
+
+/* === E N T R Y P O I N T ================================================= */
+
+int main() {
+
+	TEST_SUITE_BEGIN()
+
+	TEST_FUNCTION(test_compressed_files_are_detected_by_extension)
+	TEST_FUNCTION(test_written_files_are_read_after_reopening)
+	TEST_FUNCTION(test_several_files_are_read_at_once)
+
+	TEST_SUITE_END()
+
+	return tst_exit_status;
+}
@@ -0,0 +1,118 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file importer.cpp
+**	\brief Test the resolution of the view seen by imported layers through Importer::ProxyScope
+**
+**	\legal
+**	Copyright (c) 2022 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+#include <synfig/canvas.h>
+#include <synfig/context.h>
+#include <synfig/importer.h>
+#include <synfig/main.h>
+#include <synfig/matrix.h>
+#include <synfig/transformation.h>
+#include <synfig/layers/layer_invisible.h>
+
+#include "test_base.h"
+
+using namespace synfig;
+
+//! Remembers the view of the proxy scope when its resources are loaded
+class Layer_ProxyProbe : public Layer_Invisible
+{
+public:
+	mutable bool in_scope = false;
+	mutable Matrix transformation;
+
+protected:
+	virtual void load_resources_vfunc(IndependentContext context, Time time)const
+	{
+		in_scope = Importer::ProxyScope::is_active();
+		transformation = Importer::ProxyScope::get_transformation();
+		context.load_resources(time);
+	}
+};
+
+//! Pixels of the view across one unit of the canvas by X axis
+static Real
+get_view_width(const Matrix &matrix)
+{
+	return (matrix.get_transformed(Vector(1.0, 0.0)) - matrix.get_transformed(Vector(0.0, 0.0))).mag();
+}
+
+void test_proxy_level_keeps_enough_pixels() {
+	ASSERT_EQUAL(0, Importer::get_proxy_level(1000, 1000.0));
+	ASSERT_EQUAL(0, Importer::get_proxy_level(1000, 501.0));
+	ASSERT_EQUAL(1, Importer::get_proxy_level(1000, 500.0));
+	ASSERT_EQUAL(2, Importer::get_proxy_level(1000, 250.0));
+	ASSERT_EQUAL(Importer::proxy_level_max, Importer::get_proxy_level(1000, 1.0));
+}
+
+void test_proxy_scope_is_active_only_inside() {
+	ASSERT_FALSE(Importer::ProxyScope::is_active());
+	{
+		Importer::ProxyScope outer(Matrix().set_scale(100.0), 2);
+		ASSERT(Importer::ProxyScope::is_active());
+		ASSERT_APPROX_EQUAL(50.0, get_view_width(Importer::ProxyScope::get_transformation()));
+		{
+			Importer::ProxyScope inner(Matrix().set_scale(10.0));
+			ASSERT_APPROX_EQUAL(10.0, get_view_width(Importer::ProxyScope::get_transformation()));
+		}
+		ASSERT_APPROX_EQUAL(50.0, get_view_width(Importer::ProxyScope::get_transformation()));
+	}
+	ASSERT_FALSE(Importer::ProxyScope::is_active());
+}
+
+void test_proxy_scope_follows_group_transformation() {
+	Canvas::Handle canvas = Canvas::create();
+	Layer::Handle group = Layer::create("group");
+	Canvas::Handle sub_canvas = Canvas::create_inline(canvas);
+	group->set_param("canvas", sub_canvas);
+	group->set_param("transformation", Transformation(Vector(3.0, 1.0), Angle::deg(90.0), Angle::deg(0.0), Vector(0.25, 0.25)));
+	canvas->push_back(group);
+
+	etl::handle<Layer_ProxyProbe> probe = new Layer_ProxyProbe();
+	sub_canvas->push_back(probe);
+
+	// final renders load full resolution
+	canvas->load_resources(0);
+	ASSERT_FALSE(probe->in_scope);
+
+	// the layer inside of the group is scaled down by the group, and rotation does not matter
+	{
+		Importer::ProxyScope proxy_scope(Matrix().set_scale(100.0), 2);
+		canvas->load_resources(0);
+	}
+	ASSERT(probe->in_scope);
+	ASSERT_APPROX_EQUAL(12.5, get_view_width(probe->transformation));
+}
+
+int main() {
+	Main synfig_main(".");
+
+	TEST_SUITE_BEGIN()
+		TEST_FUNCTION(test_proxy_level_keeps_enough_pixels);
+		TEST_FUNCTION(test_proxy_scope_is_active_only_inside);
+		TEST_FUNCTION(test_proxy_scope_follows_group_transformation);
+	TEST_SUITE_END()
+
+	return tst_exit_status;
+}
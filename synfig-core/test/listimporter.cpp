@@ -0,0 +1,196 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file listimporter.cpp
+**	\brief Test the read-ahead of image sequences and its statistics
+**
+**	\legal
+**	Copyright (c) 2022 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+#include <synfig/filesystemnative.h>
+#include <synfig/imagecache.h>
+#include <synfig/listimporter.h>
+#include <synfig/main.h>
+#include <synfig/renddesc.h>
+#include <synfig/surface.h>
+
+#include "test_base.h"
+
+using namespace synfig;
+
+#define FRAME_COUNT 60
+#define FRAME_RATE 24
+
+static const String list_filename = "listimporter_test.lst";
+
+static std::thread::id main_thread_id;
+
+//! Decodes frames as plain 2x2 images, slowly when it is done in background
+class TestFrameImporter : public Importer
+{
+public:
+	TestFrameImporter(const FileSystem::Identifier &identifier): Importer(identifier) { }
+
+	static Importer* create(const FileSystem::Identifier &identifier)
+		{ return new TestFrameImporter(identifier); }
+
+	virtual bool get_frame(Surface &surface, const RendDesc &/*renddesc*/, Time /*time*/, ProgressCallback* /*cb*/ = nullptr)
+	{
+		if (std::this_thread::get_id() != main_thread_id)
+			std::this_thread::sleep_for(std::chrono::milliseconds(300));
+		surface.set_wh(2, 2);
+		surface.fill(Color::red());
+		return true;
+	}
+};
+
+static String
+get_frame_filename(int frame)
+{
+	return strprintf("listimporter_test_%02d.tstframe", frame);
+}
+
+static void
+create_files()
+{
+	std::ofstream list(list_filename);
+	list << "FPS " << FRAME_RATE << std::endl;
+	for (int i = 0; i < FRAME_COUNT; ++i) {
+		list << get_frame_filename(i) << std::endl;
+		std::ofstream frame(get_frame_filename(i));
+	}
+}
+
+static void
+remove_files()
+{
+	remove(list_filename.c_str());
+	for (int i = 0; i < FRAME_COUNT; ++i)
+		remove(get_frame_filename(i).c_str());
+}
+
+static RendDesc
+get_renddesc()
+{
+	RendDesc desc;
+	desc.set_frame_rate(FRAME_RATE);
+	return desc;
+}
+
+static Importer::Handle
+open_list()
+{
+	return Importer::open(FileSystem::Identifier(FileSystemNative::instance(), list_filename));
+}
+
+static void
+request(Importer::Handle importer, int frame)
+{
+	importer->get_frame(get_renddesc(), Time(Real(frame)/FRAME_RATE));
+}
+
+//! Frame is decoded already or is being decoded in background
+static bool
+is_read_ahead(int frame)
+{
+	ImageCache::Key key = ImageCache::make_key(
+		FileSystem::Identifier(FileSystemNative::instance(), get_frame_filename(frame)), Time() );
+	return ImageCache::instance().contains(key) || ImageCache::instance().is_pending(key);
+}
+
+void test_read_ahead_follows_step_of_requests() {
+	ListImporter::set_read_ahead(4);
+	Importer::Handle importer = open_list();
+	ASSERT(importer);
+
+	// every second frame is rendered
+	request(importer, 0);
+	request(importer, 2);
+	request(importer, 4);
+	ASSERT(is_read_ahead(12));
+	ASSERT_FALSE(is_read_ahead(11));
+	ASSERT_FALSE(is_read_ahead(13));
+	ASSERT_FALSE(is_read_ahead(14));
+}
+
+void test_read_ahead_of_interleaved_requests_goes_frame_by_frame() {
+	ListImporter::set_read_ahead(4);
+	Importer::Handle importer = open_list();
+	ASSERT(importer);
+
+	// two layers import the same sequence with the offset of 3 frames
+	for (int frame = 20; frame < 23; ++frame) {
+		request(importer, frame);
+		request(importer, frame + 3);
+	}
+	// the offset between layers is not taken as a step backward
+	ASSERT_FALSE(is_read_ahead(18));
+	ASSERT_FALSE(is_read_ahead(16));
+	for (int frame = 26; frame <= 29; ++frame)
+		ASSERT(is_read_ahead(frame));
+}
+
+void test_statistics_count_misses_stalls_and_ready_frames() {
+	Importer::Handle importer = open_list();
+	ASSERT(importer);
+
+	ListImporter::set_read_ahead(0);
+	ListImporter::reset_statistics();
+	request(importer, 40);
+	request(importer, 40);
+
+	ListImporter::Statistics statistics = ListImporter::get_statistics();
+	ASSERT_EQUAL(2, statistics.frames);
+	ASSERT_EQUAL(1, statistics.misses);
+	ASSERT_EQUAL(1, statistics.ready);
+	ASSERT_EQUAL(0, statistics.stalls);
+
+	// the next frame is still being decoded in background when it is requested
+	ListImporter::set_read_ahead(1);
+	ListImporter::reset_statistics();
+	request(importer, 50);
+	request(importer, 51);
+
+	statistics = ListImporter::get_statistics();
+	ASSERT_EQUAL(2, statistics.frames);
+	ASSERT_EQUAL(1, statistics.misses);
+	ASSERT_EQUAL(1, statistics.stalls);
+	ASSERT_EQUAL(0, statistics.ready);
+}
+
+int main() {
+	Main synfig_main(".");
+	main_thread_id = std::this_thread::get_id();
+	Importer::book()["tstframe"] = Importer::BookEntry(TestFrameImporter::create, false);
+	create_files();
+
+	TEST_SUITE_BEGIN()
+		TEST_FUNCTION(test_read_ahead_follows_step_of_requests);
+		TEST_FUNCTION(test_read_ahead_of_interleaved_requests_goes_frame_by_frame);
+		TEST_FUNCTION(test_statistics_count_misses_stalls_and_ready_frames);
+	TEST_SUITE_END()
+
+	remove_files();
+	return tst_exit_status;
+}
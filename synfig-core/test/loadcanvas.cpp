@@ -0,0 +1,241 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file loadcanvas.cpp
+**	\brief Tests of the canvas loader
+**
+**	\legal
+**	Copyright (c) 2022 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+#include <synfig/canvas.h>
+#include <synfig/filesystemnative.h>
+#include <synfig/layer.h>
+#include <synfig/loadcanvas.h>
+#include <synfig/main.h>
+#include <synfig/savecanvas.h>
+#include <synfig/transformation.h>
+#include <synfig/valuenodes/valuenode_bone.h>
+#include <synfig/valuenodes/valuenode_bonelink.h>
+#include <synfig/valuenodes/valuenode_const.h>
+
+using namespace synfig;
+
+/*
+ * Checks that bones and numbers survive loading in both formats, and that
+ * a document with many top-level elements is loaded by the streaming parser.
+ * Load time of big documents is measured by perf/scripts/test_load_perf.py.
+ */
+
+/// The bone is referenced only by GUID from a layer which follows the <bones> section,
+/// so nothing but the parser keeps it alive while the layer is parsed
+static bool
+test_bones_referenced_by_guid(const String &filename)
+{
+	{
+		Canvas::Handle canvas = Canvas::create();
+		canvas->set_file_name(filename);
+
+		ValueNode_Bone::Handle bone = ValueNode_Bone::create(Bone(), canvas);
+		bone->set_link("name", ValueNode_Const::create(String("guid bone")));
+
+		ValueNode_BoneLink::Handle bone_link = ValueNode_BoneLink::create(Transformation());
+		bone_link->set_link("bone", ValueNode_Const::create(ValueBase(bone)));
+
+		Layer::Handle layer = Layer::create("group");
+		layer->connect_dynamic_param("transformation", ValueNode::Handle(bone_link));
+		canvas->push_back(layer);
+
+		if (!save_canvas(FileSystemNative::instance()->get_identifier(filename), canvas, false)) {
+			fprintf(stderr, "loadcanvas: unable to save %s\n", filename.c_str());
+			return false;
+		}
+	}
+
+	String errors, warnings;
+	Canvas::Handle canvas = open_canvas_as(
+		FileSystemNative::instance()->get_identifier(filename), filename, errors, warnings );
+	remove(filename.c_str());
+	if (!canvas || canvas->empty()) {
+		fprintf(stderr, "loadcanvas: unable to load %s: %s\n", filename.c_str(), errors.c_str());
+		return false;
+	}
+
+	ValueNode_Bone::LooseHandle bone = ValueNode_Bone::find("guid bone", canvas);
+	if (!bone) {
+		fprintf(stderr, "loadcanvas: bone of %s is lost\n", filename.c_str());
+		return false;
+	}
+
+	const Layer::DynamicParamList &params = canvas->front()->dynamic_param_list();
+	Layer::DynamicParamList::const_iterator i = params.find("transformation");
+	ValueNode_BoneLink::Handle bone_link = i == params.end() ? nullptr : ValueNode_BoneLink::Handle::cast_dynamic(i->second);
+	if (!bone_link || (*bone_link->get_link("bone"))(0).get(ValueNode_Bone::Handle()).get() != bone.get()) {
+		fprintf(stderr, "loadcanvas: layer of %s does not reference the bone\n", filename.c_str());
+		return false;
+	}
+	return true;
+}
+
+static Canvas::Handle
+save_and_load(const Canvas::Handle &canvas, const String &filename)
+{
+	const FileSystem::Identifier identifier = FileSystemNative::instance()->get_identifier(filename);
+	canvas->set_file_name(filename);
+	if (!save_canvas(identifier, canvas, false)) {
+		fprintf(stderr, "loadcanvas: unable to save %s\n", filename.c_str());
+		return nullptr;
+	}
+
+	String errors, warnings;
+	Canvas::Handle loaded = open_canvas_as(identifier, filename, errors, warnings);
+	remove(filename.c_str());
+	if (!loaded)
+		fprintf(stderr, "loadcanvas: unable to load %s: %s\n", filename.c_str(), errors.c_str());
+	return loaded;
+}
+
+/// Reals, angles, vectors and colors of a .sifb file are decoded without the text,
+/// they must be loaded exactly as the same values of the .sif file
+static bool
+test_binary_numbers()
+{
+	Canvas::Handle canvas = Canvas::create();
+
+	Layer::Handle group = Layer::create("group");
+	group->set_param("amount", Real(0.3));
+	group->set_param("origin", Vector(0.1, -2.7));
+	group->set_param("transformation", Transformation(Vector(1.5, 1.0/3.0), Angle::deg(33.3), Angle::deg(-7.25), Vector(2.0, 0.125)));
+	canvas->push_back(group);
+
+	Layer::Handle solid_color = Layer::create("solid_color");
+	solid_color->set_param("color", Color(0.25f, 1.f/3.f, 0.7f, 0.9f));
+	canvas->push_back(solid_color);
+
+	Canvas::Handle text = save_and_load(canvas, "loadcanvas_numbers.sif");
+	Canvas::Handle binary = save_and_load(canvas, "loadcanvas_numbers.sifb");
+	if (!text || !binary)
+		return false;
+	if (text->size() != canvas->size() || binary->size() != canvas->size()) {
+		fprintf(stderr, "loadcanvas: layers of the numbers test are lost\n");
+		return false;
+	}
+
+	const char *params[] = { "amount", "origin", "transformation", "z_depth", "color" };
+	for(Canvas::const_iterator i = text->begin(), j = binary->begin(); i != text->end(); ++i, ++j)
+		for(size_t k = 0; k < sizeof(params)/sizeof(*params); ++k) {
+			ValueBase value = (*i)->get_param(params[k]);
+			if (value.is_valid() && value != (*j)->get_param(params[k])) {
+				fprintf(stderr, "loadcanvas: param \"%s\" of layer \"%s\" differs in .sifb\n", params[k], (*i)->get_name().c_str());
+				return false;
+			}
+		}
+	return true;
+}
+
+static void
+write_document(const String &filename, int layers, int waypoints)
+{
+	std::ofstream f(filename.c_str());
+	f << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+	  << "<canvas version=\"1.2\" width=\"480\" height=\"270\" xres=\"2834.645669\" yres=\"2834.645669\""
+	  << " gamma-r=\"1.0\" gamma-g=\"1.0\" gamma-b=\"1.0\" view-box=\"-4 2.25 4 -2.25\" antialias=\"1\""
+	  << " fps=\"24\" begin-time=\"0f\" end-time=\"5s\" bgcolor=\"0.5 0.5 0.5 1\">\n"
+	  << "  <name>Load test</name>\n";
+
+	for(int i = 0; i < layers; ++i) {
+		f << "  <layer type=\"solid_color\" active=\"true\" exclude_from_rendering=\"false\" version=\"0.1\" desc=\"Layer " << i << "\">\n"
+		  << "    <param name=\"z_depth\"><real value=\"0.0000000000\"/></param>\n"
+		  << "    <param name=\"amount\"><real value=\"1.0000000000\"/></param>\n"
+		  << "    <param name=\"blend_method\"><integer value=\"0\"/></param>\n"
+		  << "    <param name=\"color\">\n"
+		  << "      <animated type=\"color\">\n";
+		for(int j = 0; j < waypoints; ++j) {
+			float c = (float)((i + j) % 100)/100.f;
+			f << "        <waypoint time=\"" << 2*j << "f\" before=\"clamped\" after=\"clamped\">"
+			  << "<color><r>" << c << "</r><g>" << 1.f - c << "</g><b>0.5</b><a>1.0</a></color></waypoint>\n";
+		}
+		f << "      </animated>\n"
+		  << "    </param>\n"
+		  << "  </layer>\n";
+	}
+
+	f << "</canvas>\n";
+}
+
+/// The streaming parser expands top-level elements one by one,
+/// none of them may be lost, and the animation inside of them must be kept
+static bool
+test_streamed_document(const String &filename)
+{
+	const int layers = 20;
+	const int waypoints = 4;
+	write_document(filename, layers, waypoints);
+
+	String errors, warnings;
+	Canvas::Handle canvas = open_canvas_as(
+		FileSystemNative::instance()->get_identifier(filename), filename, errors, warnings );
+	remove(filename.c_str());
+	if (!canvas) {
+		fprintf(stderr, "loadcanvas: unable to load %s: %s\n", filename.c_str(), errors.c_str());
+		return false;
+	}
+	if ((int)canvas->size() != layers) {
+		fprintf(stderr, "loadcanvas: expected %d layers in %s, loaded %d\n", layers, filename.c_str(), (int)canvas->size());
+		return false;
+	}
+
+	// the last layer of the file is on top, it has the color of its last waypoint in the end
+	const Layer::DynamicParamList &params = canvas->front()->dynamic_param_list();
+	Layer::DynamicParamList::const_iterator i = params.find("color");
+	if (i == params.end()) {
+		fprintf(stderr, "loadcanvas: animation of %s is lost\n", filename.c_str());
+		return false;
+	}
+	const float c = (float)((layers - 1 + waypoints - 1) % 100)/100.f;
+	const Color color = (*i->second)(Time(5)).get(Color());
+	if (std::fabs(color.get_r() - c) > 1e-4 || std::fabs(color.get_g() - (1.f - c)) > 1e-4) {
+		fprintf(stderr, "loadcanvas: animation of %s is loaded wrong\n", filename.c_str());
+		return false;
+	}
+
+	// the same document, compressed
+	Canvas::Handle compressed = save_and_load(canvas, "loadcanvas_stream.sifz");
+	if (!compressed || compressed->size() != canvas->size()) {
+		fprintf(stderr, "loadcanvas: layers of the compressed document are lost\n");
+		return false;
+	}
+	return true;
+}
+
+int main()
+{
+	synfig::Main synfig_main(".");
+
+	if (!test_bones_referenced_by_guid("loadcanvas_bones.sif")
+	 || !test_bones_referenced_by_guid("loadcanvas_bones.sifb")
+	 || !test_binary_numbers()
+	 || !test_streamed_document("loadcanvas_stream.sif"))
+		return 1;
+
+	return 0;
+}
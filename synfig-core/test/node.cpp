@@ -24,6 +24,7 @@
 /* ========================================================================= */
 
 #include <synfig/node.h>
+#include <functional>
 #include <thread>
 
 #include "test_base.h"
@@ -296,6 +297,183 @@ void marking_node_as_changed_updates_times_cache() {
 	ASSERT_EQUAL(2, node.get_times().size());
 }
 
+void time_point_set_find_range_returns_closed_range() {
+	TimePointSet times;
+	for (int i = 0; i < 10; ++i)
+		times.insert(TimePoint(Time(i)));
+
+	std::pair<TimePointSet::const_iterator, TimePointSet::const_iterator> range = times.find_range(Time(2), Time(5));
+	ASSERT_EQUAL(4, std::distance(range.first, range.second));
+	ASSERT_EQUAL(Time(2), range.first->get_time());
+
+	range = times.find_range(Time(2.5), Time(2.7));
+	ASSERT(range.first == range.second);
+
+	range = times.find_range(Time(-1), Time(20));
+	ASSERT_EQUAL(10, std::distance(range.first, range.second));
+}
+
+void change_batch_postpones_signal_changed() {
+	etl::handle<NodeX> node = new NodeX();
+	int count = 0;
+	node->signal_changed().connect([&count]() { ++count; });
+
+	{
+		Node::ChangeBatch batch;
+		node->changed();
+		node->changed();
+		ASSERT_EQUAL(0, count);
+	}
+
+	ASSERT_EQUAL(1, count);
+}
+
+void change_batch_notifies_parent_once() {
+	etl::handle<NodeX> parent_node = new NodeX();
+	etl::handle<NodeX> child_node1 = new NodeX();
+	etl::handle<NodeX> child_node2 = new NodeX();
+	parent_node->add_child(child_node1.get());
+	parent_node->add_child(child_node2.get());
+
+	int changed_count = 0, child_changed_count = 0;
+	parent_node->signal_changed().connect([&changed_count]() { ++changed_count; });
+	parent_node->signal_child_changed().connect([&child_changed_count](const Node*) { ++child_changed_count; });
+
+	{
+		Node::ChangeBatch batch;
+		for (int i = 0; i < 10; ++i) {
+			child_node1->changed();
+			child_node2->changed();
+		}
+	}
+
+	ASSERT_EQUAL(1, changed_count);
+	ASSERT_EQUAL(2, child_changed_count);
+}
+
+void nested_change_batch_notifies_at_the_outermost_end() {
+	etl::handle<NodeX> node = new NodeX();
+	int count = 0;
+	node->signal_changed().connect([&count]() { ++count; });
+
+	{
+		Node::ChangeBatch batch;
+		{
+			Node::ChangeBatch inner_batch;
+			node->changed();
+		}
+		ASSERT_EQUAL(0, count);
+		ASSERT(Node::ChangeBatch::is_active());
+	}
+
+	ASSERT_EQUAL(1, count);
+	ASSERT_FALSE(Node::ChangeBatch::is_active());
+}
+
+void change_batch_updates_times_cache_immediately() {
+	etl::handle<NodeX> node = new NodeX();
+	node->x_times.insert(TimePoint(Time(3)));
+	ASSERT_EQUAL(1, node->get_times().size());
+
+	Node::ChangeBatch batch;
+	node->x_times.insert(TimePoint(Time(4)));
+	node->changed();
+	ASSERT_EQUAL(2, node->get_times().size());
+}
+
+void change_batch_updates_times_cache_of_ancestors_immediately() {
+	etl::handle<NodeX> grandparent_node = new NodeX();
+	etl::handle<NodeX> parent_node = new NodeX();
+	etl::handle<NodeX> child_node = new NodeX();
+	grandparent_node->add_child(parent_node.get());
+	parent_node->add_child(child_node.get());
+	parent_node->x_times.insert(TimePoint(Time(3)));
+	grandparent_node->x_times.insert(TimePoint(Time(3)));
+	ASSERT_EQUAL(1, parent_node->get_times().size());
+	ASSERT_EQUAL(1, grandparent_node->get_times().size());
+
+	int count = 0;
+	grandparent_node->signal_changed().connect([&count]() { ++count; });
+
+	{
+		Node::ChangeBatch batch;
+		parent_node->x_times.insert(TimePoint(Time(4)));
+		grandparent_node->x_times.insert(TimePoint(Time(4)));
+		child_node->changed();
+		ASSERT_EQUAL(2, parent_node->get_times().size());
+		ASSERT_EQUAL(2, grandparent_node->get_times().size());
+		ASSERT_EQUAL(0, count);
+	}
+
+	ASSERT_EQUAL(1, count);
+}
+
+//! Counts calls of the virtual change handlers, like layers clearing their caches
+struct NodeChangeCounter : public NodeX
+{
+	int on_changed_count = 0;
+	int on_child_changed_count = 0;
+
+protected:
+	void on_changed() override
+		{ ++on_changed_count; NodeX::on_changed(); }
+	void on_child_changed(const Node *x) override
+		{ ++on_child_changed_count; NodeX::on_child_changed(x); }
+};
+
+void change_batch_calls_change_handlers_of_ancestors_immediately() {
+	etl::handle<NodeChangeCounter> parent_node = new NodeChangeCounter();
+	etl::handle<NodeX> child_node = new NodeX();
+	parent_node->add_child(child_node.get());
+
+	Node::ChangeBatch batch;
+	child_node->changed();
+	ASSERT_EQUAL(1, parent_node->on_child_changed_count);
+	ASSERT_EQUAL(1, parent_node->on_changed_count);
+}
+
+void node_released_inside_change_batch_lives_until_flush() {
+	etl::handle<NodeX> parent_node = new NodeX();
+	etl::handle<NodeX> child_node = new NodeX();
+	parent_node->add_child(child_node.get());
+
+	bool deleted = false;
+	child_node->signal_deleted().connect([&deleted]() { deleted = true; });
+	const Node *changed_child = nullptr;
+	parent_node->signal_child_changed().connect([&changed_child](const Node *x) { changed_child = x; });
+
+	const Node *expected_child = child_node.get();
+	{
+		Node::ChangeBatch batch;
+		child_node->changed();
+		parent_node->remove_child(child_node.get());
+		child_node.reset();
+		ASSERT_FALSE(deleted);
+	}
+
+	ASSERT(deleted);
+	ASSERT(changed_child == expected_child);
+}
+
+void node_released_by_other_thread_inside_change_batch_lives_until_flush() {
+	etl::handle<NodeX> node = new NodeX();
+	bool deleted = false;
+	int count = 0;
+	node->signal_deleted().connect([&deleted]() { deleted = true; });
+	node->signal_changed().connect([&count]() { ++count; });
+
+	{
+		Node::ChangeBatch batch;
+		node->changed();
+		std::thread thread([](etl::handle<NodeX> &released) { released.reset(); }, std::ref(node));
+		thread.join();
+		ASSERT_FALSE(deleted);
+	}
+
+	ASSERT_EQUAL(1, count);
+	ASSERT(deleted);
+}
+
 int main() {
 
 	TEST_SUITE_BEGIN()
@@ -331,6 +509,16 @@ int main() {
 
 		TEST_FUNCTION(get_times_is_cached);
 		TEST_FUNCTION(marking_node_as_changed_updates_times_cache);
+		TEST_FUNCTION(time_point_set_find_range_returns_closed_range);
+
+		TEST_FUNCTION(change_batch_postpones_signal_changed);
+		TEST_FUNCTION(change_batch_notifies_parent_once);
+		TEST_FUNCTION(nested_change_batch_notifies_at_the_outermost_end);
+		TEST_FUNCTION(change_batch_updates_times_cache_immediately);
+		TEST_FUNCTION(change_batch_updates_times_cache_of_ancestors_immediately);
+		TEST_FUNCTION(change_batch_calls_change_handlers_of_ancestors_immediately);
+		TEST_FUNCTION(node_released_inside_change_batch_lives_until_flush);
+		TEST_FUNCTION(node_released_by_other_thread_inside_change_batch_lives_until_flush);
 	TEST_SUITE_END()
 
 	return tst_exit_status;
@@ -0,0 +1,148 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file packedsurface.cpp
+**	\brief Test mipmaps of PackedSurface and their accounting in ImageCache
+**
+**	\legal
+**	Copyright (c) 2022 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+#include <cmath>
+#include <vector>
+
+#include <synfig/imagecache.h>
+#include <synfig/matrix.h>
+#include <synfig/surface.h>
+#include <synfig/rendering/software/surfaceswpacked.h>
+#include <synfig/rendering/software/function/packedsurface.h>
+#include <synfig/rendering/software/function/resample.h>
+
+#include "test_base.h"
+
+using namespace synfig;
+using namespace synfig::rendering;
+
+static const int size = 64;
+
+static bool
+is_close(const Color &expected, const Color &color)
+{
+	const Color::value_type precision = 1e-3;
+	return std::fabs(expected.get_r() - color.get_r()) < precision
+	    && std::fabs(expected.get_g() - color.get_g()) < precision
+	    && std::fabs(expected.get_b() - color.get_b()) < precision
+	    && std::fabs(expected.get_a() - color.get_a()) < precision;
+}
+
+//! Black and white checkerboard of 2x2 pixel cells
+static void
+make_checkerboard(software::PackedSurface &surface)
+{
+	std::vector<Color> pixels(size*size);
+	for(int y = 0; y < size; ++y)
+		for(int x = 0; x < size; ++x)
+			pixels[y*size + x] = (x/2 + y/2) % 2 ? Color::white() : Color::black();
+	surface.set_pixels(&pixels.front(), size, size);
+}
+
+void test_mipmap_levels_average_pixels() {
+	software::PackedSurface surface;
+	make_checkerboard(surface);
+	ASSERT_EQUAL(6, surface.get_mipmap_count());
+
+	// cells of the checkerboard are not mixed yet
+	const synfig::Surface &level1 = surface.get_mipmap(1);
+	ASSERT_EQUAL(size/2, level1.get_w());
+	ASSERT_EQUAL(size/2, level1.get_h());
+	ASSERT(is_close(Color::black(), level1[0][0]));
+	ASSERT(is_close(Color::white(), level1[0][1]));
+
+	const synfig::Surface &level2 = surface.get_mipmap(2);
+	ASSERT_EQUAL(size/4, level2.get_w());
+	for(int y = 0; y < level2.get_h(); ++y)
+		for(int x = 0; x < level2.get_w(); ++x)
+			ASSERT(is_close(Color(0.5, 0.5, 0.5, 1.0), level2[y][x]));
+
+	const synfig::Surface &last = surface.get_mipmap(surface.get_mipmap_count());
+	ASSERT_EQUAL(1, last.get_w());
+	ASSERT_EQUAL(1, last.get_h());
+}
+
+void test_downscaled_resample_uses_average_of_pixels() {
+	software::PackedSurface surface;
+	make_checkerboard(surface);
+
+	// 8 times smaller, without mipmaps every destination pixel would hit only a few source pixels
+	const int dest_size = size/8;
+	synfig::Surface dest(dest_size, dest_size);
+	dest.clear();
+	software::Resample::resample(
+		dest, RectInt(0, 0, dest_size, dest_size),
+		surface, RectInt(0, 0, size, size),
+		Matrix().set_scale(1.0/8.0),
+		Color::INTERPOLATION_LINEAR, false, 1.0, Color::BLEND_COMPOSITE );
+
+	for(int y = 1; y < dest_size - 1; ++y)
+		for(int x = 1; x < dest_size - 1; ++x)
+			ASSERT(is_close(Color(0.5, 0.5, 0.5, 1.0), dest[y][x]));
+	ASSERT(surface.get_mipmap_size() > 0);
+}
+
+void test_image_cache_accounts_mipmaps() {
+	ImageCache::subsys_init();
+	ImageCache &cache = ImageCache::instance();
+	cache.clear();
+	cache.set_budget(64*1024*1024);
+
+	std::vector<Color> pixels(size*size, Color::red());
+	SurfaceSWPacked::Handle surface = new SurfaceSWPacked();
+	surface->assign(&pixels.front(), size, size);
+
+	ImageCache::Key key;
+	key.filename = "packedsurface.png";
+	cache.put(key, surface);
+	const size_t memory = cache.get_memory();
+	ASSERT_EQUAL(ImageCache::get_surface_size(*surface), memory);
+
+	// mipmaps are built while rendering, the frame is re-accounted on the next access
+	const synfig::Surface &level1 = surface->get_surface().get_mipmap(1);
+	const size_t mipmap_size = sizeof(Color)*level1.get_w()*level1.get_h();
+	ASSERT_EQUAL(mipmap_size, surface->get_surface().get_mipmap_size());
+	ASSERT(cache.get(key).get() == surface.get());
+	ASSERT_EQUAL(memory + mipmap_size, cache.get_memory());
+
+	// frames grown by mipmaps are evicted, when they do not fit into the budget anymore
+	cache.set_budget(memory);
+	ASSERT_FALSE(cache.contains(key));
+	ASSERT_EQUAL(size_t(0), cache.get_memory());
+
+	cache.clear();
+	ImageCache::subsys_stop();
+}
+
+int main() {
+
+	TEST_SUITE_BEGIN()
+		TEST_FUNCTION(test_mipmap_levels_average_pixels);
+		TEST_FUNCTION(test_downscaled_resample_uses_average_of_pixels);
+		TEST_FUNCTION(test_image_cache_accounts_mipmaps);
+	TEST_SUITE_END()
+
+	return tst_exit_status;
+}
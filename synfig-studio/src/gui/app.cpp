@@ -281,6 +281,7 @@ String studio::App::image_editor_path;
 
 String studio::App::sequence_separator(".");
 int    studio::App::number_of_threads = std::thread::hardware_concurrency();
+int    studio::App::workarea_cache_size = 512;
 String studio::App::navigator_renderer;
 String studio::App::workarea_renderer;
 
@@ -553,6 +554,11 @@ public:
 				value=strprintf("%i",App::number_of_threads);
 				return true;
 			}
+			if(key=="workarea_cache_size")
+			{
+				value=strprintf("%i",App::workarea_cache_size);
+				return true;
+			}
 			if(key=="navigator_renderer")
 			{
 				value=App::navigator_renderer;
@@ -746,6 +752,11 @@ public:
 				App::number_of_threads=atoi(value.c_str());
 				return true;
 			}
+			if(key=="workarea_cache_size")
+			{
+				App::workarea_cache_size=atoi(value.c_str());
+				return true;
+			}
 			if(key=="navigator_renderer")
 			{
 				App::navigator_renderer=value;
@@ -841,6 +852,7 @@ public:
 		ret.push_back("predefined_fps");
 		ret.push_back("sequence_separator");
 		ret.push_back("number_of_threads");
+		ret.push_back("workarea_cache_size");
 		ret.push_back("navigator_renderer");
 		ret.push_back("workarea_renderer");
 		ret.push_back("default_background_layer_type");
@@ -2313,6 +2325,7 @@ App::dialog_open_file_ext(const std::string& title, std::vector<synfig::filesyst
 	filter_supported->add_mime_type("application/x-sif");
 	filter_supported->add_pattern("*.sif");
 	filter_supported->add_pattern("*.sifz");
+	filter_supported->add_pattern("*.sifb");
 	// 0.2 Image files
 	filter_supported->add_mime_type("image/png");
 	filter_supported->add_mime_type("image/jpeg");
@@ -2348,10 +2361,11 @@ App::dialog_open_file_ext(const std::string& title, std::vector<synfig::filesyst
 	// Sub filters
 	// 1 Synfig documents. sfg is not supported to import
 	Glib::RefPtr<Gtk::FileFilter> filter_synfig = Gtk::FileFilter::create();
-	filter_synfig->set_name(_("Synfig files (*.sif, *.sifz)"));
+	filter_synfig->set_name(_("Synfig files (*.sif, *.sifz, *.sifb)"));
 	filter_synfig->add_mime_type("application/x-sif");
 	filter_synfig->add_pattern("*.sif");
 	filter_synfig->add_pattern("*.sifz");
+	filter_synfig->add_pattern("*.sifb");
 
 	// 2.1 Image files
 	Glib::RefPtr<Gtk::FileFilter> filter_image = Gtk::FileFilter::create();
@@ -2676,10 +2690,11 @@ App::dialog_open_file_with_history_button(const std::string& title, filesystem::
 	// File filters
 	// Synfig Documents
 	Glib::RefPtr<Gtk::FileFilter> filter_builtin = Gtk::FileFilter::create();
-	filter_builtin->set_name(_("Synfig files (*.sif, *.sifz, *.sfg)"));
+	filter_builtin->set_name(_("Synfig files (*.sif, *.sifz, *.sifb, *.sfg)"));
 	filter_builtin->add_mime_type("application/x-sif");
 	filter_builtin->add_pattern("*.sif");
 	filter_builtin->add_pattern("*.sifz");
+	filter_builtin->add_pattern("*.sifb");
 	filter_builtin->add_pattern("*.sfg");
 
 	// Any files
@@ -2692,6 +2707,7 @@ App::dialog_open_file_with_history_button(const std::string& title, filesystem::
 	filter_supported->set_name(_("All supported files"));
 	filter_supported->add_pattern("*.sif");
 	filter_supported->add_pattern("*.sifz");
+	filter_supported->add_pattern("*.sifb");
 	filter_supported->add_pattern("*.sfg");
 
 	auto dialog = create_dialog_open_file(title, filename, prev_path, {filter_builtin, filter_any, filter_supported});
@@ -2865,11 +2881,15 @@ App::dialog_save_file(const std::string& title, synfig::filesystem::Path& filena
 	filter_sifz->set_name(_("Compressed Synfig file (*.sifz)"));
 	filter_sifz->add_pattern("*.sifz");
 
+	Glib::RefPtr<Gtk::FileFilter> filter_sifb = Gtk::FileFilter::create();
+	filter_sifb->set_name(_("Binary Synfig file (*.sifb)"));
+	filter_sifb->add_pattern("*.sifb");
+
 	Glib::RefPtr<Gtk::FileFilter> filter_sfg = Gtk::FileFilter::create();
 	filter_sfg->set_name(_("Container format file (*.sfg)"));
 	filter_sfg->add_pattern("*.sfg");
 
-	auto dialog = create_dialog_save_file(title, filename, prev_path, {filter_sifz, filter_sif, filter_sfg});
+	auto dialog = create_dialog_save_file(title, filename, prev_path, {filter_sifz, filter_sif, filter_sifb, filter_sfg});
 
 	Widget_Enum *file_type_enum = nullptr;
 	if (preference == ANIMATION_DIR_PREFERENCE)
@@ -2913,6 +2933,7 @@ App::dialog_save_file(const std::string& title, synfig::filesystem::Path& filena
 	const std::map<std::string, Glib::RefPtr<Gtk::FileFilter>> filter_map = {
 		{".sif", filter_sif},
 		{".sifz", filter_sifz},
+		{".sifb", filter_sifb},
 		{".sfg", filter_sfg}
 	};
 
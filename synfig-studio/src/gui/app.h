@@ -231,6 +231,7 @@ public:
 	static synfig::String navigator_renderer;
 	static synfig::String workarea_renderer;
 	static int number_of_threads;
+	static int workarea_cache_size; //!< memory budget for rendered frames in work area, in megabytes
 	static bool enable_mainwin_menubar;
 	static bool enable_mainwin_toolbar;
 	static synfig::String ui_language;
@@ -60,12 +60,14 @@ using namespace studio;
 
 AutoRecover::AutoRecover()
 {
+	backup_done.connect(sigc::mem_fun(*this, &AutoRecover::on_backup_done));
 	set_timer(true, 15000);
 }
 
 AutoRecover::~AutoRecover()
 {
 	set_timer(false, 0);
+	wait_backup();
 }
 
 void
@@ -94,18 +96,28 @@ AutoRecover::set_timer(bool enabled, int timeout_ms)
 void
 AutoRecover::auto_backup()
 {
-	int total = (int)App::instance_list.size();
-	int count = 0;
+	// previous backup is still being written
+	if (backup_thread.joinable())
+		return;
+
+	// Canvases are encoded here, in the main thread.
+	// Writing of the (possibly huge) documents is done by backup_thread
+	int failed = 0;
 	try
 	{
 		for (const auto& instance : App::instance_list) {
 			try
 			{
-				if (instance->backup())
-					++count;
+				synfigapp::Instance::BackupJob::Handle job;
+				if (!instance->prepare_backup(job))
+					++failed;
+				else
+				if (job)
+					jobs.push_back(Job(instance, job));
 			}
 			catch(...)
 			{
+				++failed;
 				synfig::error("AutoRecover::auto_backup(): UNKNOWN EXCEPTION THROWN.");
 			}
 		}
@@ -114,14 +126,61 @@ AutoRecover::auto_backup()
 	{
 		synfig::error("AutoRecover::auto_backup(): UNKNOWN EXCEPTION THROWN.");
 	}
+	jobs_failed = failed;
 
 	// Also go ahead and save the settings
 	App::save_settings();
 
+	if (jobs.empty()) {
+		on_backup_done();
+		return;
+	}
+
+	std::list<synfigapp::Instance::BackupJob::Handle> thread_jobs;
+	for (const auto& job : jobs)
+		thread_jobs.push_back(job.second);
+	backup_thread = std::thread([this, thread_jobs]() {
+		for (const auto& job : thread_jobs)
+			job->write();
+		backup_done.emit();
+	});
+}
+
+void
+AutoRecover::on_backup_done()
+{
+	if (backup_thread.joinable())
+		backup_thread.join();
+
+	int count = 0;
+	for (const auto& job : jobs) {
+		try
+		{
+			if (job.first->finish_backup(*job.second))
+				++count;
+			else
+				++jobs_failed;
+		}
+		catch(...)
+		{
+			++jobs_failed;
+			synfig::error("AutoRecover::on_backup_done(): UNKNOWN EXCEPTION THROWN.");
+		}
+	}
+	jobs.clear();
+
 	//if (count)
 	//	synfig::info("AutoRecover::auto_backup(): %d Files backed up.", count);
-	if (count != total)
-		synfig::error("AutoRecover::auto_backup(): %d FILES NOT BACKED UP.", total - count);
+	if (jobs_failed)
+		synfig::error("AutoRecover::auto_backup(): %d FILES NOT BACKED UP.", jobs_failed);
+	jobs_failed = 0;
+}
+
+void
+AutoRecover::wait_backup()
+{
+	if (backup_thread.joinable())
+		on_backup_done();
 }
 
 bool
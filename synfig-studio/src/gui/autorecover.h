@@ -31,8 +31,14 @@
 
 /* === H E A D E R S ======================================================= */
 
+#include <list>
+#include <thread>
+
+#include <glibmm/dispatcher.h>
 #include <sigc++/sigc++.h>
 
+#include <synfigapp/instance.h>
+
 /* === M A C R O S ========================================================= */
 
 /* === T Y P E D E F S ===================================================== */
@@ -47,7 +53,17 @@ class AutoRecover
 	int timeout_ms = 0;
 	sigc::connection connection;
 
+	typedef std::pair<etl::handle<synfigapp::Instance>, synfigapp::Instance::BackupJob::Handle> Job;
+
+	//! Jobs being written by backup_thread
+	std::list<Job> jobs;
+	int jobs_failed = 0;
+	std::thread backup_thread;
+	Glib::Dispatcher backup_done;
+
 	void set_timer(bool enabled, int timeout_ms);
+	void on_backup_done();
+
 public:
 	AutoRecover();
 	~AutoRecover();
@@ -62,7 +78,10 @@ public:
 	void set_timeout_ms(int value)
 		{ set_timer(get_enabled(), value); }
 
+	//! Snapshots changed instances and writes them in background
 	void auto_backup();
+	//! Waits for background backup to finish
+	void wait_backup();
 
 	bool recovery_needed()const;
 	bool recover(int& number_recovered);
@@ -73,6 +73,7 @@
 #include <gui/widgets/widget_canvastimeslider.h>
 #include <gui/widgets/widget_interpolation.h>
 #include <gui/workarea.h>
+#include <gui/workarearenderer/renderer_canvas.h>
 
 #include <pangomm.h>
 #include <sstream>
@@ -1124,6 +1125,8 @@ CanvasView::create_top_toolbar()
 		background_rendering_button->set_label(_("Background rendering"));
 		background_rendering_button->set_tooltip_text(_("Render future and past frames in background when enabled"));
 		background_rendering_button->show();
+		work_area->signal_rendering().connect(
+			sigc::mem_fun(*this, &CanvasView::update_render_cache_status));
 
 		top_toolbar->append(*background_rendering_button);
 	}
@@ -2424,6 +2427,23 @@ CanvasView::toggle_onion_skin_keyframes()
 	toggling_onion_skin_keyframes=false;
 }
 
+void
+CanvasView::update_render_cache_status()
+{
+	if (!work_area || !work_area->get_renderer_canvas() || !background_rendering_button)
+		return;
+
+	Renderer_Canvas::CacheStats stats;
+	work_area->get_renderer_canvas()->get_cache_stats(stats);
+	background_rendering_button->set_tooltip_text(strprintf(
+		_("Render future and past frames in background when enabled\n"
+		  "Cached frames: %d, memory used: %lld of %lld MB, hit rate: %.0f%%"),
+		stats.frames,
+		stats.size/(1024*1024),
+		stats.max_size/(1024*1024),
+		stats.hit_rate()*100.0 ));
+}
+
 void
 CanvasView::toggle_background_rendering()
 {
@@ -470,6 +470,8 @@ private:
 	void toggle_onion_skin();
 	void toggle_onion_skin_keyframes();
 	void toggle_background_rendering();
+	//! show statistics of work area frame cache
+	void update_render_cache_status();
 
 	void toggle_animatebutton();
 	void toggle_timetrackbutton();
@@ -312,7 +312,9 @@ CellRenderer_TimeTrack::render_vfunc(
 		if (cfps) diff = (actual_time - actual_dragtime).round(cfps);
 
 		std::vector<TimePoint> drawredafter;
-		for(Node::time_set::const_iterator i = tset->begin(); i != tset->end(); ++i) {
+		const std::pair<Node::time_set::const_iterator, Node::time_set::const_iterator> range =
+			WaypointRenderer::get_visible_range(*tset, time_plot_data, time_offset, time_dilation);
+		for(Node::time_set::const_iterator i = range.first; i != range.second; ++i) {
 			// find the coordinate in the drawable space...
 			Time t = (i->get_time() - time_offset)*time_k;
 			if (time_plot_data.is_time_visible_extra(t)) {
@@ -94,6 +94,7 @@ Dialog_Setup::Dialog_Setup(Gtk::Window& parent):
 	adj_pref_y_size(Gtk::Adjustment::create(270,1,10000,1,10,0)),
 	adj_pref_fps(Gtk::Adjustment::create(24.0,1.0,100,0.1,1,0)),
 	adj_number_of_threads(Gtk::Adjustment::create(App::number_of_threads,2,std::thread::hardware_concurrency(),1,10,0)),
+	adj_workarea_cache_size(Gtk::Adjustment::create(App::workarea_cache_size,64,65536,64,512,0)),
 	pref_modification_flag(false),
 	refreshing(false)
 {
@@ -716,6 +717,12 @@ Dialog_Setup::create_render_page(PageInfo pi)
 	// Render - WorkArea
 	attach_label(pi.grid, _("WorkArea renderer"), ++row);
 	pi.grid->attach(workarea_renderer_combo, 1, row, 1, 1);
+	// Render - WorkArea cache size
+	attach_label(pi.grid, _("WorkArea cache size (MB)"), ++row);
+	Gtk::SpinButton *workarea_cache_size_select = Gtk::manage(new Gtk::SpinButton(adj_workarea_cache_size,0,0));
+	workarea_cache_size_select->set_tooltip_text(_("Memory used to keep rendered frames for playback and scrubbing"));
+	workarea_cache_size_select->set_hexpand(true);
+	pi.grid->attach(*workarea_cache_size_select, 1, row, 1, 1);
 	// Render - Render Done sound
 	attach_label(pi.grid, _("Chime on render done"), ++row);
 	pi.grid->attach(toggle_play_sound_on_render_done, 1, row, 1, 1);
@@ -929,6 +936,7 @@ Dialog_Setup::on_restore_pressed()
 		adj_pref_fps->set_value(24.0);
 		image_sequence_separator.set_text(".");
 		adj_number_of_threads->set_value(std::thread::hardware_concurrency());
+		adj_workarea_cache_size->set_value(512);
 
 		workarea_renderer_combo.set_active_id("");
 		def_background_none.set_active();
@@ -1083,6 +1091,9 @@ Dialog_Setup::on_apply_pressed()
 	// Set the number of threads
 	App::number_of_threads = int(adj_number_of_threads->get_value());
 
+	// Set the memory budget of workarea
+	App::workarea_cache_size = int(adj_workarea_cache_size->get_value());
+
 	// Set the workarea render and navigator render flag
 	App::navigator_renderer = App::workarea_renderer  = workarea_renderer_combo.get_active_id();
 
@@ -1390,6 +1401,9 @@ Dialog_Setup::refresh()
 	// Refresh the number of threads
 	number_of_threads_select->set_value(App::number_of_threads);
 
+	// Refresh the memory budget of workarea
+	adj_workarea_cache_size->set_value(App::workarea_cache_size);
+
 	// Refresh the status of the workarea_renderer
 	workarea_renderer_combo.set_active_id(App::workarea_renderer);
 
@@ -35,6 +35,8 @@
 
 #include "docks/dock_history.h"
 
+#include <gtkmm/box.h>
+#include <gtkmm/label.h>
 #include <gtkmm/scrolledwindow.h>
 #include <gtkmm/stock.h>
 #include <gtkmm/stylecontext.h>
@@ -145,7 +147,16 @@ Dock_History::Dock_History():
 	if (Gtk::Toolbar* toolbar = dynamic_cast<Gtk::Toolbar*>(App::ui_manager()->get_widget("/toolbar-history"))) {
 		set_toolbar(*toolbar);
 	}
-	add(*create_action_tree());
+
+	memory_label = manage(new Gtk::Label());
+	memory_label->set_halign(Gtk::ALIGN_START);
+	memory_label->set_margin_start(4);
+
+	Gtk::Box *box = manage(new Gtk::Box(Gtk::ORIENTATION_VERTICAL));
+	box->pack_start(*create_action_tree(), true, true);
+	box->pack_end(*memory_label, false, false);
+	box->show_all();
+	add(*box);
 }
 
 Dock_History::~Dock_History()
@@ -308,11 +319,25 @@ Dock_History::update_undo_redo()
 		action_group->get_action("clear-redo")->set_sensitive(instance->get_redo_status());
 		action_group->get_action("clear-undo-and-redo")->set_sensitive(instance->get_undo_status() || instance->get_redo_status());
 	}
+	update_memory_usage();
+}
+
+void
+Dock_History::update_memory_usage()
+{
+	if (!selected_instance) {
+		memory_label->set_text("");
+		return;
+	}
+	memory_label->set_text(strprintf(_("Memory: %s"),
+		Glib::format_size(selected_instance->get_memory_usage()).c_str()));
 }
 
 void
 Dock_History::on_undo_tree_changed()
 {
+	update_memory_usage();
+
 	Gtk::TreeModel::Children children(selected_instance->history_tree_store()->children());
 
 	if (!children.size())
@@ -364,6 +389,7 @@ Dock_History::set_selected_instance_(etl::handle<studio::Instance> instance)
 		action_tree->hide();
 		action_group->set_sensitive(false);
 	}
+	update_memory_usage();
 }
 
 void
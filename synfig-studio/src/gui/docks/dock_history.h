@@ -47,6 +47,7 @@ class Dock_History : public Dock_CanvasSpecific
 {
 	Glib::RefPtr<Gtk::ActionGroup> action_group;
 	Gtk::TreeView *action_tree;
+	Gtk::Label *memory_label;
 
 	etl::loose_handle<studio::Instance>	selected_instance;
 
@@ -75,6 +76,9 @@ public:
 
 	void update_undo_redo();
 
+	//! Shows memory used by the history of the selected instance
+	void update_memory_usage();
+
 	Dock_History();
 	~Dock_History();
 protected:
@@ -663,7 +663,7 @@ studio::Instance::dialog_save_as()
 		{
 			String ext(filename.extension().u8string());
 			// todo: ".sfg" literal and others
-			if (ext != ".sif" && ext != ".sifz" && ext != ".sfg" && !App::dialog_message_2b(
+			if (ext != ".sif" && ext != ".sifz" && ext != ".sifb" && ext != ".sfg" && !App::dialog_message_2b(
 				_("Unknown extension"),
 				_("You have given the file name an extension which I do not recognize. "
 					"Are you sure this is what you want?"),
@@ -74,6 +74,8 @@ HistoryTreeStore::HistoryTreeStore(etl::loose_handle<studio::Instance> instance_
 	instance_->signal_redo_stack_cleared().connect(sigc::mem_fun(*this,&studio::HistoryTreeStore::on_redo_stack_cleared));
 	instance_->signal_new_action().connect(sigc::mem_fun(*this,&studio::HistoryTreeStore::on_new_action));
 	instance_->signal_action_status_changed().connect(sigc::mem_fun(*this,&studio::HistoryTreeStore::on_action_status_changed));
+	instance_->signal_action_merged().connect(sigc::mem_fun(*this,&studio::HistoryTreeStore::on_action_merged));
+	instance_->signal_undo_stack_trimmed().connect(sigc::mem_fun(*this,&studio::HistoryTreeStore::on_undo_stack_trimmed));
 }
 
 HistoryTreeStore::~HistoryTreeStore()
@@ -238,6 +240,31 @@ HistoryTreeStore::on_action_status_changed(etl::handle<synfigapp::Action::Undoab
 	}
 }
 
+void
+HistoryTreeStore::on_action_merged(etl::handle<synfigapp::Action::Undoable> /*action*/)
+{
+	// the row already refers to the merged action
+	signal_undo_tree_changed()();
+}
+
+void
+HistoryTreeStore::on_undo_stack_trimmed(int count)
+{
+	// the oldest actions are the first rows
+	Gtk::TreeModel::Children children_(children());
+	Gtk::TreeModel::Children::iterator iter = children_.begin();
+
+	for(; count > 0 && iter != children_.end() && iter != next_action_iter; --count)
+	{
+		Gtk::TreeModel::Row row = *iter;
+		if(!row[model.is_undo])
+			break;
+		iter = erase(iter);
+	}
+
+	signal_undo_tree_changed()();
+}
+
 bool
 HistoryTreeStore::search_func(const Glib::RefPtr<Gtk::TreeModel>&,int,const Glib::ustring& x,const Gtk::TreeModel::iterator& iter)
 {
@@ -139,6 +139,10 @@ private:
 
 	void on_action_status_changed(etl::handle<synfigapp::Action::Undoable> action);
 
+	void on_action_merged(etl::handle<synfigapp::Action::Undoable> action);
+
+	void on_undo_stack_trimmed(int count);
+
 	/*
  -- ** -- P U B L I C   M E T H O D S -----------------------------------------
 	*/
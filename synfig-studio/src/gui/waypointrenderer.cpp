@@ -466,6 +466,23 @@ WaypointRenderer::get_times_from_valuedesc(const ValueDesc &v)
 	return empty_time_set;
 }
 
+std::pair<Node::time_set::const_iterator, Node::time_set::const_iterator>
+WaypointRenderer::get_visible_range(
+	const Node::time_set &tset,
+	const TimePlotData &time_plot_data,
+	Time time_offset,
+	Time time_dilation )
+{
+	Time begin = time_plot_data.lower_ex, end = time_plot_data.upper_ex;
+	if (time_dilation != Time::zero()) {
+		begin *= time_dilation;
+		end *= time_dilation;
+	}
+	if (end < begin)
+		std::swap(begin, end);
+	return tset.find_range(begin + time_offset - Time::epsilon(), end + time_offset + Time::epsilon());
+}
+
 void
 WaypointRenderer::foreach_visible_waypoint(const synfigapp::ValueDesc &value_desc,
 		const studio::TimePlotData &time_plot_data,
@@ -478,10 +495,13 @@ WaypointRenderer::foreach_visible_waypoint(const synfigapp::ValueDesc &value_des
 		const Time time_dilation = get_time_dilation_from_vdesc(value_desc);
 		const double time_k = time_dilation == Time::zero() ? 1.0 : 1.0/time_dilation;
 
-		for (const auto & timepoint : tset) {
-			Time t = (timepoint.get_time() - time_offset)*time_k;
+		const std::pair<Node::time_set::const_iterator, Node::time_set::const_iterator> range =
+			get_visible_range(tset, time_plot_data, time_offset, time_dilation);
+
+		for (Node::time_set::const_iterator i = range.first; i != range.second; ++i) {
+			Time t = (i->get_time() - time_offset)*time_k;
 			if (time_plot_data.is_time_visible_extra(t)) {
-				if (foreach_callback(timepoint, t, data))
+				if (foreach_callback(*i, t, data))
 					break;
 			}
 		}
@@ -66,6 +66,15 @@ public:
 
 	static const synfig::Node::time_set & get_times_from_valuedesc(const synfigapp::ValueDesc &v);
 
+	//! Returns the time points of \a tset which may be visible in \a time_plot_data.
+	//! The time of a time point in the plot is (time - time_offset)/time_dilation
+	static std::pair<synfig::Node::time_set::const_iterator, synfig::Node::time_set::const_iterator>
+	get_visible_range(
+		const synfig::Node::time_set &tset,
+		const studio::TimePlotData &time_plot_data,
+		synfig::Time time_offset = synfig::Time::zero(),
+		synfig::Time time_dilation = synfig::Time(1.0) );
+
 }; // END of class WaypointRenderer
 
 }; // END of namespace studio
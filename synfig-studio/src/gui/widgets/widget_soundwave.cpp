@@ -41,6 +41,9 @@
 #include <gui/localization.h>
 #include <gui/timeplotdata.h>
 
+#include <cmath>
+#include <memory>
+
 #ifndef WITHOUT_MLT
 #include <Mlt.h>
 #endif
@@ -56,8 +59,81 @@ const int default_n_channels = 2;
 
 Widget_SoundWave::MouseHandler::~MouseHandler() {}
 
+void Widget_SoundWave::Peak::merge(const Peak& other)
+{
+	min = std::min(min, other.min);
+	max = std::max(max, other.max);
+	power = 0.5f * (power + other.power);
+}
+
+void Widget_SoundWave::PeakPyramid::reset(int n_channels)
+{
+	levels.clear();
+	levels.resize(n_channels, std::vector<std::vector<Peak>>(1));
+}
+
+bool Widget_SoundWave::PeakPyramid::empty() const
+{
+	return levels.empty() || levels.front().front().empty();
+}
+
+void Widget_SoundWave::PeakPyramid::build()
+{
+	for (auto& channel_levels : levels) {
+		channel_levels.resize(1);
+		while (channel_levels.back().size() > 1) {
+			const std::vector<Peak>& prev = channel_levels.back();
+			std::vector<Peak> next((prev.size() + 1)/2);
+			for (size_t i = 0; i < prev.size(); ++i) {
+				if (i % 2)
+					next[i/2].merge(prev[i]);
+				else
+					next[i/2] = prev[i];
+			}
+			channel_levels.push_back(std::move(next));
+		}
+	}
+}
+
+bool Widget_SoundWave::PeakPyramid::get_peak(int channel, long first_sample, long last_sample, Peak& out) const
+{
+	if (channel < 0 || channel >= int(levels.size()))
+		return false;
+	const std::vector<std::vector<Peak>>& channel_levels = levels[channel];
+
+	first_sample = std::max(first_sample, 0L);
+	if (last_sample <= first_sample)
+		last_sample = first_sample + 1;
+
+	// pick the coarsest level whose block still fits in the requested range,
+	// so only a couple of blocks need to be merged
+	long block_size = base_block_size;
+	size_t level = 0;
+	while (level + 1 < channel_levels.size() && 2*block_size <= last_sample - first_sample) {
+		block_size *= 2;
+		++level;
+	}
+
+	const std::vector<Peak>& blocks = channel_levels[level];
+	const long first_block = first_sample / block_size;
+	const long last_block = std::min((last_sample + block_size - 1) / block_size, long(blocks.size()));
+	if (first_block >= last_block)
+		return false;
+
+	out = blocks[first_block];
+	for (long i = first_block + 1; i < last_block; ++i) {
+		out.min = std::min(out.min, blocks[i].min);
+		out.max = std::max(out.max, blocks[i].max);
+		out.power += blocks[i].power;
+	}
+	if (last_block - first_block > 1)
+		out.power /= float(last_block - first_block);
+	return true;
+}
+
 Widget_SoundWave::Widget_SoundWave()
     : Widget_TimeGraphBase(),
+	  loader_cancelled(false),
 	  frequency(default_frequency),
 	  n_channels(default_n_channels),
 	  n_samples(0),
@@ -67,6 +143,8 @@ Widget_SoundWave::Widget_SoundWave()
 	add_events(Gdk::BUTTON_PRESS_MASK | Gdk::BUTTON_RELEASE_MASK | Gdk::SCROLL_MASK | Gdk::POINTER_MOTION_MASK | Gdk::KEY_PRESS_MASK | Gdk::KEY_RELEASE_MASK);
 	setup_mouse_handler();
 
+	loader_done.connect(sigc::mem_fun(*this, &Widget_SoundWave::on_loader_done));
+
 	set_default_page_size(255);
 	set_zoom(1.0);
 
@@ -106,8 +184,11 @@ bool Widget_SoundWave::load(const synfig::filesystem::Path& filename)
 
 void Widget_SoundWave::clear()
 {
+	// loader thread locks the mutex when it finishes, so stop it first
+	stop_loading();
+
 	std::lock_guard<std::mutex> lock(mutex);
-	buffer.clear();
+	peaks.levels.clear();
 	this->filename.clear();
 	loading_error = false;
 	sound_delay = 0.0;
@@ -179,39 +260,48 @@ bool Widget_SoundWave::on_draw(const Cairo::RefPtr<Cairo::Context>& cr)
 	if (filename.empty())
 		return true;
 
-	if (buffer.empty())
-		return true;
-
 	if (!frequency || !n_channels)
 		return true;
 
-	cr->save();
-
 	std::lock_guard<std::mutex> lock(mutex);
 
-	const int bytes_per_sample = 1;
+	if (peaks.empty())
+		return true;
+
+	cr->save();
 
 	Gdk::RGBA color = get_style_context()->get_color();
-	cr->set_source_rgb(color.get_red(), color.get_green(), color.get_blue());
 
-	const int middle_y = 127;
-	cr->move_to(0, middle_y);
+	const int middle_value = 128;
 
-	const int stride = frequency * bytes_per_sample * n_channels;
+	// min-max envelope and RMS band, one column per pixel
+	std::vector<std::pair<double, double>> rms_band;
+	rms_band.reserve(get_width());
 
-	for (double x = 0; x < get_width(); x+=.1) {
-		synfig::Time t = time_plot_data->get_t_from_pixel_coord(x);
-		int value = middle_y;
-		if (t >= sound_delay) {
-			synfig::Time dt = t - sound_delay;
-			unsigned long index = int(dt * stride) + channel_idx;
-			if (index < buffer.size())
-				std::copy(buffer.begin() + index, buffer.begin() + index + bytes_per_sample, &value);
+	long first_sample = std::lround(double(time_plot_data->get_t_from_pixel_coord(0) - sound_delay) * frequency);
+	for (int x = 0; x < get_width(); ++x) {
+		const long last_sample = std::lround(double(time_plot_data->get_t_from_pixel_coord(x + 1) - sound_delay) * frequency);
+		Peak peak;
+		if (last_sample > 0 && peaks.get_peak(channel_idx, first_sample, last_sample, peak)) {
+			const int y_max = time_plot_data->get_pixel_y_coord(peak.max);
+			const int y_min = time_plot_data->get_pixel_y_coord(peak.min);
+			cr->move_to(x + 0.5, y_max);
+			cr->line_to(x + 0.5, std::max(y_min, y_max + 1));
+
+			const double rms = std::sqrt(peak.power);
+			rms_band.emplace_back(x + 0.5, rms);
 		}
-		int y = time_plot_data->get_pixel_y_coord(value);
-		cr->line_to(x, y);
+		first_sample = last_sample;
 	}
-	cr->set_line_width(0.3);
+	cr->set_source_rgba(color.get_red(), color.get_green(), color.get_blue(), 0.6);
+	cr->set_line_width(1.0);
+	cr->stroke();
+
+	for (const auto& item : rms_band) {
+		cr->move_to(item.first, time_plot_data->get_pixel_y_coord(middle_value + item.second));
+		cr->line_to(item.first, time_plot_data->get_pixel_y_coord(middle_value - item.second));
+	}
+	cr->set_source_rgb(color.get_red(), color.get_green(), color.get_blue());
 	cr->stroke();
 
 	draw_current_time(cr);
@@ -246,10 +336,7 @@ void Widget_SoundWave::on_time_model_changed()
 	previous_lower_time = time_plot_data->time_model->get_lower();
 	previous_upper_time = time_plot_data->time_model->get_upper();
 
-	std::lock_guard<std::mutex> lock(mutex);
-	buffer.clear();
-	n_samples = 0;
-	do_load(filename);
+	// peak pyramid doesn't depend on time bounds: just redraw
 	queue_draw();
 }
 
@@ -272,78 +359,140 @@ void Widget_SoundWave::setup_mouse_handler()
 	mouse_handler.signal_panning_requested().connect(sigc::mem_fun(*this, &Widget_SoundWave::pan));
 }
 
+void Widget_SoundWave::stop_loading()
+{
+	if (!loader_thread.joinable())
+		return;
+	loader_cancelled = true;
+	loader_thread.join();
+	loader_cancelled = false;
+}
+
+void Widget_SoundWave::on_loader_done()
+{
+	signal_specs_changed().emit();
+	queue_draw();
+}
+
 bool Widget_SoundWave::do_load(const synfig::filesystem::Path& filename)
 {
-#ifndef WITHOUT_MLT	
+#ifndef WITHOUT_MLT
 	std::string real_filename = Glib::filename_from_utf8(filename.u8string());
-	Mlt::Profile profile;
-	Mlt::Producer *track = new Mlt::Producer(profile, (std::string("avformat:") + real_filename).c_str());
+	// producer is handed over to the loader thread and must not outlive its profile
+	std::shared_ptr<Mlt::Profile> profile = std::make_shared<Mlt::Profile>();
+	auto create_producer = [profile](const std::string& name) {
+		return std::shared_ptr<Mlt::Producer>(
+			new Mlt::Producer(*profile, name.c_str()),
+			[profile](Mlt::Producer* producer) { delete producer; } );
+	};
+	std::shared_ptr<Mlt::Producer> track = create_producer(std::string("avformat:") + real_filename);
 	if (!track->get_producer() || track->get_length() <= 0) {
-		delete track;
-		track = new Mlt::Producer(profile, (std::string("vorbis:") + real_filename).c_str());
-		if (!track->get_producer() || track->get_length() <= 0) {
-			delete track;
+		track = create_producer(std::string("vorbis:") + real_filename);
+		if (!track->get_producer() || track->get_length() <= 0)
 			return false;
-		}
 	}
 
 	const int length = track->get_length();
-	double fps = track->get_fps();
 	int start_frame = 0;
 	int end_frame = length;
 	start_frame = synfig::clamp(start_frame, 0, length);
 	end_frame = synfig::clamp(end_frame, 0, length);
+
+	// sound format is read now, so channel list is available right after load()
+	{
+		std::unique_ptr<Mlt::Frame> frame(track->get_frame(0));
+		if (!frame)
+			return false;
+		frequency = std::stoi(frame->get("audio_frequency"));
+		n_channels = std::stoi(frame->get("audio_channels"));
+		if (!frequency)
+			frequency = default_frequency;
+		if (!n_channels)
+			n_channels = default_n_channels;
+	}
+
 	track->seek(start_frame);
 	// check if audio is seekable
 	if (track->position() != start_frame) {
 		// Not seekable!
 		synfig::error("Audio file not seekable, but a delay (%s) was set: %s", sound_delay.get_string(time_plot_data->time_model->get_frame_rate()).c_str(), filename.c_str());
 	}
-	unsigned char *outbuffer = nullptr;
-	int bytes_written = 0;
 
-	frequency = 0;
-	n_channels = 0;
+	if (channel_idx >= n_channels)
+		channel_idx = 0;
 
-	for (int i = start_frame; i < end_frame; ++i) {
-		Mlt::Frame *frame = track->get_frame(0);
-		if (!frame)
-			break;
+	// Decode the track and build the peak pyramid in background.
+	// Samples are summarized as they arrive, the decoded track is never kept whole.
+	const int _frequency = frequency;
+	const int _channels = n_channels;
+	loader_thread = std::thread([this, track, start_frame, end_frame, _frequency, _channels]() {
+		PeakPyramid local_peaks;
+		local_peaks.reset(_channels);
+
+		std::vector<Peak> current(_channels);
+		std::vector<double> power_sum(_channels, 0.0);
+		int block_fill = 0;
+		int total_samples = 0;
+
+		for (int i = start_frame; i < end_frame && !loader_cancelled; ++i) {
+			std::unique_ptr<Mlt::Frame> frame(track->get_frame(0));
+			if (!frame)
+				break;
+
+			mlt_audio_format format = mlt_audio_u8;
+			int frame_frequency = _frequency;
+			int frame_channels = _channels;
+			int frame_samples = 0;
+			const unsigned char* samples = static_cast<const unsigned char*>(frame->get_audio(format, frame_frequency, frame_channels, frame_samples));
+			if (samples == nullptr) {
+				synfig::warning("couldn't get sound frame #%i", i);
+				break;
+			}
+			if (frame_channels != _channels) {
+				synfig::warning("sound frame #%i has unexpected channel count", i);
+				break;
+			}
+
+			for (int s = 0; s < frame_samples; ++s) {
+				for (int c = 0; c < _channels; ++c) {
+					const unsigned char value = samples[s*_channels + c];
+					Peak& peak = current[c];
+					peak.min = std::min(peak.min, value);
+					peak.max = std::max(peak.max, value);
+					const double amplitude = int(value) - 128;
+					power_sum[c] += amplitude * amplitude;
+				}
+				if (++block_fill == PeakPyramid::base_block_size) {
+					for (int c = 0; c < _channels; ++c) {
+						current[c].power = float(power_sum[c] / block_fill);
+						local_peaks.levels[c][0].push_back(current[c]);
+						current[c] = Peak();
+						power_sum[c] = 0.0;
+					}
+					block_fill = 0;
+				}
+			}
+			total_samples += frame_samples;
+		}
 
-		if (!frequency)
-			frequency = std::stoi(frame->get("audio_frequency"));
-		if (!n_channels)
-			n_channels = std::stoi(frame->get("audio_channels"));
-
-		mlt_audio_format format = mlt_audio_u8;
-		int bytes_per_sample = 1;
-		int _frequency = frequency? frequency : default_frequency;
-		int _channels = n_channels ? n_channels : default_n_channels;
-		int _n_samples = 0;
-		void * _buffer = frame->get_audio(format, _frequency, _channels, _n_samples);
-		if (_buffer == nullptr) {
-			synfig::warning("couldn't get sound frame #%i", i);
-			delete frame;
-			break;
+		if (loader_cancelled)
+			return;
+
+		if (block_fill) {
+			for (int c = 0; c < _channels; ++c) {
+				current[c].power = float(power_sum[c] / block_fill);
+				local_peaks.levels[c][0].push_back(current[c]);
+			}
 		}
-		if (buffer.empty()) {
-			synfig::warning("sound frame #%i got empty buffer", i);
-			int buffer_length = (end_frame - start_frame + 1) * _channels * bytes_per_sample * std::round(_frequency/fps);
-			buffer.resize(buffer_length);
+		local_peaks.build();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			peaks = std::move(local_peaks);
+			n_samples = total_samples;
 		}
-		int _n_bytes = _n_samples * _channels * bytes_per_sample;
-		std::copy(static_cast<unsigned char*>(_buffer), static_cast<unsigned char*>(_buffer) + _n_bytes, buffer.begin()+bytes_written);
-		bytes_written += _n_bytes;
-		outbuffer += _n_bytes;
-		frequency = _frequency;
-		n_channels = _channels;
-		n_samples += _n_samples;
-		delete frame;
-	}
-	if (channel_idx > n_channels)
-		channel_idx = 0;
-	queue_draw();
-	delete track;
+		loader_done.emit();
+	});
 #endif
 	return true;
 }
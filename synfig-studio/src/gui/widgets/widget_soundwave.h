@@ -26,6 +26,11 @@
 #ifndef SYNFIG_STUDIO_WIDGET_SOUNDWAVE_H
 #define SYNFIG_STUDIO_WIDGET_SOUNDWAVE_H
 
+#include <atomic>
+#include <thread>
+
+#include <glibmm/dispatcher.h>
+
 #include <gui/selectdraghelper.h>
 #include <gui/widgets/widget_timegraphbase.h>
 
@@ -65,11 +70,46 @@ protected:
 	void on_time_model_changed() override;
 
 private:
+	/// Summary of a run of consecutive 8-bit samples of a single channel
+	struct Peak {
+		unsigned char min;
+		unsigned char max;
+		/// mean of the squared amplitude (sample - 128)
+		float power;
+
+		Peak(): min(255), max(0), power(0.f) { }
+
+		void merge(const Peak& other);
+	};
+
+	/// Multi-resolution min/max/RMS summary of a sound track.
+	/// Level 0 stores one Peak per base_block_size samples; every next level
+	/// merges two Peaks of the previous one. Drawing at any zoom level reads
+	/// only a few Peaks per pixel column.
+	struct PeakPyramid {
+		static const int base_block_size = 32;
+
+		/// levels[channel][level][block]
+		std::vector<std::vector<std::vector<Peak>>> levels;
+
+		void reset(int n_channels);
+		bool empty() const;
+		/// Builds the coarser levels from level 0
+		void build();
+		/// Summary of samples in range [first_sample, last_sample) of channel
+		bool get_peak(int channel, long first_sample, long last_sample, Peak& out) const;
+	};
+
 	std::mutex mutex;
 	synfig::filesystem::Path filename;
 
-	// sound data
-	std::vector<unsigned char> buffer;
+	// sound data, guarded by mutex
+	PeakPyramid peaks;
+
+	// background decoding
+	std::thread loader_thread;
+	std::atomic<bool> loader_cancelled;
+	Glib::Dispatcher loader_done;
 
 	// sound format
 	int frequency;
@@ -92,6 +132,8 @@ private:
 	void setup_mouse_handler();
 
 	bool do_load(const synfig::filesystem::Path& filename);
+	void stop_loading();
+	void on_loader_done();
 
 	// I'm too lazy to code/copy again mouse actions for panning/zooming/scrolling
 	struct MouseHandler : SelectDragHelper<int>
@@ -315,28 +315,17 @@ void Widget_Timetrack::goto_next_waypoint(long n)
 	if (time_set.size() == 1)
 		return;
 
-	std::vector<synfig::TimePoint> time_vector;
-	time_vector.insert(time_vector.end(), time_set.begin(), time_set.end());
-	std::sort(time_vector.begin(), time_vector.end());
-
-	auto item = std::find(time_vector.begin(), time_vector.end(), wi.time_point);
-
-	if (n > 0) {
-		long max = std::distance(item, time_vector.end()-1);
-		if (n > max)
-			n = max;
-		if (n <= 0)
-			return;
-	} else {
-		long min = std::distance(item, time_vector.begin());
-		if (n < min)
-			n = min;
-		if (n == 0)
-			return;
-	}
+	// time points are already sorted by time
+	synfig::Node::time_set::const_iterator item = time_set.find(wi.time_point);
+	if (item == time_set.end())
+		return;
 
-	item += n;
-	if (item == time_vector.end())
+	const synfig::Node::time_set::const_iterator current = item;
+	for (; n > 0 && std::next(item) != time_set.end(); --n)
+		++item;
+	for (; n < 0 && item != time_set.begin(); ++n)
+		--item;
+	if (item == current)
 		return;
 
 	waypoint_sd.deselect(wi);
@@ -2152,7 +2152,8 @@ studio::WorkArea::queue_render(bool refresh)
 	// avoiding dead-lock : github#1071
 	Glib::signal_idle().connect_once(sigc::track_obj([=] () {
 		if (refresh) {
-			renderer_canvas->clear_render();
+			// keeps tiles which are not touched by the edit
+			renderer_canvas->invalidate_render();
 			Glib::signal_idle().connect_once(
 						sigc::mem_fun(*renderer_canvas, &Renderer_Canvas::enqueue_render),
 						Glib::PRIORITY_DEFAULT );
@@ -0,0 +1,89 @@
+/* === S Y N F I G ========================================================= */
+/*!	\file layerregion.h
+**	\brief Regions of the work area touched by the layers of the root canvas
+**
+**	\legal
+**	Copyright (c) 2022 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+/* ========================================================================= */
+
+/* === S T A R T =========================================================== */
+
+#ifndef __SYNFIG_STUDIO_LAYERREGION_H
+#define __SYNFIG_STUDIO_LAYERREGION_H
+
+/* === H E A D E R S ======================================================= */
+
+#include <cmath>
+
+#include <synfig/color.h>
+#include <synfig/context.h>
+#include <synfig/layer.h>
+#include <synfig/layers/layer_composite.h>
+#include <synfig/layers/layer_filtergroup.h>
+#include <synfig/layers/layer_pastecanvas.h>
+#include <synfig/rect.h>
+
+/* === M A C R O S ========================================================= */
+
+/* === T Y P E D E F S ===================================================== */
+
+/* === C L A S S E S & S T R U C T S ======================================= */
+
+namespace studio {
+
+inline bool
+is_finite_rect(const synfig::Rect &rect)
+{
+	return std::isfinite(rect.minx) && std::isfinite(rect.miny)
+	    && std::isfinite(rect.maxx) && std::isfinite(rect.maxy);
+}
+
+//! Returns the region where the layer puts its own pixels.
+//! Groups and switches are bounded by the visible layers of their canvas,
+//! Layer::get_bounding_rect() gives the full plane for them.
+inline synfig::Rect
+get_layer_region(const synfig::Layer &layer, const synfig::ContextParams &context_params)
+{
+	if (const synfig::Layer_PasteCanvas *paste_canvas = dynamic_cast<const synfig::Layer_PasteCanvas*>(&layer))
+		return paste_canvas->get_bounding_rect_context_dependent(context_params);
+	return layer.get_bounding_rect();
+}
+
+//! Returns true if the layer changes only the pixels inside of its \a bounds.
+//! Distortions and filters may change any pixel of the context,
+//! filter groups apply their layers to the whole context below.
+inline bool
+is_local_layer(const synfig::Layer &layer, const synfig::Rect &bounds)
+{
+	if (!is_finite_rect(bounds) || !dynamic_cast<const synfig::Layer_NoDeform*>(&layer))
+		return false;
+	if (dynamic_cast<const synfig::Layer_FilterGroup*>(&layer))
+		return false;
+	if (const synfig::Layer_Composite *composite = dynamic_cast<const synfig::Layer_Composite*>(&layer))
+		if (synfig::Color::is_straight(composite->get_blend_method()))
+			return false;
+	return true;
+}
+
+}; // END of namespace studio
+
+/* === E N D =============================================================== */
+
+#endif
@@ -35,12 +35,16 @@
 #	include <config.h>
 #endif
 
+#include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <valarray>
 
 #include <synfig/general.h>
 #include <synfig/context.h>
+#include <synfig/importer.h>
 #include <synfig/threadpool.h>
+#include <synfig/layers/layer_composite.h>
 #include <synfig/rendering/renderer.h>
 #include <synfig/rendering/common/task/tasktransformation.h>
 
@@ -50,6 +54,7 @@
 #include <gui/timemodel.h>
 #include <gui/workarea.h>
 
+#include "layerregion.h"
 #include "renderer_canvas.h"
 
 #endif
@@ -81,6 +86,27 @@ static long long
 image_rect_size(const RectInt &rect)
 	{ return 4ll*rect.get_width()*rect.get_height(); }
 
+static RectInt
+rect_to_pixels(const Rect &rect, const Vector &tl, const Vector &br, int width, int height)
+{
+	// a couple of pixels around for antialiasing
+	const int margin = 2;
+	RectInt frame_rect(0, 0, width, height);
+	if (approximate_equal(tl[0], br[0]) || approximate_equal(tl[1], br[1]))
+		return frame_rect;
+
+	Real kx = width/(br[0] - tl[0]);
+	Real ky = height/(br[1] - tl[1]);
+	Real x0 = (rect.minx - tl[0])*kx, x1 = (rect.maxx - tl[0])*kx;
+	Real y0 = (rect.miny - tl[1])*ky, y1 = (rect.maxy - tl[1])*ky;
+	RectInt pixels(
+		(int)std::floor(std::min(x0, x1)) - margin,
+		(int)std::floor(std::min(y0, y1)) - margin,
+		(int)std::ceil (std::max(x0, x1)) + margin,
+		(int)std::ceil (std::max(y0, y1)) + margin );
+	return pixels &= frame_rect;
+}
+
 /* === M E T H O D S ======================================================= */
 
 Renderer_Canvas::Renderer_Canvas():
@@ -95,7 +121,13 @@ Renderer_Canvas::Renderer_Canvas():
 	max_enqueued_tasks (6),
 	enqueued_tasks(),
 	tiles_size(),
-	pixel_format()
+	time_direction(1),
+	access_id(),
+	cache_hits(),
+	cache_misses(),
+	pixel_format(),
+	max_surface_pool_size(32*1024*1024),
+	surface_pool_size()
 {
 	// check endianness
     union { int i; char c[4]; } checker = {0x01020304};
@@ -142,21 +174,69 @@ Renderer_Canvas::on_post_tile_finished_callback(etl::handle<Renderer_Canvas> obj
 		obj->on_post_tile_finished(tile);
 }
 
+void
+Renderer_Canvas::on_layer_changed(const Layer *layer)
+{
+	std::lock_guard<std::mutex> lock(changed_layers_mutex);
+	changed_layers.insert(layer);
+}
+
+Cairo::RefPtr<Cairo::ImageSurface>
+Renderer_Canvas::acquire_surface(int width, int height)
+{
+	// this method may be called from the other threads
+	{
+		std::lock_guard<std::mutex> lock(surface_pool_mutex);
+		SurfacePool::iterator i = surface_pool.find(std::make_pair(width, height));
+		if (i != surface_pool.end() && !i->second.empty()) {
+			Cairo::RefPtr<Cairo::ImageSurface> cairo_surface = i->second.back();
+			i->second.pop_back();
+			surface_pool_size -= image_rect_size(RectInt(0, 0, width, height));
+			return cairo_surface;
+		}
+	}
+	return Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, width, height);
+}
+
+void
+Renderer_Canvas::release_surface(Cairo::RefPtr<Cairo::ImageSurface> &surface)
+{
+	// this method may be called from the other threads
+	// surface may be still drawn somewhere, so reuse only unreferenced ones,
+	// surfaces of tiles never leave the renderer as Cairo::RefPtr (see get_thumb())
+	if ( surface
+	  && cairo_surface_get_reference_count(surface->cobj()) == 1 )
+	{
+		int width = surface->get_width();
+		int height = surface->get_height();
+		long long size = image_rect_size(RectInt(0, 0, width, height));
+		std::lock_guard<std::mutex> lock(surface_pool_mutex);
+		if (surface_pool_size + size <= max_surface_pool_size) {
+			surface_pool[std::make_pair(width, height)].push_back(surface);
+			surface_pool_size += size;
+		}
+	}
+	surface = Cairo::RefPtr<Cairo::ImageSurface>();
+}
+
 Cairo::RefPtr<Cairo::ImageSurface>
 Renderer_Canvas::convert(
 	const rendering::SurfaceResource::Handle &surface,
-	int width, int height ) const
+	int width, int height )
 {
 	// this method may be called from the other threads
 	assert(width > 0 && height > 0);
 
-	Cairo::RefPtr<Cairo::ImageSurface> cairo_surface =
-		Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, width, height);
+	Cairo::RefPtr<Cairo::ImageSurface> cairo_surface = acquire_surface(width, height);
+	cairo_surface->flush();
 
 	bool success = false;
 
 	rendering::SurfaceResource::LockReadBase surface_lock(surface);
 	if (surface_lock.get_resource() && surface_lock.get_resource()->is_blank()) {
+		// surface from pool may be dirty
+		memset(cairo_surface->get_data(), 0, cairo_surface->get_stride()*height);
+		cairo_surface->mark_dirty();
 		success = true;
 	} else
 	if (surface_lock.convert(rendering::Surface::Token::Handle(), false, true)) {
@@ -172,8 +252,7 @@ Renderer_Canvas::convert(
 					pixels = &pixels_copy.front();
 			}
 			if (pixels) {
-				// do conversion
-				cairo_surface->flush();
+				// do conversion, pixel_format is handled by the fast path of color_to_pixelformat()
 				color_to_pixelformat(
 					cairo_surface->get_data(),
 					pixels,
@@ -183,7 +262,6 @@ Renderer_Canvas::convert(
 					cairo_surface->get_height(),
 					cairo_surface->get_stride() );
 				cairo_surface->mark_dirty();
-				cairo_surface->flush();
 				success = true;
 			} else error("Renderer_Canvas::convert: cannot access surface pixels - that really strange");
 		} else error("Renderer_Canvas::convert: surface with wrong size");
@@ -198,6 +276,11 @@ Renderer_Canvas::convert(
 
 	// paint tile
 	if (debug_tiles || !success) {
+		if (!success) {
+			memset(cairo_surface->get_data(), 0, cairo_surface->get_stride()*height);
+			cairo_surface->mark_dirty();
+		}
+
 		Cairo::RefPtr<Cairo::Context> context = Cairo::Context::create(cairo_surface);
 
 		if (!success) {
@@ -238,8 +321,10 @@ Renderer_Canvas::on_tile_finished(bool success, const Tile::Handle &tile)
 
 	--enqueued_tasks;
 
-	if (!tile->event && !tile->surface && !tile->cairo_surface)
+	if (!tile->event && !tile->surface && !tile->cairo_surface) {
+		release_surface(cairo_surface);
 		return; // tile is already removed
+	}
 
 	tile->event.reset();
 	tile->cairo_surface = cairo_surface;
@@ -299,7 +384,7 @@ Renderer_Canvas::erase_tile(TileList &list, TileList::iterator i, rendering::Tas
 	tiles_size -= image_rect_size((*i)->rect);
 	(*i)->event.reset();
 	(*i)->surface.reset();
-	(*i)->cairo_surface = Cairo::RefPtr<Cairo::ImageSurface>();
+	release_surface((*i)->cairo_surface);
 	return list.erase(i);
 }
 
@@ -308,18 +393,38 @@ Renderer_Canvas::remove_extra_tiles(rendering::Task::List &events)
 {
 	// mutex must be already locked
 
-	typedef std::multimap<Real, TileMap::iterator> WeightMap;
-	WeightMap sorted_frames;
+	if (tiles_size <= max_tiles_size_hard)
+		return;
+
+	// frames at keyframes are removed last
+	std::set<Time> keyframe_times;
+	if (get_work_area() && get_work_area()->get_canvas())
+		for(const Keyframe &keyframe : get_work_area()->get_canvas()->keyframe_list())
+			keyframe_times.insert(keyframe.get_time());
+
+	struct Candidate {
+		bool keyframe;
+		long long access;
+		Real weight;
+		TileMap::iterator frame;
+
+		bool operator< (const Candidate &other) const {
+			if (keyframe != other.keyframe) return other.keyframe;
+			if (access != other.access) return access < other.access;
+			return weight > other.weight;
+		}
+	};
+	std::vector<Candidate> candidates;
 
 	Real current_zoom = sqrt((Real)(current_frame.width * current_frame.height));
 
-	// calc weight
+	// calc weight, visible frames are never removed
 	for(TileMap::iterator i = tiles.begin(); i != tiles.end(); ++i) {
-		if (!visible_frames.count(i->first) && tiles_size > max_tiles_size_hard) {
+		if (!visible_frames.count(i->first)) {
 			Real weight = 0.0;
 			if (frame_duration) {
 				Time dt = i->first.time - current_frame.time;
-				Real df = ((double)dt)/(double)frame_duration;
+				Real df = ((double)dt)/(double)frame_duration*time_direction;
 				weight += df*(df > 0.0 ? weight_future : weight_past);
 			}
 			if (current_zoom) {
@@ -327,18 +432,28 @@ Renderer_Canvas::remove_extra_tiles(rendering::Task::List &events)
 				Real zoom_step = log(zoom/current_zoom);
 				weight += zoom_step*(zoom_step > 0.0 ? weight_zoom_in : weight_zoom_out);
 			}
-			sorted_frames.insert( WeightMap::value_type(weight, i) );
+			std::map<FrameId, long long>::const_iterator access = frame_access.find(i->first);
+			Candidate candidate;
+			candidate.keyframe = keyframe_times.count(i->first.time) > 0;
+			candidate.access = access == frame_access.end() ? 0 : access->second;
+			candidate.weight = weight;
+			candidate.frame = i;
+			candidates.push_back(candidate);
 		}
 	}
+	std::sort(candidates.begin(), candidates.end());
 
 	// remove some extra tiles to free the memory
-	for(WeightMap::reverse_iterator ri = sorted_frames.rbegin(); ri != sorted_frames.rend() && tiles_size > max_tiles_size_hard; ++ri)
-		while(!ri->second->second.empty() && tiles_size > max_tiles_size_hard)
-			erase_tile(ri->second->second, ri->second->second.begin(), events);
+	for(std::vector<Candidate>::const_iterator i = candidates.begin(); i != candidates.end() && tiles_size > max_tiles_size_hard; ++i)
+		while(!i->frame->second.empty() && tiles_size > max_tiles_size_hard)
+			erase_tile(i->frame->second, i->frame->second.begin(), events);
 
 	// remove empty entries from tiles map
 	for(TileMap::iterator i = tiles.begin(); i != tiles.end(); )
-		if (i->second.empty()) tiles.erase(i++); else ++i;
+		if (i->second.empty()) {
+			frame_access.erase(i->first);
+			tiles.erase(i++);
+		} else ++i;
 }
 
 void
@@ -508,6 +623,10 @@ Renderer_Canvas::enqueue_render_frame(
 
 	std::string loading_error_msg;
 	try {
+		// imported footage may be served by proxies when the view does not need full detail
+		// low resolution renderers draw pixels of low_res_pixel_size
+		int pixel_size = get_work_area()->get_low_resolution_flag() ? get_work_area()->get_low_res_pixel_size() : 1;
+		Importer::ProxyScope proxy_scope(rend_desc.get_world_to_pixels_matrix() * rend_desc.get_transformation_matrix(), pixel_size);
 		canvas->load_resources(id.time);
 	} catch (std::runtime_error &err) {
 		loading_error_msg = err.what();
@@ -567,6 +686,7 @@ Renderer_Canvas::enqueue_render_frame(
 			sigc::ptr_fun(&on_tile_finished_callback), this, tile ));
 
 		insert_tile(frame_tiles, tile);
+		frame_access[id] = access_id;
 
 		++enqueued_tasks;
 
@@ -598,8 +718,31 @@ Renderer_Canvas::enqueue_render()
 		bool			is_playing = canvas_view->is_playing();
 		bool			is_bounded = time_model->get_play_bounds_enabled();
 
+		max_tiles_size_soft = std::max(64ll, (long long)App::workarea_cache_size)*1024*1024;
+		max_tiles_size_hard = max_tiles_size_soft + max_tiles_size_soft/4;
+
+		FrameId previous_frame = current_frame;
 		build_onion_frames();
 
+		// count cache hits, and remember the direction of scrubbing
+		if (current_frame.time != previous_frame.time) {
+			time_direction = is_playing || previous_frame.time < current_frame.time ? 1 : -1;
+			if (window_rect.is_valid()) {
+				if (calc_frame_status(current_frame, window_rect) == FS_Done)
+					++cache_hits;
+				else
+					++cache_misses;
+			}
+		}
+
+		// mark visible frames as recently used
+		++access_id;
+		for(FrameList::const_iterator i = onion_frames.begin(); i != onion_frames.end(); ++i)
+			if (tiles.count(i->id))
+				frame_access[i->id] = access_id;
+		if (tiles.count(current_thumb))
+			frame_access[current_thumb] = access_id;
+
 		rendering::Renderer::Handle renderer = rendering::Renderer::get_renderer(renderer_name);
 		
 		int max_tasks = max_enqueued_tasks;
@@ -626,6 +769,11 @@ Renderer_Canvas::enqueue_render()
 
 				// generate rendering tasks for future or past frames
 				// render only one frame in background
+				// frames in the direction of playback or scrubbing have higher priority
+				const Real weight_ahead        = time_direction < 0 ? weight_past         : weight_future;
+				const Real weight_behind       = time_direction < 0 ? weight_future       : weight_past;
+				const Real weight_ahead_extra  = time_direction < 0 ? weight_past_extra   : weight_future_extra;
+				const Real weight_behind_extra = time_direction < 0 ? weight_future_extra : weight_past_extra;
 				int future = 0, past = 0;
 				long long frame_size = image_rect_size(window_rect);
 				bool time_in_repeat_range = time_model->get_time() >= time_model->get_play_bounds_lower()
@@ -639,7 +787,7 @@ Renderer_Canvas::enqueue_render()
 					Real weight_future_current = !time_in_repeat_range
 							                  || ( future_time >= time_model->get_play_bounds_lower()
 							                    && future_time <= time_model->get_play_bounds_upper() )
-											   ? weight_future : weight_future_extra;
+											   ? weight_ahead : weight_ahead_extra;
 
 					Time past_time = current_frame.time - frame_duration*past;
 					bool past_exists = false;
@@ -649,7 +797,7 @@ Renderer_Canvas::enqueue_render()
 					Real weight_past_current = !time_in_repeat_range
 							                || ( past_time >= time_model->get_play_bounds_lower()
 							                  && past_time <= time_model->get_play_bounds_upper() )
-											 ? weight_past : weight_past_extra;
+											 ? weight_behind : weight_behind_extra;
 
 					if(!future_exists && !past_exists)
 						break;
@@ -737,6 +885,7 @@ Renderer_Canvas::clear_render()
 				erase_tile(i->second, j, events);
 			}
 		tiles.clear();
+		frame_access.clear();
 		rendering_error_msg_map.clear();
 	}
 	rendering::Renderer::cancel(events);
@@ -744,6 +893,122 @@ Renderer_Canvas::clear_render()
 		get_work_area()->signal_rendering()();
 }
 
+void
+Renderer_Canvas::invalidate_render()
+{
+	assert(get_work_area());
+
+	Canvas::Handle canvas = get_work_area()->get_canvas();
+	if (!canvas) {
+		clear_render();
+		return;
+	}
+
+	std::set<const Layer*> changed;
+	{
+		std::lock_guard<std::mutex> lock(changed_layers_mutex);
+		changed.swap(changed_layers);
+	}
+
+	// collect the current state of layers
+	const Time time = canvas->get_time();
+	const Vector tl = canvas->rend_desc().get_tl();
+	const Vector br = canvas->rend_desc().get_br();
+	const ContextParams context_params(canvas->rend_desc().get_render_excluded_contexts());
+	LayerStateList states;
+	states.reserve(canvas->size());
+	for(Canvas::const_iterator i = canvas->begin(); i != canvas->end(); ++i) {
+		LayerState state;
+		state.layer = *i;
+		state.visible = (*i)->active();
+		state.bounds = get_layer_region(**i, context_params);
+		state.local = is_local_layer(**i, state.bounds);
+		states.push_back(state);
+	}
+
+	// find regions changed since the previous call,
+	// something is changed outside of the layers of the root canvas if there are no changed layers
+	bool full = changed.empty()
+			 || states.size() != layer_states.size()
+			 || time != layer_states_time
+			 || tl != layer_states_tl
+			 || br != layer_states_br;
+	std::vector<Rect> damage;
+	int lowest_changed = -1;
+	for(int i = 0; !full && i < (int)states.size(); ++i) {
+		const LayerState &prev = layer_states[i];
+		const LayerState &next = states[i];
+		if (prev.layer != next.layer)
+			{ full = true; break; }
+		if (!changed.count(next.layer.get()) && prev.visible == next.visible && prev.bounds == next.bounds)
+			continue;
+		if ((prev.visible && !prev.local) || (next.visible && !next.local))
+			{ full = true; break; }
+		if (prev.visible) damage.push_back(prev.bounds);
+		if (next.visible) damage.push_back(next.bounds);
+		lowest_changed = i;
+	}
+
+	// layers above may spread the change beyond its bounds
+	for(int i = 0; !full && i < lowest_changed; ++i)
+		if (states[i].visible && !states[i].local)
+			full = true;
+
+	layer_states.swap(states);
+	layer_states_time = time;
+	layer_states_tl = tl;
+	layer_states_br = br;
+	if (full) {
+		for(std::vector<sigc::connection>::iterator i = layer_connections.begin(); i != layer_connections.end(); ++i)
+			i->disconnect();
+		layer_connections.clear();
+		for(LayerStateList::const_iterator i = layer_states.begin(); i != layer_states.end(); ++i)
+			layer_connections.push_back( i->layer->signal_changed().connect( sigc::bind(
+				sigc::mem_fun(*this, &Renderer_Canvas::on_layer_changed), i->layer.get() )));
+		clear_render();
+		return;
+	}
+
+	// remove tiles of the changed regions of the current frame,
+	// and all tiles of other frames, where the changed layers may have other bounds
+	rendering::Task::List events;
+	bool erased = false;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for(TileMap::iterator i = tiles.begin(); i != tiles.end(); ) {
+			if (i->first.time != time) {
+				while(!i->second.empty()) {
+					TileList::iterator j = i->second.end(); --j;
+					erase_tile(i->second, j, events);
+				}
+				frame_access.erase(i->first);
+				tiles.erase(i++);
+				erased = true;
+				continue;
+			}
+
+			std::vector<RectInt> pixels;
+			for(std::vector<Rect>::const_iterator j = damage.begin(); j != damage.end(); ++j)
+				pixels.push_back(rect_to_pixels(*j, tl, br, i->first.width, i->first.height));
+
+			for(TileList::iterator j = i->second.begin(); j != i->second.end(); ) {
+				bool touched = false;
+				for(std::vector<RectInt>::const_iterator k = pixels.begin(); !touched && k != pixels.end(); ++k)
+					touched = *j && ((*j)->rect && *k);
+				if (touched) {
+					j = erase_tile(i->second, j, events);
+					erased = true;
+				} else ++j;
+			}
+			++i;
+		}
+		rendering_error_msg_map.clear();
+	}
+	rendering::Renderer::cancel(events);
+	if (erased && get_work_area())
+		get_work_area()->signal_rendering()();
+}
+
 Renderer_Canvas::FrameStatus
 Renderer_Canvas::merge_status(FrameStatus a, FrameStatus b) {
 	static const FrameStatus map[FS_Count][FS_Count] = {
@@ -812,6 +1077,18 @@ Renderer_Canvas::get_render_status(StatusMap &out_map)
 	}
 }
 
+void
+Renderer_Canvas::get_cache_stats(CacheStats &out_stats)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	out_stats.hits = cache_hits;
+	out_stats.misses = cache_misses;
+	out_stats.size = tiles_size;
+	out_stats.max_size = max_tiles_size_soft;
+	out_stats.frames = (int)tiles.size();
+}
+
 void Renderer_Canvas::get_rendering_error_messages(std::vector<std::string>& messages)
 {
 	std::lock_guard<std::mutex> lock(mutex);
@@ -1018,7 +1295,18 @@ Renderer_Canvas::get_thumb(const Time &time)
 {
 	std::lock_guard<std::mutex> lock(mutex);
 	TileMap::const_iterator i = tiles.find( current_thumb.with_time(time) );
-	return i == tiles.end() || i->second.empty() || !*(i->second.begin())
-		 ? Cairo::RefPtr<Cairo::ImageSurface>()
-		 : (*(i->second.begin()))->cairo_surface;
+	if (i == tiles.end() || i->second.empty() || !*(i->second.begin()) || !(*(i->second.begin()))->cairo_surface)
+		return Cairo::RefPtr<Cairo::ImageSurface>();
+
+	// surface of the tile goes back to the pool when the tile is erased,
+	// but widgets keep the thumbnail for a while, so they get their own copy
+	const Cairo::RefPtr<Cairo::ImageSurface> &tile_surface = (*(i->second.begin()))->cairo_surface;
+	Cairo::RefPtr<Cairo::ImageSurface> surface = Cairo::ImageSurface::create(
+		Cairo::FORMAT_ARGB32, tile_surface->get_width(), tile_surface->get_height() );
+	Cairo::RefPtr<Cairo::Context> context = Cairo::Context::create(surface);
+	context->set_operator(Cairo::OPERATOR_SOURCE);
+	context->set_source(tile_surface, 0.0, 0.0);
+	context->paint();
+	surface->flush();
+	return surface;
 }
@@ -33,6 +33,7 @@
 
 #include <vector>
 #include <map>
+#include <set>
 
 #include <synfig/canvas.h>
 #include <synfig/rendering/task.h>
@@ -129,6 +130,32 @@ public:
 			frame_id(frame_id), rect(rect) { }
 	};
 
+	class CacheStats {
+	public:
+		long long hits;     //!< count of frames which were fully rendered when shown
+		long long misses;   //!< count of frames which were not rendered when shown
+		long long size;     //!< memory used by tiles
+		long long max_size; //!< memory budget for tiles
+		int frames;         //!< count of frames in cache
+
+		CacheStats(): hits(), misses(), size(), max_size(), frames() { }
+
+		synfig::Real hit_rate() const
+			{ return hits + misses ? synfig::Real(hits)/synfig::Real(hits + misses) : 0.0; }
+	};
+
+	//! state of the layer of the root canvas, uses to find the region changed by edit
+	class LayerState {
+	public:
+		synfig::Layer::LooseHandle layer;
+		synfig::Rect bounds;
+		bool visible;
+		bool local; //!< layer changes only pixels inside of its bounds and does not deform the context
+
+		LayerState(): visible(), local() { }
+	};
+
+	typedef std::vector<LayerState> LayerStateList;
 	typedef std::map<synfig::Time, FrameStatus> StatusMap;
 	typedef std::set<FrameId> FrameSet;
 	typedef std::vector<FrameDesc> FrameList;
@@ -137,8 +164,8 @@ public:
 
 private:
 	// cache options
-	const long long max_tiles_size_soft; //!< threshold for creation of new tiles
-	const long long max_tiles_size_hard; //!< threshold for removing already created tiles
+	long long max_tiles_size_soft;       //!< threshold for creation of new tiles, see App::workarea_cache_size
+	long long max_tiles_size_hard;       //!< threshold for removing already created tiles
 	const synfig::Real weight_future;    //!< will multiply to frames count
 	const synfig::Real weight_past;
 	const synfig::Real weight_future_extra;
@@ -165,6 +192,17 @@ private:
 	//! increment of this field makes all tiles outdated
 	long long tiles_size;
 
+	//! direction of the last time change: 1 - forward, -1 - backward,
+	//! background rendering prefers frames in this direction
+	int time_direction;
+
+	//! least recently used frames are removed first
+	long long access_id;
+	std::map<FrameId, long long> frame_access;
+
+	long long cache_hits;
+	long long cache_misses;
+
 	synfig::PixelFormat pixel_format;
 
 	//! uses to normalize alpha value after blending of onion surfaces
@@ -172,6 +210,26 @@ private:
 	Cairo::RefPtr<Cairo::ImageSurface> alpha_dst_surface;
 	Cairo::RefPtr<Cairo::Context> alpha_context;
 
+	//! finished tile surfaces, which can be reused for the new tiles of the same size
+	typedef std::map<std::pair<int, int>, std::vector<Cairo::RefPtr<Cairo::ImageSurface>>> SurfacePool;
+	const long long max_surface_pool_size;
+	std::mutex surface_pool_mutex;
+	SurfacePool surface_pool;
+	long long surface_pool_size;
+
+	//! layers of the canvas at the moment of the previous invalidate_render() call,
+	//! tiles of frame at layer_states_time are actual for this state
+	LayerStateList layer_states;
+	synfig::Time layer_states_time;
+	synfig::Vector layer_states_tl;
+	synfig::Vector layer_states_br;
+	std::vector<sigc::connection> layer_connections;
+
+	//! controls access to field changed_layers
+	std::mutex changed_layers_mutex;
+	//! layers of the root canvas changed since the previous invalidate_render() call
+	std::set<const synfig::Layer*> changed_layers;
+
 	synfig::Vector previous_tl;
 	synfig::Vector previous_br;
 	Cairo::RefPtr<Cairo::ImageSurface> previous_surface;
@@ -187,10 +245,21 @@ private:
 	//! this method may be called from the main thread only
 	void on_post_tile_finished(const Tile::Handle &tile);
 
+	//! this method may be called from the other threads
+	void on_layer_changed(const synfig::Layer *layer);
+
+	//! this method may be called from the other threads
+	//! returns surface from pool or the new one, contents of surface is undefined
+	Cairo::RefPtr<Cairo::ImageSurface> acquire_surface(int width, int height);
+
+	//! this method may be called from the other threads
+	//! puts surface back to pool if nobody else uses it
+	void release_surface(Cairo::RefPtr<Cairo::ImageSurface> &surface);
+
 	//! this method may be called from the other threads
 	Cairo::RefPtr<Cairo::ImageSurface> convert(
 		const synfig::rendering::SurfaceResource::Handle &surface,
-		int width, int height ) const;
+		int width, int height );
 
 	//! mutex must be locked before call
 	void insert_tile(TileList &list, const Tile::Handle &tile);
@@ -227,9 +296,15 @@ public:
 	void enqueue_render();
 	void wait_render();
 	void clear_render();
+	//! removes only tiles touched by the layers changed since the previous call:
+	//! changed regions of the current frame are rendered again, other frames are cleared,
+	//! works like clear_render() when the changed region is unknown
+	void invalidate_render();
 
 	void get_render_status(StatusMap &out_map);
 
+	void get_cache_stats(CacheStats &out_stats);
+
 	void get_rendering_error_messages(std::vector<std::string>& messages);
 	void get_rendering_error_messages_for_time(const synfig::Time& time, std::set<std::string>& message_set);
 
@@ -238,6 +313,7 @@ public:
 		const Glib::RefPtr<Gdk::Window>& drawable,
 		const Gdk::Rectangle& expose_area );
 
+	//! returns a copy of the rendered thumbnail of the frame at \a time, if any
 	Cairo::RefPtr<Cairo::ImageSurface> get_thumb(const synfig::Time &time);
 
 	static FrameStatus merge_status(FrameStatus a, FrameStatus b);
@@ -33,7 +33,12 @@
 #	include <config.h>
 #endif
 
+#include <set>
+
 #include <synfig/general.h>
+#include <synfig/layers/layer_pastecanvas.h>
+#include <synfig/valuenodes/valuenode_animatedinterface.h>
+#include <synfig/valuenodes/valuenode_const.h>
 
 #include "action.h"
 #include "instance.h"
@@ -168,6 +173,61 @@ using namespace Action;
 
 /* === P R O C E D U R E S ================================================= */
 
+namespace {
+	// shared nodes and layers are counted once
+	typedef std::set<const void*> VisitedSet;
+
+	size_t value_node_memory_usage(const ValueNode *value_node, VisitedSet &visited);
+
+	size_t
+	layer_memory_usage(const Layer *layer, VisitedSet &visited)
+	{
+		if (!layer || !visited.insert(layer).second)
+			return 0;
+
+		// layer object with its rendering state
+		size_t size = 1024;
+
+		Layer::ParamList params = layer->get_param_list();
+		for(Layer::ParamList::const_iterator i = params.begin(); i != params.end(); ++i)
+			size += i->first.size() + Action::Undoable::get_value_memory_usage(i->second);
+
+		const Layer::DynamicParamList &dynamic_params = layer->dynamic_param_list();
+		for(Layer::DynamicParamList::const_iterator i = dynamic_params.begin(); i != dynamic_params.end(); ++i)
+			size += value_node_memory_usage(i->second.get(), visited);
+
+		if (const Layer_PasteCanvas *paste_canvas = dynamic_cast<const Layer_PasteCanvas*>(layer)) {
+			Canvas::Handle canvas = paste_canvas->get_sub_canvas();
+			if (canvas && canvas->is_inline())
+				for(Canvas::const_iterator i = canvas->begin(); i != canvas->end(); ++i)
+					size += layer_memory_usage(i->get(), visited);
+		}
+		return size;
+	}
+
+	size_t
+	value_node_memory_usage(const ValueNode *value_node, VisitedSet &visited)
+	{
+		if (!value_node || !visited.insert(value_node).second)
+			return 0;
+
+		size_t size = 256;
+		if (const ValueNode_Const *const_node = dynamic_cast<const ValueNode_Const*>(value_node)) {
+			size += Action::Undoable::get_value_memory_usage(const_node->get_value());
+		} else
+		if (const ValueNode_AnimatedInterfaceConst *animated = dynamic_cast<const ValueNode_AnimatedInterfaceConst*>(value_node)) {
+			const WaypointList &waypoints = animated->waypoint_list();
+			for(WaypointList::const_iterator i = waypoints.begin(); i != waypoints.end(); ++i)
+				size += sizeof(Waypoint) + value_node_memory_usage(i->get_value_node().get(), visited);
+		} else
+		if (const LinkableValueNode *linkable = dynamic_cast<const LinkableValueNode*>(value_node)) {
+			for(int i = 0; i < linkable->link_count(); ++i)
+				size += value_node_memory_usage(linkable->get_link(i).get(), visited);
+		}
+		return size;
+	}
+}
+
 /* === S T A T I C S ======================================================= */
 
 synfigapp::Action::Book *book_;
@@ -548,6 +608,34 @@ Super::add_action_front(etl::handle<Undoable> action)
 		set_canvas(specific_action->get_canvas());
 }
 
+size_t
+Super::get_memory_usage()const
+{
+	size_t size = Undoable::get_memory_usage();
+	for(ActionList::const_iterator i = action_list_.begin(); i != action_list_.end(); ++i)
+		size += (*i)->get_memory_usage();
+	return size;
+}
+
+bool
+Super::is_action_list_mergeable(const Super &next)const
+{
+	if (action_list_.empty() || action_list_.size() != next.action_list_.size())
+		return false;
+	for(ActionList::const_iterator i = action_list_.begin(), j = next.action_list_.begin(); i != action_list_.end(); ++i, ++j)
+		if (!(*i)->is_mergeable(**j))
+			return false;
+	return true;
+}
+
+void
+Super::merge_action_list(const Super &next)
+{
+	assert(is_action_list_mergeable(next));
+	for(ActionList::const_iterator i = action_list_.begin(), j = next.action_list_.begin(); i != action_list_.end(); ++i, ++j)
+		(*i)->merge(**j);
+}
+
 
 Group::Group(const synfig::String &str):
 	name_(str),
@@ -641,6 +729,45 @@ Undoable::Undoable():
 	//DOO printf("%s:%d Undoable::Undoable() (we have %d)\n", __FILE__, __LINE__, ++undoable_count);
 }
 
+size_t
+Undoable::get_memory_usage()const
+{
+	// rough size of the action object with its parameters
+	return 256;
+}
+
+size_t
+Undoable::get_value_memory_usage(const synfig::ValueBase &value)
+{
+	size_t size = sizeof(synfig::ValueBase);
+	if (value.get_type() == synfig::type_list) {
+		const synfig::ValueBase::List &list = value.get_list();
+		for(synfig::ValueBase::List::const_iterator i = list.begin(); i != list.end(); ++i)
+			size += get_value_memory_usage(*i);
+	} else
+	if (value.get_type() == synfig::type_string) {
+		size += value.get(synfig::String()).size();
+	} else {
+		// value is allocated separately
+		size += 64;
+	}
+	return size;
+}
+
+size_t
+Undoable::get_layer_memory_usage(const synfig::Layer::Handle &layer)
+{
+	VisitedSet visited;
+	return layer_memory_usage(layer.get(), visited);
+}
+
+size_t
+Undoable::get_value_node_memory_usage(const synfig::ValueNode::Handle &value_node)
+{
+	VisitedSet visited;
+	return value_node_memory_usage(value_node.get(), visited);
+}
+
 #ifdef _DEBUG
 Undoable::~Undoable() {
 	//DOO printf("%s:%d Undoable::~Undoable() (we now have %d)\n", __FILE__, __LINE__, --undoable_count);
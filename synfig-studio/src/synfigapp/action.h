@@ -230,6 +230,25 @@ public:
 
 	bool is_active()const { return active_; }
 
+	//! Estimates memory retained by the action to be undone and redone
+	virtual size_t get_memory_usage()const;
+
+	//! Checks if \a next, performed right after this action, can be absorbed by merge()
+	virtual bool is_mergeable(const Undoable &/*next*/)const { return false; }
+
+	//! Absorbs \a next, so undo() restores the state before this action
+	//! and perform() sets the state after \a next
+	virtual void merge(const Undoable &/*next*/) { }
+
+	//! Estimates memory used by the value
+	static size_t get_value_memory_usage(const synfig::ValueBase &value);
+
+	//! Estimates memory used by the layer with its params, value nodes and inline canvas
+	static size_t get_layer_memory_usage(const synfig::Layer::Handle &layer);
+
+	//! Estimates memory used by the value node with all its links and waypoints
+	static size_t get_value_node_memory_usage(const synfig::ValueNode::Handle &value_node);
+
 #ifdef _DEBUG
 	virtual void ref() const noexcept;
 	virtual void unref()const;
@@ -318,6 +337,13 @@ public:
 	virtual void perform();
 	virtual void undo();
 
+	virtual size_t get_memory_usage()const;
+
+protected:
+	//! Checks if each of the sub-actions can absorb the corresponding sub-action of \a next
+	bool is_action_list_mergeable(const Super &next)const;
+	void merge_action_list(const Super &next);
+
 }; // END of class Action::Super
 
 
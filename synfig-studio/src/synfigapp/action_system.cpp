@@ -32,6 +32,10 @@
 #	include <config.h>
 #endif
 
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
 #include <synfig/general.h>
 
 #include "action_system.h"
@@ -49,6 +53,12 @@ using namespace synfigapp;
 
 /* === M A C R O S ========================================================= */
 
+// history is not trimmed unless a limit is set by SYNFIG_HISTORY_MEMORY_LIMIT (in MB)
+#define HISTORY_MEMORY_BUDGET_DEFAULT_MB 0
+
+// changes of the same value are merged only if they follow each other within this interval
+#define ACTION_MERGE_INTERVAL_MS 1000
+
 /* === G L O B A L S ======================================================= */
 
 /* === P R O C E D U R E S ================================================= */
@@ -67,10 +77,14 @@ namespace {
 
 
 Action::System::System():
-	action_count_(0)
+	action_count_(0),
+	memory_budget_((size_t)HISTORY_MEMORY_BUDGET_DEFAULT_MB*1024*1024),
+	memory_usage_(0)
 {
 	unset_ui_interface();
 	clear_redo_stack_on_new_action_=false;
+	if (const char *s = getenv("SYNFIG_HISTORY_MEMORY_LIMIT"))
+		memory_budget_ = (size_t)std::max(0, atoi(s))*1024*1024;
 }
 
 Action::System::~System()
@@ -82,6 +96,7 @@ Action::System::request_redraw(etl::handle<CanvasInterface> x)
 	if (!x) return;
 	if (!group_stack_.empty())
 		{ group_stack_.front()->request_redraw(x); return; }
+	Node::ChangeBatch::flush();
 	x->signal_dirty_preview()();
 }
 
@@ -107,6 +122,8 @@ Action::System::perform_action(etl::handle<Action::Base> action)
 	Action::CanvasSpecific *canvas_specific = dynamic_cast<Action::CanvasSpecific*>(action.get());
 
 	DirtySignalBlocker dirtyBlocker(canvas_specific);
+	// all sub-actions of the action are notified as one change
+	Node::ChangeBatch change_batch;
 
 	if (canvas_specific && canvas_specific->get_canvas())
 		uim = static_cast<Instance*>(this)->find_canvas_interface(canvas_specific->get_canvas())->get_ui_interface();
@@ -161,29 +178,108 @@ Action::System::perform_action(etl::handle<Action::Base> action)
 	if (clear_redo_stack_on_new_action_)
 		clear_redo_stack();
 
+	// Consecutive changes of the same value are kept as one action
+	bool merged = undoable_action && group_stack_.empty() && merge_action(undoable_action);
+	if (group_stack_.empty())
+		last_action_time_ = std::chrono::steady_clock::now();
+
 	if (!group_stack_.empty())
 		group_stack_.front()->inc_depth();
 	else
+	if (!merged)
 		inc_action_count();
 
 	// Push this action onto the action list if we can undo it
-	if (undoable_action) {
+	if (undoable_action && !merged) {
 		// If necessary, signal the change in status of undo
 		if(undo_action_stack_.empty()) signal_undo_status_(true);
 
 		// Add it to the list
 		undo_action_stack_.push_front(undoable_action);
+		add_memory_usage(undoable_action);
 
 		// Signal that a new action has been added
 		if(group_stack_.empty())
 			signal_new_action()(undoable_action);
 	}
 
+	if (group_stack_.empty())
+		trim_undo_stack();
+
 	uim->task(action->get_local_name()+' '+_("Successful"));
 
 	return true;
 }
 
+bool
+Action::System::merge_action(const etl::handle<Action::Undoable> &action)
+{
+	// the previous action must be the last one, performed after the document was saved
+	if (undo_action_stack_.empty() || !redo_action_stack_.empty() || action_count_ <= 0)
+		return false;
+
+	// separate edits of the same value stay separate steps
+	if (std::chrono::steady_clock::now() - last_action_time_ > std::chrono::milliseconds(ACTION_MERGE_INTERVAL_MS))
+		return false;
+
+	etl::handle<Action::Undoable> last = undo_action_stack_.front();
+	if (!last->is_active() || !action->is_active() || !last->is_mergeable(*action))
+		return false;
+
+	release_memory_usage(last);
+	last->merge(*action);
+	add_memory_usage(last);
+	signal_action_merged_(last);
+	return true;
+}
+
+void
+Action::System::trim_undo_stack()
+{
+	if (!memory_budget_)
+		return;
+
+	int count = 0;
+	while(memory_usage_ > memory_budget_ && undo_action_stack_.size() > 1) {
+		release_memory_usage(undo_action_stack_.back());
+		undo_action_stack_.pop_back();
+		++count;
+	}
+
+	if (count) {
+		signal_undo_stack_trimmed_(count);
+		get_ui_interface()->task(strprintf(
+			_("History exceeds %d MB, %d oldest actions are removed"),
+			(int)(memory_budget_/(1024*1024)), count ));
+	}
+}
+
+void
+Action::System::add_memory_usage(const etl::handle<Action::Undoable> &action)
+{
+	size_t size = action->get_memory_usage();
+	action_memory_usage_[action.get()] = size;
+	memory_usage_ += size;
+}
+
+void
+Action::System::release_memory_usage(const etl::handle<Action::Undoable> &action)
+{
+	std::map<const Action::Undoable*, size_t>::iterator i = action_memory_usage_.find(action.get());
+	if (i == action_memory_usage_.end())
+		return;
+	memory_usage_ -= std::min(memory_usage_, i->second);
+	action_memory_usage_.erase(i);
+}
+
+void
+Action::System::set_memory_budget(size_t x)
+{
+	memory_budget_ = x;
+	if (group_stack_.empty())
+		trim_undo_stack();
+}
+
 bool
 synfigapp::Action::System::undo_(etl::handle<UIInterface> uim)
 {
@@ -234,10 +330,14 @@ synfigapp::Action::System::undo()
 	if (undo_action_stack().empty())
 		return false;
 
+	// the next action is never merged into the undone or an older one
+	last_action_time_ = std::chrono::steady_clock::time_point();
+
 	etl::handle<Action::Undoable> action = undo_action_stack().front();
 	Action::CanvasSpecific *canvas_specific = dynamic_cast<Action::CanvasSpecific*>(action.get());
 
 	DirtySignalBlocker dirtyBlocker(canvas_specific);
+	Node::ChangeBatch change_batch;
 
 	etl::handle<UIInterface> uim = get_ui_interface();
 	if (canvas_specific && canvas_specific->get_canvas())
@@ -301,10 +401,14 @@ Action::System::redo()
 	if (redo_action_stack_.empty())
 		return false;
 
+	// the next action is never merged into the redone one
+	last_action_time_ = std::chrono::steady_clock::time_point();
+
 	etl::handle<Action::Undoable> action = redo_action_stack().front();
 	Action::CanvasSpecific *canvas_specific = dynamic_cast<Action::CanvasSpecific*>(action.get());
 
 	DirtySignalBlocker dirtyBlocker(canvas_specific);
+	Node::ChangeBatch change_batch;
 
 	etl::handle<UIInterface> uim = get_ui_interface();
 	if (canvas_specific && canvas_specific->get_canvas())
@@ -351,6 +455,8 @@ void
 Action::System::clear_undo_stack()
 {
 	if (undo_action_stack_.empty()) return;
+	for(Stack::const_iterator i = undo_action_stack_.begin(); i != undo_action_stack_.end(); ++i)
+		release_memory_usage(*i);
 	undo_action_stack_.clear();
 	signal_undo_status_(false);
 	signal_undo_stack_cleared_();
@@ -360,6 +466,8 @@ void
 Action::System::clear_redo_stack()
 {
 	if (redo_action_stack_.empty()) return;
+	for(Stack::const_iterator i = redo_action_stack_.begin(); i != redo_action_stack_.end(); ++i)
+		release_memory_usage(*i);
 	redo_action_stack_.clear();
 	signal_redo_status_(false);
 	signal_redo_stack_cleared_();
@@ -479,11 +587,13 @@ Action::PassiveGrouper::finish()
 			group->add_action_front(action);
 
 			// Remove the action from the undo stack
+			instance_->release_memory_usage(action);
 			instance_->undo_action_stack_.pop_front();
 		}
 
 		// Push the group onto the stack
 		instance_->undo_action_stack_.push_front(group);
+		instance_->add_memory_usage(group);
 
 		if(group->is_dirty())
 			request_redraw(group->get_canvas_interface());
@@ -500,6 +610,9 @@ Action::PassiveGrouper::finish()
 		instance_->request_redraw(*i);
 	redraw_set_.clear();
 
+	if (instance_->group_stack_.empty())
+		instance_->trim_undo_stack();
+
 	return group;
 }
 
@@ -547,8 +660,11 @@ Action::System::DirtySignalBlocker::~DirtySignalBlocker()
 		{
 			canvas_interface->signal_dirty_preview().unblock();
 
-			if (canvas_specific_->is_dirty())
+			if (canvas_specific_->is_dirty()) {
+				// preview must not see the state before postponed notifications
+				Node::ChangeBatch::flush();
 				canvas_interface->signal_dirty_preview()();
+			}
 		}
 	}
 }
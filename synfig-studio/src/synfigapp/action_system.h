@@ -30,6 +30,8 @@
 
 /* === H E A D E R S ======================================================= */
 
+#include <chrono>
+#include <map>
 #include <set>
 
 #include <sigc++/sigc++.h>
@@ -142,6 +144,8 @@ private:
 	sigc::signal<void> signal_undo_;
 	sigc::signal<void> signal_redo_;
 	sigc::signal<void,etl::handle<Action::Undoable> > signal_action_status_changed_;
+	sigc::signal<void,etl::handle<Action::Undoable> > signal_action_merged_;
+	sigc::signal<void,int> signal_undo_stack_trimmed_;
 
 	mutable sigc::signal<void,bool> signal_unsaved_status_changed_;
 
@@ -152,6 +156,19 @@ private:
 
 	bool clear_redo_stack_on_new_action_;
 
+	//! Oldest actions are removed from the undo stack when history uses more memory, zero means no limit
+	size_t memory_budget_;
+
+	//! When the last action was performed outside of groups, only quick successors are merged into it
+	std::chrono::steady_clock::time_point last_action_time_;
+
+	//! Memory used by undo and redo stacks, updated when actions are added and removed
+	size_t memory_usage_;
+
+	//! Estimates of actions in the stacks at the time they were added,
+	//! the same amounts are subtracted when actions are removed
+	std::map<const Action::Undoable*, size_t> action_memory_usage_;
+
 	/*
  -- ** -- P R I V A T E   M E T H O D S ---------------------------------------
 	*/
@@ -161,6 +178,19 @@ private:
 	bool undo_(etl::handle<UIInterface> uim);
 	bool redo_(etl::handle<UIInterface> uim);
 
+	//! Merges \a action into the last performed one, if both change the same value
+	//! and \a action follows it within a short interval
+	bool merge_action(const etl::handle<Action::Undoable> &action);
+
+	//! Removes the oldest actions, until history fits into the memory budget
+	void trim_undo_stack();
+
+	//! Adds the memory of \a action added to the history
+	void add_memory_usage(const etl::handle<Action::Undoable> &action);
+
+	//! Subtracts the memory of \a action removed from the history
+	void release_memory_usage(const etl::handle<Action::Undoable> &action);
+
 	/*
  -- ** -- S I G N A L   T E R M I N A L S -------------------------------------
 	*/
@@ -213,6 +243,13 @@ public:
 	//! Clears the redo stack.
 	void clear_redo_stack();
 
+	//! Estimates memory used by undo and redo stacks
+	size_t get_memory_usage()const { return memory_usage_; }
+
+	size_t get_memory_budget()const { return memory_budget_; }
+
+	void set_memory_budget(size_t x);
+
 	//! Increments the action counter
 	/*! \note You should not have to call this under normal circumstances.
 	**	\see dec_action_count(), reset_action_count(), get_action_count() */
@@ -261,6 +298,12 @@ public:
 
 	sigc::signal<void,etl::handle<Action::Undoable> >& signal_action_status_changed() { return signal_action_status_changed_; }
 
+	//!	Called when a new action is merged into the given last action instead of being added to the stack.
+	sigc::signal<void,etl::handle<Action::Undoable> >& signal_action_merged() { return signal_action_merged_; }
+
+	//!	Called when the given number of oldest actions are removed from the undo stack to save memory.
+	sigc::signal<void,int>& signal_undo_stack_trimmed() { return signal_undo_stack_trimmed_; }
+
 }; // END of class Action::System
 
 
@@ -165,3 +165,9 @@ Action::LayerAdd::undo()
 	}
 	else synfig::warning("CanvasInterface not set on action");
 }
+
+size_t
+Action::LayerAdd::get_memory_usage()const
+{
+	return Undoable::get_memory_usage() + get_layer_memory_usage(layer);
+}
@@ -190,3 +190,9 @@ Action::LayerParamConnect::undo()
 		//if(old_value_node)get_canvas_interface()->signal_value_node_changed()(old_value_node);
 	}
 }
+
+size_t
+Action::LayerParamConnect::get_memory_usage()const
+{
+	return Undoable::get_memory_usage() + get_value_node_memory_usage(old_value_node);
+}
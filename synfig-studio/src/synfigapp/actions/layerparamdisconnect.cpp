@@ -179,3 +179,11 @@ Action::LayerParamDisconnect::undo()
 		get_canvas_interface()->signal_layer_param_changed()(layer,param_name);
 	}
 }
+
+size_t
+Action::LayerParamDisconnect::get_memory_usage()const
+{
+	return Undoable::get_memory_usage()
+		 + get_value_node_memory_usage(old_value_node)
+		 + get_value_node_memory_usage(new_value_node);
+}
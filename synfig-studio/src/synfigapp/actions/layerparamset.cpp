@@ -176,3 +176,26 @@ Action::LayerParamSet::undo()
 		get_canvas_interface()->signal_layer_param_changed()(layer,param_name);
 	}
 }
+
+size_t
+Action::LayerParamSet::get_memory_usage()const
+{
+	return Undoable::get_memory_usage()
+		 + get_value_memory_usage(new_value)
+		 + get_value_memory_usage(old_value);
+}
+
+bool
+Action::LayerParamSet::is_mergeable(const Undoable &next)const
+{
+	const LayerParamSet *other = dynamic_cast<const LayerParamSet*>(&next);
+	return other && layer == other->layer && param_name == other->param_name;
+}
+
+void
+Action::LayerParamSet::merge(const Undoable &next)
+{
+	const LayerParamSet *other = dynamic_cast<const LayerParamSet*>(&next);
+	assert(other);
+	new_value = other->new_value;
+}
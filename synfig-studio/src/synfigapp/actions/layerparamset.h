@@ -70,6 +70,10 @@ public:
 	virtual void perform();
 	virtual void undo();
 
+	virtual size_t get_memory_usage()const;
+	virtual bool is_mergeable(const Undoable &next)const;
+	virtual void merge(const Undoable &next);
+
 	ACTION_MODULE_EXT
 };
 
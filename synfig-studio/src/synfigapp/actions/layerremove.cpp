@@ -233,3 +233,12 @@ Action::LayerRemove::undo()
 			get_canvas_interface()->signal_layer_inserted()(layer,depth);
 	}
 }
+
+size_t
+Action::LayerRemove::get_memory_usage()const
+{
+	size_t size = Undoable::get_memory_usage();
+	for (const auto& tuple : layer_list)
+		size += get_layer_memory_usage(std::get<0>(tuple));
+	return size;
+}
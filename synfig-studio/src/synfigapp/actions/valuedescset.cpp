@@ -999,3 +999,31 @@ void ValueDescSet::add_action_valuedescset(const ValueBase& value, const ValueDe
 		throw Error(Error::TYPE_NOTREADY);
 	add_action(action);
 }
+
+size_t
+Action::ValueDescSet::get_memory_usage()const
+{
+	return Super::get_memory_usage() + get_value_memory_usage(value);
+}
+
+bool
+Action::ValueDescSet::is_mergeable(const Undoable &next)const
+{
+	const ValueDescSet *other = dynamic_cast<const ValueDescSet*>(&next);
+	return other
+		&& value_desc == other->value_desc
+		&& time == other->time
+		&& recursive == other->recursive
+		&& animate == other->animate
+		&& lock_animation == other->lock_animation
+		&& is_action_list_mergeable(*other);
+}
+
+void
+Action::ValueDescSet::merge(const Undoable &next)
+{
+	const ValueDescSet *other = dynamic_cast<const ValueDescSet*>(&next);
+	assert(other);
+	value = other->value;
+	merge_action_list(*other);
+}
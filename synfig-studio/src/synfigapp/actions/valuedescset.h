@@ -73,6 +73,10 @@ public:
 
 	virtual void prepare();
 
+	virtual size_t get_memory_usage()const;
+	virtual bool is_mergeable(const Undoable &next)const;
+	virtual void merge(const Undoable &next);
+
 	ACTION_MODULE_EXT
 };
 
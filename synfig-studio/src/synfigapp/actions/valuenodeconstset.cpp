@@ -153,3 +153,26 @@ Action::ValueNodeConstSet::undo()
 		get_canvas_interface()->signal_value_node_changed()(value_node);
 	}*/
 }
+
+size_t
+Action::ValueNodeConstSet::get_memory_usage()const
+{
+	return Undoable::get_memory_usage()
+		 + get_value_memory_usage(new_value)
+		 + get_value_memory_usage(old_value);
+}
+
+bool
+Action::ValueNodeConstSet::is_mergeable(const Undoable &next)const
+{
+	const ValueNodeConstSet *other = dynamic_cast<const ValueNodeConstSet*>(&next);
+	return other && value_node == other->value_node;
+}
+
+void
+Action::ValueNodeConstSet::merge(const Undoable &next)
+{
+	const ValueNodeConstSet *other = dynamic_cast<const ValueNodeConstSet*>(&next);
+	assert(other);
+	new_value = other->new_value;
+}
@@ -162,3 +162,9 @@ Action::ValueNodeLinkConnect::undo()
 		get_canvas_interface()->signal_value_node_changed()(parent_value_node);
 	}*/
 }
+
+size_t
+Action::ValueNodeLinkConnect::get_memory_usage()const
+{
+	return Undoable::get_memory_usage() + get_value_node_memory_usage(old_value_node);
+}
@@ -186,3 +186,9 @@ Action::ValueNodeRemove::undo()
 	}
 */
 }
+
+size_t
+Action::ValueNodeRemove::get_memory_usage()const
+{
+	return Undoable::get_memory_usage() + get_value_node_memory_usage(value_node);
+}
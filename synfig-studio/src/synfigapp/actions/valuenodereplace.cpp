@@ -227,3 +227,9 @@ Action::ValueNodeReplace::undo()
 	else synfig::warning("CanvasInterface not set on action");
 
 }
+
+size_t
+Action::ValueNodeReplace::get_memory_usage()const
+{
+	return Undoable::get_memory_usage() + get_value_node_memory_usage(dest_value_node);
+}
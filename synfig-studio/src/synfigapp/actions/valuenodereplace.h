@@ -68,6 +68,8 @@ public:
 	virtual void perform();
 	virtual void undo();
 
+	virtual size_t get_memory_usage()const;
+
 	ACTION_MODULE_EXT
 };
 
@@ -851,7 +851,7 @@ CanvasInterface::import(
 	}
 
 	// If this is a SIF file, then we need to do things slightly differently
-	if (ext=="sif" || ext=="sifz")try
+	if (ext=="sif" || ext=="sifz" || ext=="sifb")try
 	{
 		FileSystem::Handle file_system = CanvasFileNaming::make_filesystem(full_filename);
 		if(!file_system)
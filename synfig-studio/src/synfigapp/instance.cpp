@@ -131,12 +131,18 @@ synfigapp::find_instance(Canvas::Handle canvas)
 
 Instance::Instance(Canvas::Handle canvas, synfig::FileSystem::Handle container):
 	canvas_(canvas),
-	container_(container)
+	container_(container),
+	changes_since_backup_(0)
 {
 	assert(canvas->is_root());
 
 	unset_selection_manager();
 
+	signal_new_action().connect(sigc::hide([this]() { ++changes_since_backup_; }));
+	signal_undo().connect([this]() { ++changes_since_backup_; });
+	signal_redo().connect([this]() { ++changes_since_backup_; });
+	signal_action_status_changed().connect(sigc::hide([this]() { ++changes_since_backup_; }));
+
 	instance_map_[canvas]=this;
 } // END of synfigapp::Instance::Instance()
 
@@ -568,9 +574,35 @@ Instance::save_all_layers()
 }
 
 bool
-Instance::backup(bool save_even_if_unchanged)
+Instance::BackupJob::write()
 {
-	if (!get_action_count() && !save_even_if_unchanged)
+	std::lock_guard<std::mutex> lock(mutex);
+	if (stream)
+	{
+		written = document && (binary
+			? write_canvas_document_binary(stream, *document)
+			: write_canvas_document(stream, *document, compress, true));
+		// close stream
+		stream.reset();
+		document.reset();
+	}
+	return written;
+}
+
+void
+Instance::flush_backup_job()
+{
+	if (BackupJob::Handle job = backup_job_.lock())
+		job->write();
+	backup_job_.reset();
+}
+
+bool
+Instance::prepare_backup(BackupJob::Handle &out_job, bool save_even_if_unchanged)
+{
+	out_job.reset();
+	flush_backup_job();
+	if (!save_even_if_unchanged && (!get_action_count() || !changes_since_backup_))
 		return true;
 	FileSystemTemporary::Handle temporary_filesystem = FileSystemTemporary::Handle::cast_dynamic(get_canvas()->get_file_system());
 
@@ -579,13 +611,54 @@ Instance::backup(bool save_even_if_unchanged)
 		warning("Cannot backup, canvas was not attached to temporary file system: %s", get_file_name().c_str());
 		return false;
 	}
+
+	const FileSystem::Identifier identifier = get_canvas()->get_identifier();
+
+	BackupJob::Handle job = std::make_shared<BackupJob>();
+	job->temporary_filesystem = temporary_filesystem;
+	job->compress = identifier.filename.extension().u8string() == ".sifz";
+	job->binary = identifier.filename.extension().u8string() == ".sifb";
 	// don't save images while backup
-	//if (success)
-	//	save_all_layers();
-	if (!save_canvas(get_canvas()->get_identifier(), get_canvas(), false))
+	job->document = encode_canvas_document(get_canvas());
+	if (!job->document)
+		return false;
+	// file system is not thread-safe, so stream is opened here
+	job->stream = identifier.file_system->get_write_stream(identifier.filename.u8string());
+	if (!job->stream)
+	{
+		warning("Cannot backup, unable to open file for write: %s", identifier.filename.u8_str());
 		return false;
-	
-	return temporary_filesystem->save_temporary();
+	}
+
+	// changes made while job is written will go to the next backup
+	changes_since_backup_ = 0;
+	backup_job_ = job;
+	out_job = job;
+	return true;
+}
+
+bool
+Instance::finish_backup(const BackupJob &job)
+{
+	if (!job.written)
+	{
+		// try again on next backup
+		++changes_since_backup_;
+		return false;
+	}
+	return job.temporary_filesystem->save_temporary();
+}
+
+bool
+Instance::backup(bool save_even_if_unchanged)
+{
+	BackupJob::Handle job;
+	if (!prepare_backup(job, save_even_if_unchanged))
+		return false;
+	if (!job)
+		return true;
+	job->write();
+	return finish_backup(*job);
 }
 
 bool
@@ -593,6 +666,8 @@ Instance::save_as(const synfig::String &file_name)
 {
 	Canvas::Handle canvas = get_canvas();
 
+	flush_backup_job();
+
 	FileSystem::Identifier previous_canvas_identifier = canvas->get_identifier();
 	FileSystem::Handle previous_canvas_filesystem = previous_canvas_identifier.file_system;
 	FileSystem::Handle previous_container = get_container();
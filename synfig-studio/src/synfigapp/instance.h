@@ -31,12 +31,16 @@
 /* === H E A D E R S ======================================================= */
 
 #include <list>
+#include <memory>
+#include <mutex>
 #include <set>
 
 #include <ETL/handle>
 
 #include <synfig/canvas.h>
+#include <synfig/filesystemtemporary.h>
 #include <synfig/rendering/surface.h>
+#include <synfig/savecanvas.h>
 #include <synfig/string.h>
 
 #include "action.h"
@@ -75,6 +79,27 @@ public:
 
 	typedef std::list< FileReference > FileReferenceList;
 
+	//! Snapshot of the canvas made by prepare_backup()
+	/*! Writing it is the expensive part of a backup, and it
+	    may be done by write() from any thread. */
+	struct BackupJob
+	{
+		typedef std::shared_ptr<BackupJob> Handle;
+
+		std::shared_ptr<xmlpp::Document> document;
+		synfig::FileSystem::WriteStream::Handle stream;
+		synfig::FileSystemTemporary::Handle temporary_filesystem;
+		bool compress;
+		bool binary;
+		bool written;
+		std::mutex mutex;
+
+		BackupJob(): compress(), binary(), written() { }
+
+		//! Writes the document and closes the stream, does nothing if it's already written
+		bool write();
+	};
+
 	using etl::shared_object::ref;
 	using etl::shared_object::unref;
 
@@ -103,6 +128,14 @@ private:
 
 	std::list< synfig::Layer::Handle > layers_to_save;
 
+	//! Count of actions done, undone or redone since last backup
+	int changes_since_backup_;
+	//! Backup which may be not written yet
+	std::weak_ptr<BackupJob> backup_job_;
+
+	//! Writes pending backup job (if any) so it can't overwrite newer files later
+	void flush_backup_job();
+
 	bool import_external_canvas(synfig::Canvas::Handle canvas, std::map<synfig::Canvas*, synfig::Canvas::Handle> &imported);
 	etl::handle<Action::Group> import_external_canvases();
 
@@ -178,6 +211,14 @@ public:
 	//! Saves the instance to current temporary container
 	bool backup(bool save_even_if_unchanged = false);
 
+	//! Takes a snapshot of canvas for backup, must be called from the main thread
+	/*! \param out_job is set to null when canvas wasn't changed since previous backup
+	    \return \c false on error */
+	bool prepare_backup(BackupJob::Handle &out_job, bool save_even_if_unchanged = false);
+
+	//! Commits the backup after job was written, must be called from the main thread
+	bool finish_backup(const BackupJob &job);
+
 	//! generate layer name (also known in code as 'description')
 	synfig::String generate_new_description(const synfig::Layer::Handle &layer);
 
@@ -102,6 +102,26 @@ void synfigapp::timepoints_ref::insert(synfigapp::ValueDesc v, synfig::Activepoi
 	}
 }
 
+bool synfigapp::check_intersect(const synfig::Node::time_set &tset, const std::set<Time> &tlist,
+								synfig::Time time_offset, synfig::Real time_dilation)
+{
+	if(tset.empty() || tlist.empty())
+		return false;
+
+	// a few selected times are usually checked against all time points of a canvas
+	if(tset.size() < tlist.size())
+		return check_intersect(tset.begin(),tset.end(),tlist.begin(),tlist.end(),time_offset,time_dilation);
+
+	for(std::set<Time>::const_iterator i = tlist.begin(); i != tlist.end(); ++i)
+	{
+		const Time t = *i * time_dilation + time_offset;
+		synfig::Node::time_set::const_iterator j = tset.lower_bound(TimePoint(t));
+		if(j != tset.end() && !(t < *j))
+			return true;
+	}
+	return false;
+}
+
 //recursion functions
 void synfigapp::recurse_canvas(synfig::Canvas::Handle h, const std::set<Time> &tlist,
 								timepoints_ref &vals, synfig::Time time_offset, synfig::Real time_dilation)
@@ -115,7 +135,7 @@ void synfigapp::recurse_canvas(synfig::Canvas::Handle h, const std::set<Time> &t
 	for(; i != end; ++i)
 	{
 		const Node::time_set &tset = (*i)->get_times();
-		if(check_intersect(tset.begin(),tset.end(),tlist.begin(),tlist.end(),time_offset,time_dilation))
+		if(check_intersect(tset,tlist,time_offset,time_dilation))
 		{
 			recurse_layer(*i,tlist,vals,time_offset,time_dilation);
 		}
@@ -140,7 +160,7 @@ void synfigapp::recurse_layer(synfig::Layer::Handle h, const std::set<Time> &tli
 		synfig::Time subcanvas_time_offset(time_offset * subcanvas_time_dilation + p->get_time_offset());
 		subcanvas_time_dilation *= time_dilation;
 
-		if(check_intersect(tset.begin(),tset.end(),tlist.begin(),tlist.end(),subcanvas_time_offset,subcanvas_time_dilation))
+		if(check_intersect(tset,tlist,subcanvas_time_offset,subcanvas_time_dilation))
 			recurse_canvas(p->get_sub_canvas(),tlist,vals,subcanvas_time_offset,subcanvas_time_dilation);
 	}
 
@@ -152,7 +172,7 @@ void synfigapp::recurse_layer(synfig::Layer::Handle h, const std::set<Time> &tli
 	{
 		const synfig::Node::time_set &tset = i->second->get_times();
 
-		if(check_intersect(tset.begin(),tset.end(),tlist.begin(),tlist.end(),time_offset,time_dilation))
+		if(check_intersect(tset,tlist,time_offset,time_dilation))
 		{
 			recurse_valuedesc(ValueDesc(h,i->first),tlist,vals,time_offset,time_dilation);
 		}
@@ -279,7 +299,7 @@ void synfigapp::recurse_valuedesc(synfigapp::ValueDesc h, const std::set<Time> &
 			{
 				const Node::time_set &tset = i->get_times();
 
-				if(check_intersect(tset.begin(),tset.end(),tlist.begin(),tlist.end(),time_offset,time_dilation))
+				if(check_intersect(tset,tlist,time_offset,time_dilation))
 				{
 					recurse_valuedesc(ValueDesc(p,index),tlist,vals,time_offset,time_dilation);
 				}
@@ -302,7 +322,7 @@ void synfigapp::recurse_valuedesc(synfigapp::ValueDesc h, const std::set<Time> &
 				ValueNode::Handle v = p->get_link(i);
 				const Node::time_set &tset = v->get_times();
 
-				if(check_intersect(tset.begin(),tset.end(),tlist.begin(),tlist.end(),time_offset,time_dilation))
+				if(check_intersect(tset,tlist,time_offset,time_dilation))
 				{
 					recurse_valuedesc(ValueDesc(p,i),tlist,vals,time_offset,time_dilation);
 				}
@@ -122,6 +122,11 @@ bool check_intersect(I1 b1, I1 end1, I2 b2, I2 end2, synfig::Time time_offset =
 	return false;
 }
 
+//checks the intersection of the time point set with the times, looking up each of them
+//in the (usually much bigger) set instead of walking through the whole set
+bool check_intersect(const synfig::Node::time_set &tset, const std::set<synfig::Time> &tlist,
+						synfig::Time time_offset = 0, synfig::Real time_dilation = 1);
+
 //gets the closest time inside the set
 bool get_closest_time(const synfig::Node::time_set &tset, const synfig::Time &t,
 						const synfig::Time &range, synfig::Time &out);
@@ -0,0 +1,103 @@
+/*!	\file test/layerregion.cpp
+**	\brief Tests for the regions of the work area touched by layers
+**
+**	\legal
+**	Copyright (c) 2022 Synfig contributors
+**
+**	This file is part of Synfig.
+**
+**	Synfig is free software: you can redistribute it and/or modify
+**	it under the terms of the GNU General Public License as published by
+**	the Free Software Foundation, either version 2 of the License, or
+**	(at your option) any later version.
+**
+**	Synfig is distributed in the hope that it will be useful,
+**	but WITHOUT ANY WARRANTY; without even the implied warranty of
+**	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**	GNU General Public License for more details.
+**
+**	You should have received a copy of the GNU General Public License
+**	along with Synfig.  If not, see <https://www.gnu.org/licenses/>.
+**	\endlegal
+*/
+
+#include "test_base.h"
+
+#include <synfig/canvas.h>
+#include <synfig/filesystem_path.h>
+#include <synfig/transformation.h>
+
+#include <synfigapp/main.h>
+
+#include <gui/workarearenderer/layerregion.h>
+
+// Unit square polygon inside of a new group of \a type in the root canvas
+static synfig::Layer::Handle
+create_group_with_square(const synfig::Canvas::Handle &canvas, const char *type)
+{
+	synfig::Layer::Handle group = synfig::Layer::create(type);
+	synfig::Canvas::Handle sub_canvas = synfig::Canvas::create_inline(canvas);
+	group->set_param("canvas", sub_canvas);
+	canvas->push_back(group);
+
+	synfig::Layer::Handle polygon = synfig::Layer::create("polygon");
+	synfig::ValueBase::List points;
+	points.push_back(synfig::Point(0.0, 0.0));
+	points.push_back(synfig::Point(1.0, 0.0));
+	points.push_back(synfig::Point(1.0, 1.0));
+	points.push_back(synfig::Point(0.0, 1.0));
+	polygon->set_param("vector_list", points);
+	sub_canvas->push_back(polygon);
+	return group;
+}
+
+static void test_layer_region_of_layer_inside_group()
+{
+	synfig::Canvas::Handle canvas = synfig::Canvas::create();
+	synfig::Layer::Handle group = create_group_with_square(canvas, "group");
+	const synfig::ContextParams context_params;
+
+	// shapes add a small margin to their bounds
+	synfig::Rect region = studio::get_layer_region(*group, context_params);
+	ASSERT(studio::is_finite_rect(region))
+	ASSERT(region.minx <= 0.0 && region.minx > -0.1)
+	ASSERT(region.maxx >= 1.0 && region.maxx < 1.1)
+	ASSERT(region.miny <= 0.0 && region.miny > -0.1)
+	ASSERT(region.maxy >= 1.0 && region.maxy < 1.1)
+	ASSERT(studio::is_local_layer(*group, region))
+
+	// the region follows the transformation of the group
+	group->set_param("transformation", synfig::Transformation(synfig::Vector(2.0, 0.0)));
+	region = studio::get_layer_region(*group, context_params);
+	ASSERT(region.minx <= 2.0 && region.minx > 1.9)
+	ASSERT(region.maxx >= 3.0 && region.maxx < 3.1)
+	ASSERT(studio::is_local_layer(*group, region))
+}
+
+static void test_layer_region_of_filter_group_is_not_local()
+{
+	synfig::Canvas::Handle canvas = synfig::Canvas::create();
+	synfig::Layer::Handle filter_group = create_group_with_square(canvas, "filter_group");
+
+	synfig::Rect region = studio::get_layer_region(*filter_group, synfig::ContextParams());
+	ASSERT_FALSE(studio::is_local_layer(*filter_group, region))
+}
+
+int main(int argc, const char* argv[])
+{
+// test binaries are in `bin/test` folder, but for Windows they should be in `bin`
+// folder, because there is no RPATH on Windows, and it can't find required dll's
+#ifdef _WIN32
+	const std::string root_path = synfig::filesystem::Path::absolute_path(std::string(argv[0]) + "/../../");
+#else
+	const std::string root_path = synfig::filesystem::Path::absolute_path(std::string(argv[0]) + "/../../../");
+#endif
+	synfigapp::Main Main(root_path);
+
+	TEST_SUITE_BEGIN()
+		TEST_FUNCTION(test_layer_region_of_layer_inside_group)
+		TEST_FUNCTION(test_layer_region_of_filter_group_is_not_local)
+	TEST_SUITE_END();
+
+	return tst_exit_status;
+}